@@ -1,1247 +1,4636 @@
-//------------ Includes -----------------------------------------------------------------
-#include "esp_functions.h"
-
-#if defined(ARDUINO_ARCH_ESP8266)
-	#include <LittleFS.h>
-	#include <ESP8266WiFi.h>
-	#include <ESP8266HTTPClient.h>
-	#include <WiFiClient.h>
-#elif defined(ARDUINO_ARCH_ESP32)
-	#include <SPIFFS.h>
-	#include <HTTPClient.h>
-	#include <Update.h>
-	#include <esp_wifi.h>
-	#include <rom/rtc.h>
-	#include <esp_task_wdt.h>
-#endif
-
-//-------------------------------------------------------------------------------
-namespace esp {
-	//-------------------------------------------------------------------------------
-	Flags flags;
-	int8_t countNetworks;
-	const char* pageTop = nullptr;
-	const char* pageEndTop = nullptr;
-	const char* pageBottom = nullptr;
-	char* pageBuff = nullptr;
-	char tmpVal[ 11 ];
-	char systemLogin[ 16 ];
-	char systemPassword[ 16 ];
-	char updateKey[ 32 ];
-	char hostName[ 32 ];
-	uint8_t firstVersion;
-	uint8_t secondVersion;
-	uint16_t thridVersion;
-	int rtc_offset;
-	Data app;
-	File updateFile;
-	uint16_t can_speed;
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	uint8_t checkWebAuth(ESP8266WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess)
-#elif defined(ARDUINO_ARCH_ESP32)
-	uint8_t checkWebAuth(WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess)
-#endif
-	{
-		delay( 1000 );
-
-		if( !webServer->authenticate( user, password ) ){
-			webServer->requestAuthentication( DIGEST_AUTH, realm, failMess );
-			return 0;
-		}
-
-		return 1;
-	}
-
-	//-------------------------------------------------------------------------------
-	void removeFile(const char* file)
-	{
-		if( !esp::flags.useFS ) return;
-		if( esp::isFileExists( file ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-			LittleFS.remove( file );
-#elif defined(ARDUINO_ARCH_ESP32)
-			SPIFFS.remove( file );
-#endif
-		}
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void setWebRedirect(ESP8266WebServer *webServer, const String &target)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void setWebRedirect(WebServer *webServer, const String &target)
-#endif
-	{
-		String location = "http://" + target;
-		ESP_DEBUG( "WEB Redirect to [%s]\n", location.c_str() );
-
-		if( target == "" ) return;
-
-		// String location = "http://" + webServer->client().localIP().toString();
-		webServer->sendHeader( "Location", location, true );
-		webServer->send ( 302, "text/plain", "" );
-		webServer->client().stop();
-	}
-
-	//-------------------------------------------------------------------------------
-	uint8_t isWiFiConnection(void)
-	{
-		uint8_t state = 0;
-		if( WiFi.status() == WL_CONNECTED ){
-			state = ( WiFi.localIP().toString() == "0.0.0.0" ) ? 0 : 1 ;
-		}
-		return state;
-	}
-
-	//-------------------------------------------------------------------------------
-	uint32_t getMyID(void)
-	{
-		#if defined(ARDUINO_ARCH_AVR)
-			uint32_t _id =
-				(uint32_t)boot_signature_byte_get(0x13) << 24 |
-				(uint32_t)boot_signature_byte_get(0x15) << 16 |
-				(uint32_t)boot_signature_byte_get(0x16) << 8 |
-				(uint32_t)boot_signature_byte_get(0x17);
-			return _id;
-		#elif defined(ARDUINO_ARCH_ESP8266)
-			return ESP.getChipId();
-		#elif defined(ARDUINO_ARCH_ESP32)
-			uint32_t _id = (uint32_t)((uint64_t)ESP.getEfuseMac() >> 16);
-			return ((((_id)&0xff000000) >> 24) | (((_id)&0x00ff0000) >> 8) | (((_id)&0x0000ff00) << 8) | (((_id)&0x000000ff) << 24)); // swap bits
-		#endif
-		return 0;
-	}
-
-	//-------------------------------------------------------------------------------
-	bool wifi_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask)
-	{
-		ESP_DEBUG( "ESP: WiFi init at mode %u\n", esp::app.mode );
-
-		if( esp::app.mode == esp::Mode::STA ){
-			return wifi_STA_init();
-		}else if( esp::app.mode == esp::Mode::AP ){
-			return wifi_AP_init(ip, gateway, mask );
-		}
-
-		return false;
-	}
-
-	//-------------------------------------------------------------------------------
-	bool wifi_AP_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask)
-	{
-		ESP_DEBUG( "ESP: AP MODE INIT...\n" );
-
-		esp::countNetworks = WiFi.scanNetworks();
-
-		WiFi.disconnect();
-		WiFi.hostname( esp::hostName );
-		WiFi.mode( WiFiMode_t::WIFI_AP );
-		WiFi.persistent( false );
-
-		bool res = WiFi.softAP( esp::app.ap_ssid, esp::app.ap_key );
-#if defined(ARDUINO_ARCH_ESP8266)
-	
-#elif defined(ARDUINO_ARCH_ESP32)
-		WiFi.softAPConfig( ip, gateway, mask );
-#endif
-
-		ESP_DEBUG( "ESP: wifi_AP_init IP: %s SSID: %s HOSTNAME: %s\n", WiFi.softAPIP().toString().c_str(), WiFi.softAPSSID().c_str(), esp::hostName );
-
-		return res;
-	}
-
-	//-------------------------------------------------------------------------------
-	bool wifi_STA_init()
-	{
-		ESP_DEBUG( "ESP: STA MODE INIT...\n" );
-
-		WiFi.softAPdisconnect( true );
-		WiFi.mode( WiFiMode_t::WIFI_STA );
-		WiFi.setAutoReconnect( true );
-		WiFi.setAutoConnect( false );
-		WiFi.persistent( false );
-		WiFi.begin( esp::app.sta_ssid, esp::app.sta_key );
-		WiFi.hostname( esp::hostName );
-
-		ESP_DEBUG( "ESP: WiFi connecting to %s...\n", esp::app.sta_ssid );
-		uint8_t i = 0;
-		while( !WiFi.isConnected() && i++ < 50 ){
-			delay( 100 );
-			ESP_DEBUG( "." );
-		}
-		
-		if( !esp::isWiFiConnection() ){
-			// ESP.restart();
-			ESP_DEBUG( "ERROR\n" );
-			return false;
-		}
-		
-		ESP_DEBUG( "\n" );
-
-		return true;
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void setNoCacheContent(ESP8266WebServer *webServer)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void setNoCacheContent(WebServer *webServer)
-#endif
-	{
-		webServer->sendHeader( "Cache-Control", "no-cache, no-store, must-revalidate" );
-		webServer->sendHeader( "Pragma", "no-cache" );
-		webServer->sendHeader( "Expires", "-1" );
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void addWebServerPages(ESP8266WebServer *webServer, bool wifiConfig, bool notFound)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void addWebServerPages(WebServer *webServer, bool wifiConfig, bool notFound)
-#endif
-	{
-		if( wifiConfig ){
-			webServer->on( "/wifi", [ webServer ](void){
-				ESP_DEBUG( "ESP: WEB /wifi\n" );
-				//if activated captive portal
-				if( esp::flags.captivePortal ){
-					esp::handleWebConfigPage( webServer );
-				}else{
-					if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
-						esp::handleWebConfigPage( webServer );
-					}
-				}
-			} );
-		}
-		if( notFound ){
-			webServer->onNotFound( [ webServer ](void){
-				String uri = webServer->uri();
-				ESP_DEBUG( "WEB 404 [%s]\n", uri.c_str() );
-				esp::handleWeb404Page( webServer );
-			} );
-		}
-
-		webServer->on( "/sysinfo", [ webServer ](void){
-			webServer->sendHeader( "Access-Control-Allow-Origin", "*" );
-			if( pageBuff == nullptr ){
-				webServer->send ( 200, "text/html", "pageBuff is nullptr" );
-				return;
-			}
-
-			strcpy( esp::pageBuff, "{ \"cpu_freq\": " );
-			utoa( ESP.getCpuFreqMHz(), esp::tmpVal, 10 ); strcat( esp::pageBuff, esp::tmpVal );
-
-			if( esp::flags.useFS ){
-				strcat( esp::pageBuff, ",\"fs_total\": " );
-#if defined(ARDUINO_ARCH_ESP8266)
-				FSInfo64 info;
-				bool resInfo = LittleFS.info64( info );
-				if( resInfo ){
-					itoa( info.totalBytes, esp::tmpVal, 10 );
-				}else{
-					itoa( -1, esp::tmpVal, 10 );
-				}
-				strcat( esp::pageBuff, esp::tmpVal );
-#elif defined(ARDUINO_ARCH_ESP32)
-				utoa( SPIFFS.totalBytes(), esp::tmpVal, 10 ); strcat( esp::pageBuff, esp::tmpVal );
-#endif
-				strcat( esp::pageBuff, ",\"fs_used\": " );
-#if defined(ARDUINO_ARCH_ESP8266)
-				if( resInfo ){
-					itoa( info.usedBytes, esp::tmpVal, 10 );
-				}else{
-					itoa( -1, esp::tmpVal, 10 );
-				}
-				strcat( esp::pageBuff, esp::tmpVal );
-#elif defined(ARDUINO_ARCH_ESP32)
-				utoa( SPIFFS.usedBytes(), esp::tmpVal, 10 ); strcat( esp::pageBuff, esp::tmpVal );
-#endif
-			}
-
-			strcat( esp::pageBuff, ",\"mode\": " ); utoa( esp::app.mode, esp::tmpVal, 10 ); strcat( esp::pageBuff, esp::tmpVal );
-			strcat( esp::pageBuff, ",\"version\": [" );
-			itoa( esp::firstVersion, esp::tmpVal, 10 );strcat( esp::pageBuff, esp::tmpVal );
-			strcat( esp::pageBuff, "," );itoa( esp::secondVersion, esp::tmpVal, 10 );strcat( esp::pageBuff, esp::tmpVal );
-			strcat( esp::pageBuff, "," );itoa( esp::thridVersion, esp::tmpVal, 10 );strcat( esp::pageBuff, esp::tmpVal );
-			strcat( esp::pageBuff, "]" );
-
-			strcat( esp::pageBuff, "}" );
-
-			webServer->send ( 200, "application/json", esp::pageBuff );
-		} );
-
-		webServer->on( "/favicon.ico", [ webServer ](void){
-			esp::webSendFile( webServer, "/favicon.ico", "image/x-icon" );
-		} );
-		
-		webServer->on( "/index.css", [ webServer ](void){
-			esp::webSendFile( webServer, "/index.css", "text/css" );
-		} );
-		webServer->on( "/index.js", [ webServer ](void){
-			esp::webSendFile( webServer, "/index.js", "text/javascript" );
-		} );
-
-		webServer->on( "/format", [ webServer ](void){
-			if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-				bool res = LittleFS.format();
-#elif defined(ARDUINO_ARCH_ESP32)
-				bool res = SPIFFS.format();
-#endif
-				if( res ){
-					webServer->send( 200, "application/json", "{ \"result\": \"OK\" }" );
-				}else{
-					webServer->send( 500, "application/json", "{ \"result\": \"ERROR\" }" );
-				}
-			}else{
-				webServer->send( 403, "application/json", "{ \"result\": \"access denied\" }" );
-			}
-		} );
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void addWebUpdate(ESP8266WebServer *webServer, const char* key)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void addWebUpdate(WebServer *webServer, const char* key)
-#endif
-	{
-		strcpy( esp::updateKey, key );
-		webServer->on( "/update", HTTP_POST, [ webServer ](void){
-			webServer->sendHeader( "Connection", "close" );
-    		webServer->send( 200, "text/plain", ( Update.hasError() ) ? "FAIL" : "OK" );
-			if( !esp::flags.updateError && esp::flags.updateFirmware ){
-				delay( 1000 );
-				ESP.restart();
-			}
-		}, [ webServer ](void){
-			// webServer->sendHeader( "Access-Control-Allow-Origin", "*" );
-			// if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
-				esp::updateProcess( webServer );
-			// }else{
-				// webServer->send( 403, "text/plain", "Access denied" );
-			// }
-		} );
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void activateCaptivePortal(ESP8266WebServer *webServer, const char* captiveRedirectTarget, ESP8266WebServer::THandlerFunction cp_handler)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void activateCaptivePortal(WebServer *webServer,  const char* captiveRedirectTarget, WebServer::THandlerFunction cp_handler)
-#endif
-	{
-		String target = WiFi.softAPSSID() + ".lan";
-		if( captiveRedirectTarget != nullptr ){
-			target += captiveRedirectTarget;
-		}
-		target.toLowerCase();
-
-		// webServer->on( "/fwlink", [ webServer, target, cp_handler ](void){
-		// 	if( target != "" ){
-		// 		esp::setWebRedirect( webServer, target );
-		// 	}else if( cp_handler != nullptr ){
-		// 		cp_handler();
-		// 	}else{
-		// 		esp::webSendFile( webServer, "/portal.html", "text/html", ( !esp::flags.captivePortalAccess ) ? 200 : 204 );
-		// 	}
-		// } );
-		// webServer->on( "/generate_204", [ webServer, target, cp_handler ](void){
-		// 	if( target != "" ){
-		// 		esp::setWebRedirect( webServer, target );
-		// 	}else if( cp_handler != nullptr ){
-		// 		cp_handler();
-		// 	}else{
-		// 		esp::webSendFile( webServer, "/portal.html", "text/html", ( !esp::flags.captivePortalAccess ) ? 200 : 204 );
-		// 	}
-		// } );
-		
-		webServer->on( ESP_CAPTIVE_PORTAL_URL, [ webServer, target, cp_handler ](void){
-			if( webServer->hasArg( "cmd" ) ){
-				if( webServer->arg( "cmd" ) == "OK" ){
-					esp::flags.captivePortalAccess = 1;
-					// esp::setWebRedirect( webServer, WiFi.softAPIP().toString() + "/" );
-				}
-			}
-
-			esp::webSendFile( webServer, "/portal.html", "text/html" );
-		} );
-		webServer->onNotFound( [ webServer, target, cp_handler ](void){
-			if( esp::flags.captivePortalAccess ){
-				webServer->send( 200, "text/html", "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>" );
-			}else{
-				esp::setWebRedirect( webServer, target );
-			}
-		} );
-		esp::flags.captivePortal = 1;
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void handleWebConfigPage(ESP8266WebServer *webServer)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void handleWebConfigPage(WebServer *webServer)
-#endif
-	{
-		bool success = false;
-
-		esp::setNoCacheContent( webServer );
-		//-------------------------------------------------------------
-		if( webServer->hasArg( "cmd" ) ){
-			const String &cmd = webServer->arg( "cmd" );
-			if( cmd == "ap_config" && webServer->hasArg( "ssid" ) && webServer->hasArg( "key" ) ){
-				if( webServer->arg( "ssid" ).length() > 0 ){
-					strcpy( esp::app.ap_ssid, webServer->arg( "ssid" ).c_str() );
-					strcpy( esp::app.ap_key, webServer->arg( "key" ).c_str() );
-					esp::saveSystemSettings();
-					success = true;
-				}
-			}else if( cmd == "sta_config" && webServer->hasArg( "ssid" ) && webServer->hasArg( "key" ) ){
-				if( webServer->arg( "ssid" ).length() > 0 ){
-					strcpy( esp::app.sta_ssid, webServer->arg( "ssid" ).c_str() );
-					strcpy( esp::app.sta_key, webServer->arg( "key" ).c_str() );
-					esp::saveSystemSettings();
-					success = true;
-				}
-			}else if( cmd == "other" ){
-				ESP_DEBUG( "OTHER\n" );
-				if( webServer->hasArg( "mode" ) ){
-					esp::app.mode = (uint8_t)webServer->arg( "mode" ).toInt();
-					ESP_DEBUG( "NEW MODE: %u\n", esp::app.mode );
-					esp::saveSystemSettings();
-					success = true;
-				}
-			}else if( cmd == "remove_config" && esp::flags.useFS && webServer->hasArg( "reboot" ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-				LittleFS.remove( ESP_SYSTEM_CONFIG_FILE );
-#elif defined(ARDUINO_ARCH_ESP32)
-				SPIFFS.remove( ESP_SYSTEM_CONFIG_FILE );
-#endif
-				if( webServer->arg( "reboot" ) == "on" ){
-					// webServer->send ( 200, "text/html", "Rebooting..." );
-					webServer->send ( 200, "application/json", "{\"success\":\"true\",\"message\":\"Rebooting...\"}" );
-					delay( 1000 );
-					ESP.restart();
-					return;
-				}
-			}
-		}
-		//-------------------------------------------------------------
-		if( pageBuff == nullptr ){
-			// webServer->send ( 200, "text/html", "pageBuff is nullptr" );
-			if( success ){
-				webServer->send( 200, "application/json", "{\"success\":\"true\",\"message\":\"pageBuff is nullptr\"}" );
-			}else{
-				webServer->send( 200, "application/json", "{\"success\":\"false\",\"message\":\"pageBuff is nullptr\"}" );
-			}
-			return;
-		}
-
-		strcpy( pageBuff, "{\"success\": " );
-		strcat( pageBuff, ( success ) ? "\"true\"" : "\"false\"" );
-		strcat( pageBuff, "}" );
-
-		//if activated captive portal
-		if( esp::flags.captivePortal ){
-			esp::setWebRedirect( webServer, ESP_CAPTIVE_PORTAL_URL );
-			return;
-		}
-
-		webServer->send ( 200, "application/json", pageBuff );
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void handleWeb404Page(ESP8266WebServer *webServer)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void handleWeb404Page(WebServer *webServer)
-#endif
-	{
-		if( !esp::webSendFile( webServer, "/404.html", "text/html", 0 ) && !esp::webSendFile( webServer, "/index.html", "text/html", 0 ) ){
-			if( pageBuff == nullptr ){
-				webServer->send ( 200, "text/html", "pageBuff is nullptr" );
-				return;
-			}
-			esp::pageBuff[ 0 ] = '\0';
-			if( esp::pageTop != nullptr ) strcpy( esp::pageBuff, esp::pageTop );
-			strcat( esp::pageBuff, "<title>Not found</title>" );
-			if( esp::pageEndTop != nullptr ) strcat( esp::pageBuff, esp::pageEndTop );
-			strcat( esp::pageBuff, "<h1>404 Not found</h1>" );
-			strcat( esp::pageBuff, webServer->uri().c_str() );
-			if( esp::pageBottom != nullptr ) strcat( esp::pageBuff, esp::pageBottom );
-			webServer->send ( 200, "text/html", esp::pageBuff );
-		}
-	}
-
-	//-------------------------------------------------------------------------------
-	#if defined(ARDUINO_ARCH_ESP8266)
-	uint8_t webSendFile(ESP8266WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code)
-#elif defined(ARDUINO_ARCH_ESP32)
-	uint8_t webSendFile(WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code)
-#endif
-	{
-		ESP_DEBUG( "ESPF: Http send file [%s] %s\n", fileName, mimeType );
-		if( esp::isFileExists( fileName ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-			File f = LittleFS.open( fileName, "r");
-#elif defined(ARDUINO_ARCH_ESP32)
-			File f = SPIFFS.open( fileName, "r");
-#endif
-			if( f ){
-#if defined(ARDUINO_ARCH_ESP8266)
-				webServer->send( code, mimeType, f, f.size() );
-#elif defined(ARDUINO_ARCH_ESP32)
-				webServer->streamFile( f, mimeType, code );
-#endif
-				f.close();
-			}else{
-				webServer->send( 500, "text/html", "File not open :(" );
-			}
-			// webServer->setContentLength(f.size());
-			// webServer->send( code, mimeType, );
-			// while( f.available() ){
-				// int8_t len = f.read( (uint8_t*)esp::tmpVal, sizeof( esp::tmpVal ) );
-				// if( len ) webServer->client().write( esp::tmpVal, len );
-			// }
-			// f.close();
-			// webServer->client().stop();
-		}else{
-			if( code ) webServer->send( ( code == 200 ) ? 404 : code, "text/html", "File not found :(");
-			return 0;
-		}
-
-		return 1;
-	}
-
-	//-------------------------------------------------------------------------------
-	uint32_t checkingUpdate(const char *repoURL, const uint16_t version)
-	{
-		uint32_t res = 0;
-		if( !esp::flags.useFS ) return res;
-		HTTPClient http;
-#if defined(ARDUINO_ARCH_ESP8266)
-		WiFiClient client;
-		http.begin( client, String( repoURL ) + String( ESP_FIRMWARE_VERSION_FILENAME ) );
-#elif defined(ARDUINO_ARCH_ESP32)
-		http.begin( String( repoURL ) + String( ESP_FIRMWARE_VERSION_FILENAME ) );
-#endif
-		int httpCode = http.GET();
-		
-		if( httpCode == HTTP_CODE_OK ){
-			res = http.getString().toInt();
-		}
-
-		http.end();
-
-		return res;
-	}
-
-	//-------------------------------------------------------------------------------
-	uint8_t downloadUpdate(const char *repoURL, const char *file)
-	{
-		uint8_t res = 0;
-		if( !esp::flags.useFS ) return res;
-		HTTPClient http;
-#if defined(ARDUINO_ARCH_ESP8266)
-		WiFiClient client;
-		http.begin( client, String( repoURL ) + String( file ) );
-#elif defined(ARDUINO_ARCH_ESP32)
-		http.begin( String( repoURL ) + String( file ) );
-#endif
-		int httpCode = http.GET();
-		if( httpCode == HTTP_CODE_OK ){		
-#if defined(ARDUINO_ARCH_ESP8266)
-			File f = LittleFS.open( file, "w");
-#elif defined(ARDUINO_ARCH_ESP32)
-			File f = SPIFFS.open( file, "w");
-#endif
-			if( f ){
-				ESP_DEBUG( "%s:%d[HTTP] Downloading [%s%s]...\n", __FILE__, __LINE__, repoURL, file );
-				WiFiClient* stream = http.getStreamPtr();
-				uint8_t buff[ 128 ] = { 0 };
-				int totalLength = http.getSize();
-				int len = totalLength;
-				while( http.connected() && ( len > 0 || len == -1 ) ){
-					size_t size = stream->available();
-					if( size ){
-						int c = stream->readBytes( buff, ((size > sizeof(buff)) ? sizeof(buff) : size) );
-						f.write( buff, c );
-						if( len > 0 ) len -= c;
-					}
-					delay(1);
-				}
-
-				// http.writeToStream( &f );
-				res = 1;
-			}else{
-				ESP_DEBUG( "%s:%d failed to open %s\n", __FILE__, __LINE__, file );
-			}
-		}else{
-			ESP_DEBUG( "%s:%d[HTTP] GET... failed, error: %s\n", __FILE__, __LINE__, http.errorToString( httpCode ).c_str() );
-		}
-		http.end();
-		return res;
-	}
-
-	//-------------------------------------------------------------------------------
-	uint8_t updateFromFS(void)
-	{
-		uint8_t res = 0;
-		if( !esp::flags.useFS ) return res;
-
-		if( esp::isFileExists( ESP_FIRMWARE_FILEPATH ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-			File f = LittleFS.open( ESP_FIRMWARE_FILEPATH, "r");
-#elif defined(ARDUINO_ARCH_ESP32)
-			File f = SPIFFS.open( ESP_FIRMWARE_FILEPATH, "r");
-#endif
-			if( f ){
-				if( f.isDirectory() ){
-					ESP_DEBUG( "%s:%d Error, %s is not a file\n", __FILE__, __LINE__, ESP_FIRMWARE_FILEPATH );
-					f.close();
-					return res;
-				}
-
-				size_t fileSize = f.size();
-				if( fileSize > 0 ){
-					ESP_DEBUG( "%s:%d Trying to start update\n", __FILE__, __LINE__ );
-					if( Update.begin( fileSize ) ){
-						size_t written = Update.writeStream( f );
-						if( written == fileSize ){
-							ESP_DEBUG( "%s:%d Written : %d successfully\n", __FILE__, __LINE__, written );
-						}else{
-							ESP_DEBUG( "%s:%d Written only: %d / %d. Retry?\n", __FILE__, __LINE__, written, fileSize );
-						}
-
-						if( Update.end() ){
-							ESP_DEBUG( "%s:%d OTA done!?\n", __FILE__, __LINE__ );
-							if( !Update.isFinished() ){
-								ESP_DEBUG( "%s:%d Update not finished? Something went wrong!\n", __FILE__, __LINE__ );
-							}else{
-								res = 1;
-							}
-						}else{
-							ESP_DEBUG( "%s:%d Error Occurred. Error #: %d\n", __FILE__, __LINE__, Update.getError() );
-						}
-					}else{
-							ESP_DEBUG( "%s:%d Not enough space to begin OTA\n", __FILE__, __LINE__ );
-					}
-				}else{
-					ESP_DEBUG( "%s:%d Error, file is empty\n", __FILE__, __LINE__ );
-				}
-				f.close();
-			}
-		}else{
-			ESP_DEBUG( "%s:%d Could not load %s from spiffs root\n", __FILE__, __LINE__, ESP_FIRMWARE_FILEPATH );
-		}
-
-		return res;
-	}
-
-	//-------------------------------------------------------------------------------
-	bool isFileExists(const char *filepath)
-	{
-		if( !esp::flags.useFS ) return false;
-#if defined(ARDUINO_ARCH_ESP8266)
-		return LittleFS.exists( filepath );
-#elif defined(ARDUINO_ARCH_ESP32)
-		return SPIFFS.exists( filepath );
-#endif
-	}
-
-	//-------------------------------------------------------------------------------
-	void printAllFiles(HardwareSerial &SerialPort)
-	{
-		if( !esp::flags.useFS ) return;
-#if defined(ARDUINO_ARCH_ESP8266)
-		Dir root = LittleFS.openDir( "/" );
-		while( root.next() ){
-			File file = root.openFile("r");
-			SerialPort.print( ": " );
-			SerialPort.println( root.fileName() );
-			file.close();
-		}
-#elif defined(ARDUINO_ARCH_ESP32)
-		File root = SPIFFS.open( "/" );
-		File file = root.openNextFile();
-		while( file ){
-			SerialPort.print( ": " );
-			SerialPort.println( file.name() );
-			file = root.openNextFile();
-		}
-#endif
-	}
-
-	//-------------------------------------------------------------------------------
-	void init(const char* deviceName, bool useFS)
-	{
-		esp::flags.useFS							= 0;
-
-		if( useFS ){
-			bool fs_init_res = false;
-#if defined(ARDUINO_ARCH_ESP8266)
-			fs_init_res = LittleFS.begin();
-#elif defined(ARDUINO_ARCH_ESP32)
-			fs_init_res = SPIFFS.begin( true );
-#endif
-			delay( 50 );
-			ESP_DEBUG( "FS Init...%s\n", ( ( fs_init_res ) ? "OK" : "ERROR" ) );
-			esp::flags.useFS						= ( fs_init_res ) ? 1 : 0;
-		}
-		
-		esp::flags.captivePortal					= 0;
-		esp::flags.captivePortalAccess				= 0;
-		esp::flags.autoUpdate						= 0;
-		esp::app.mode								= esp::Mode::UNKNOWN;
-		esp::rtc_offset								= 0;
-
-		if( esp::isFileExists( ESP_AUTOUPDATE_FILENAME ) ) esp::flags.autoUpdate = 1;
-
-		pageTop = "<!DOCTYPE HTML><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"><meta charset=\"utf-8\"/><script type=\"text/javascript\" src=\"/index.js\"></script><link rel=\"stylesheet\" type=\"text/css\" href=\"/index.css\"/>";
-		pageEndTop = "</head><body><hr size=\"1\">";
-		pageBottom = "<hr size=\"1\" class=\"red\"></body></html>";
-
-		strcpy( esp::systemLogin, SYSTEM_LOGIN );
-		strcpy( esp::systemPassword, SYSTEM_PASSWORD );
-		strcpy( esp::app.ap_ssid, deviceName );
-		strcpy( esp::app.ap_key, DEFAULT_AP_KEY );
-		strcpy( esp::hostName, deviceName );
-
-		if( esp::flags.useFS ){
-			ESP_DEBUG( "ESP: load System Settings..." );
-			if( loadSettings( (uint8_t*)&app, sizeof( app ), ESP_SYSTEM_CONFIG_FILE ) ){
-				ESP_DEBUG( "OK\n" );
-			}else{
-				ESP_DEBUG( "ERROR\n" );
-			}
-		}
-
-		ESP_DEBUG( "ESP: Device mode:%u\n", esp::app.mode );
-
-#ifdef __DEV
-		ESP_DEBUG( "ESP: === filesystem ============\n" );
-#if defined(ARDUINO_ARCH_ESP8266)
-		File root = LittleFS.open( "/", "r" );
-#elif defined(ARDUINO_ARCH_ESP32)
-		File root = SPIFFS.open( "/", "r" );
-#endif
-		File file = root.openNextFile();
-		while( file ){
-			ESP_DEBUG( "FILE: %s\n", file.name() );
-			file = root.openNextFile();
-		}
-
-		ESP_DEBUG( "ESP: === end filesystem ========\n" );
-#endif
-
-		// Checking reboot reason
-#if defined(ARDUINO_ARCH_ESP8266)
-		if( esp::app.mode == esp::Mode::STA || esp::app.mode == esp::Mode::AP ){
-			if( esp::getResetReason() == REASON_EXT_SYS_RST ){
-				// Включаем режим приема сырых данных для возможной конфигурации по сырым данным
-				disablePromiscMode();
-				enablePromiscMode();
-			}
-		}
-#elif defined(ARDUINO_ARCH_ESP32)
-		// TODO: Continue
-#endif
-
-		if( esp::app.mode == esp::Mode::UNKNOWN ) esp::setMode( esp::Mode::AP );
-	}
-
-	//-------------------------------------------------------------------------------
-	void changeMAC(const uint8_t *mac)
-	{
-		ESP_DEBUG( "ESP: OLD ESP MAC: %s\n", WiFi.macAddress().c_str() );
-#if defined(ARDUINO_ARCH_ESP8266)
-		wifi_set_macaddr( 0, const_cast<uint8*>(mac) );
-#elif defined(ARDUINO_ARCH_ESP32)
-		esp_wifi_set_mac( WIFI_IF_STA, mac );
-#endif
-		ESP_DEBUG( "ESP: NEW ESP MAC: %s\n", WiFi.macAddress().c_str() );
-	}
-
-	//-------------------------------------------------------------------------------
-	int http_put(const String &url, const String &playload, String &response)
-	{
-		HTTPClient http;
-#if defined(ARDUINO_ARCH_ESP8266)
-		WiFiClient client;
-		http.begin( client, url );
-#elif defined(ARDUINO_ARCH_ESP32)
-		http.begin( url );
-#endif
-		String request = "{ \"user\": \"DrSmyrke\", \"message\": \"IR Reciever starting...\", \"key\": \"0f7d848c56094bf722ca34701d38938e\" }";
-		int httpCode = http.PUT( playload );
-		
-		// if( httpCode == HTTP_CODE_OK ){
-			response = http.getString();
-		// }
-
-		http.end();
-
-		return httpCode;
-	}
-
-	//-------------------------------------------------------------------------------
-	void saveSettings(const uint8_t* data, uint32_t length, const char* settingsFile)
-	{
-		if( length <= 0 || data == nullptr || settingsFile == nullptr || !esp::flags.useFS ) return;
-#if defined(ARDUINO_ARCH_ESP8266)
-		File f = LittleFS.open( settingsFile, "w");
-#elif defined(ARDUINO_ARCH_ESP32)
-		File f = SPIFFS.open( settingsFile, "w");
-#endif
-		if( f ){
-			f.write( data, length );
-			f.close();
-		}
-	}
-
-	//-------------------------------------------------------------------------------
-	uint32_t loadSettings(uint8_t* data, uint32_t size, const char* settingsFile)
-	{
-		uint32_t res = 0;
-		if( size <= 0 || data == nullptr || settingsFile == nullptr || !esp::flags.useFS ) return res;
-
-		if( esp::isFileExists( settingsFile ) ){
-#if defined(ARDUINO_ARCH_ESP8266)
-			File f = LittleFS.open( settingsFile, "r");
-#elif defined(ARDUINO_ARCH_ESP32)
-			File f = SPIFFS.open( settingsFile, "r");
-#endif
-			if( f ){
-				res = f.read( data, size );
-				f.close();
-			}
-		}
-		return res;
-	}
-	//-------------------------------------------------------------------------------
-	void changeSystemUserPassword(const char* login, const char* password)
-	{
-		if( login == nullptr || password == nullptr ) return;
-		if( strlen( login ) > sizeof( esp::systemLogin ) ) return;
-		if( strlen( password ) > sizeof( esp::systemPassword ) ) return;
-
-		strcpy( esp::systemLogin, login );
-		strcpy( esp::systemPassword, password );
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-	void updateProcess(ESP8266WebServer *webServer)
-#elif defined(ARDUINO_ARCH_ESP32)
-	void updateProcess(WebServer *webServer)
-#endif
-	{
-		HTTPUpload& upload = webServer->upload();
-		if( upload.status == UPLOAD_FILE_START ){
-			esp::flags.updateError = 0;
-			esp::flags.updateFirmware = 0;
-			esp::flags.updateFile = 0;
-			ESP_DEBUG( "Update: %s [ %s ]\n", upload.filename.c_str(), upload.name.c_str() );
-
-			if( webServer->hasArg( "sdf" ) ){
-				ESP_DEBUG( "[%s/%s]\n", webServer->arg( "sdf" ).c_str(), esp::updateKey );
-				if( strcmp( webServer->arg( "sdf" ).c_str(), esp::updateKey ) == 0 ){
-					if( upload.name == "firmware" && upload.filename == ESP_FIRMWARE_FILENAME ){
-						ESP_DEBUG( "Update begin\n" );
-						esp::flags.updateFirmware = 1;
-
-						// if( !Update.begin( UPDATE_SIZE_UNKNOWN ) ){ //start with max available size
-#if defined(ARDUINO_ARCH_ESP8266)
-						if( !Update.begin( upload.contentLength ) ){
-#elif defined(ARDUINO_ARCH_ESP32)
-						if( !Update.begin( upload.totalSize ) ){
-#endif
-							Update.printError( Serial );
-							webServer->send ( 500, "text/html", "update begin fs error" );
-							esp::flags.updateError = 1;
-							esp::flags.updateFirmware = 0;
-						}
-					}else if( upload.name == "filesystem" ){
-						ESP_DEBUG( "Update begin\n" );
-						esp::flags.updateFirmware = 1;
-
-#if defined(ARDUINO_ARCH_ESP8266)
-						if( !Update.begin( upload.contentLength, U_FS ) ){
-#elif defined(ARDUINO_ARCH_ESP32)
-						if( !Update.begin( upload.totalSize, U_SPIFFS ) ){
-#endif
-							Update.printError( Serial );
-							webServer->send ( 500, "text/html", "update begin fs error" );
-							esp::flags.updateError = 1;
-							esp::flags.updateFirmware = 0;
-						}
-					}else if( upload.name == "file" ){
-						String path = "/" + upload.filename;
-#if defined(ARDUINO_ARCH_ESP8266)
-						updateFile = LittleFS.open( path, "w" );
-#elif defined(ARDUINO_ARCH_ESP32)
-						updateFile = SPIFFS.open( path, "w" );
-#endif
-						if( updateFile ){
-							esp::flags.updateFile = 1;
-						}else{
-							esp::flags.updateError = 1;
-						}
-					}else{
-						ESP_DEBUG( "Unknown update\n" );
-						webServer->send ( 500, "text/html", "Unknown update: error" );
-						esp::flags.updateError = 1;
-					}
-				}else{
-					ESP_DEBUG( "Unknown key\n" );
-					webServer->send ( 500, "text/html", "Update: Unknown key :(" );
-					esp::flags.updateError = 1;
-				}
-			}else{
-				ESP_DEBUG( "Unknown key\n" );
-				webServer->send ( 500, "text/html", "Update: Unknown key :(" );
-				esp::flags.updateError = 1;
-			}
-		}else if( upload.status == UPLOAD_FILE_WRITE ){
-			// flashing firmware to ESP
-			if( !esp::flags.updateError && esp::flags.updateFirmware ){
-				if( Update.write( upload.buf, upload.currentSize ) != upload.currentSize ){
-					Update.printError( Serial );
-					webServer->send ( 500, "text/html", "update error" );
-					esp::flags.updateError = 1;
-				}
-			}else if( !esp::flags.updateError && esp::flags.updateFile ){
-				if( updateFile ){
-					updateFile.write( upload.buf, upload.currentSize );
-				}else{
-					esp::flags.updateError = 1;
-				}
-			}
-		}else if( upload.status == UPLOAD_FILE_END ){
-			// finish flashing firmware to ESP
-			if( !esp::flags.updateError && esp::flags.updateFirmware ){
-				if( Update.end( true ) ){ //true to set the size to the current progress
-					ESP_DEBUG( "Update Success: %u\nRebooting...\n", upload.totalSize );
-				}else{
-					Update.printError( Serial );
-					webServer->send ( 500, "text/html", "update error 2" );
-					esp::flags.updateError = 1;
-				}
-			}else if( !esp::flags.updateError && esp::flags.updateFile ){
-				if( updateFile ){
-					// if( upload.currentSize ) updateFile.write( upload.buf, upload.currentSize );
-					updateFile.close();
-				}
-			}
-		}else if( upload.status == UPLOAD_FILE_ABORTED ){
-			Update.end();
-			ESP_DEBUG( "Update was aborted\n" );
-			webServer->send ( 500, "text/html", "update aborted" );
-			esp::flags.updateError = 1;
-		}
-
-		
-		/*
-		HTTPUpload& upload = webServer->upload();
-
-		ESP_DEBUG( "updateProcess [%s][%s] %d %d/%d\n", upload.name, upload.filename, upload.status, upload.currentSize, upload.totalSize );
-
-		if( upload.status == UPLOAD_FILE_START ){
-			esp::flags.updateError = 0;
-			if( upload.name == "filesystem" ){
-#if defined(ARDUINO_ARCH_ESP8266)
-				FSInfo64 info;
-				bool resInfo = LittleFS.info64( info );
-				size_t fsSize = info.totalBytes - info.usedBytes;
-				LittleFS.end();
-				//start with max available size
-				if( !Update.begin( fsSize, U_FS ) ){
-#elif defined(ARDUINO_ARCH_ESP32)
-				size_t fsSize = SPIFFS.totalBytes() - SPIFFS.usedBytes();
-				SPIFFS.end();
-				//start with max available size
-				if( !Update.begin( fsSize, U_SPIFFS ) ){
-#endif
-					webServer->send ( 500, "text/html", "update begin fs error" );
-					esp::flags.updateError = 1;
-				}
-			}else if( upload.name == "firmware" && upload.filename == ESP_FIRMWARE_FILENAME ){
-				ESP_DEBUG( "Update begin\n" );
-				uint32_t maxSketchSpace = ( ESP.getFreeSketchSpace() - 0x1000 ) & 0xFFFFF000;
-				//start with max available size
-				if( !Update.begin( maxSketchSpace, U_FLASH ) ){
-					webServer->send ( 500, "text/html", "update begin firmware error" );
-					esp::flags.updateError = 1;
-				}
-			}
-		}else if( upload.status == UPLOAD_FILE_WRITE && !esp::flags.updateError ){
-			ESP_DEBUG( "." );
-			if( Update.write( upload.buf, upload.currentSize ) != upload.currentSize ){
-				webServer->send ( 500, "text/html", "update error" );
-			}
-		}else if( upload.status == UPLOAD_FILE_END && !esp::flags.updateError ){
-			//true to set the size to the current progress
-			if( Update.end( true ) ){
-				ESP_DEBUG( "Update Success: %zu\nRebooting...\n", upload.totalSize );
-			} else {
-				webServer->send ( 500, "text/html", "update error" );
-			}
-		}else if( upload.status == UPLOAD_FILE_ABORTED ){
-			Update.end();
-			ESP_DEBUG( "Update was aborted\n" );
-			webServer->send ( 500, "text/html", "update aborted" );
-		}
-		*/
-	}
-
-	//-------------------------------------------------------------------------------
-	void setVersion(const uint8_t first, const uint8_t second, const uint16_t thrid)
-	{
-		esp::firstVersion = first;
-		esp::secondVersion = second;
-		esp::thridVersion = thrid;
-	}
-
-	//-------------------------------------------------------------------------------
-	uint8_t getMode(void)
-	{
-		return esp::app.mode;
-	}
-
-	//-------------------------------------------------------------------------------
-	void setMode(const uint8_t value)
-	{
-		esp::app.mode = value;
-		saveSystemSettings();
-	}
-
-	//-------------------------------------------------------------------------------
-	void saveSystemSettings(void)
-	{
-		if( !esp::flags.useFS ) return;
-
-		ESP_DEBUG( "ESP: saveSystemSettings...\n" );
-		saveSettings( (uint8_t*)&app, sizeof( app ), ESP_SYSTEM_CONFIG_FILE );
-	}
-
-	//-------------------------------------------------------------------------------
-	uint32_t getResetReason(void)
-	{
-#if defined(ARDUINO_ARCH_ESP8266)
-		rst_info *resetInfo;
-		resetInfo = ESP.getResetInfoPtr();
-		return resetInfo->reason;
-#elif defined(ARDUINO_ARCH_ESP32)
-		return rtc_get_reset_reason( 0 );
-#endif
-	}
-
-	//-------------------------------------------------------------------------------
-	void enablePromiscMode(wifi_promiscuous_cb_t func)
-	{
-		ESP_DEBUG( "ESP: Enabled Promiscous mode at %u chanel\n", PROMISCUOUS_MODE_CHANNEL );
-
-#if defined(ARDUINO_ARCH_ESP8266)
-		wifi_set_opmode( STATION_MODE );
-		WiFi.disconnect();
-		wifi_set_channel( PROMISCUOUS_MODE_CHANNEL );
-#elif defined(ARDUINO_ARCH_ESP32)
-		// TODO: continue
-#endif
-		
-		if( func == nullptr ){
-#if defined(ARDUINO_ARCH_ESP8266)
-			wifi_set_promiscuous_rx_cb( promisc_rx_cb );
-#elif defined(ARDUINO_ARCH_ESP32)
-			// TODO: continue
-#endif
-		}else{
-#if defined(ARDUINO_ARCH_ESP8266)
-			wifi_set_promiscuous_rx_cb( func );
-#elif defined(ARDUINO_ARCH_ESP32)
-			// TODO: continue
-#endif
-		}
-
-#if defined(ARDUINO_ARCH_ESP8266)
-		wifi_promiscuous_enable( true );
-#elif defined(ARDUINO_ARCH_ESP32)
-		// TODO: continue
-#endif
-
-		esp::app.mode = esp::Mode::PROMISCUOUS;
-	}
-
-	//-------------------------------------------------------------------------------
-	void disablePromiscMode(void)
-	{
-#if defined(ARDUINO_ARCH_ESP8266)
-		wifi_promiscuous_enable( false );
-#elif defined(ARDUINO_ARCH_ESP32)
-		// TODO: continue
-#endif
-	}
-
-	//-------------------------------------------------------------------------------
-	void promisc_rx_cb(uint8_t *buf, uint16_t len)
-	{
-		static uint8_t counter = 0;
-
-		ESP_DEBUG( "WIFI RCV: [%u bytes] [", len );
-		for( uint16_t i = 0; i < len; i++ ) ESP_DEBUG( "%02X ", buf[ i ] );
-		ESP_DEBUG( "] [%u/%u]\n", counter, READ_RAW_PACKETS_BEFORE_START );
-
-		if( counter >= READ_RAW_PACKETS_BEFORE_START ){
-			disablePromiscMode();
-			ESP.restart();
-			// while( 1 );
-			return;
-		}
-
-		counter++;
-	}
-
-	//-------------------------------------------------------------------------------
-#if defined(ARDUINO_ARCH_ESP8266)
-
-#elif defined(ARDUINO_ARCH_ESP32)
-	void CAN_Init(const uint16_t speed, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode)
-	{
-		can_stop();
-		can_driver_uninstall();
-
-		ESP_DEBUG( "ESP: CAN Initialize at %u, %u pins %uKbt/s mode: %u\n", tx_pin, rx_pin, mode );
-
-		can_general_config_t g_config = CAN_GENERAL_CONFIG_DEFAULT( tx_pin, rx_pin, mode );
-		can_timing_config_t t_config = CAN_TIMING_CONFIG_125KBITS();
-		can_filter_config_t f_config = CAN_FILTER_CONFIG_ACCEPT_ALL();
-
-		can_speed = speed;
-		switch( speed ){
-			case 25:	t_config = CAN_TIMING_CONFIG_25KBITS();		break;
-			case 50:	t_config = CAN_TIMING_CONFIG_50KBITS();		break;
-			case 100:	t_config = CAN_TIMING_CONFIG_100KBITS();	break;
-			case 125:	t_config = CAN_TIMING_CONFIG_125KBITS();	break;
-			case 250:	t_config = CAN_TIMING_CONFIG_250KBITS();	break;
-			case 500:	t_config = CAN_TIMING_CONFIG_500KBITS();	break;
-			case 800:	t_config = CAN_TIMING_CONFIG_800KBITS();	break;
-			case 1000:	t_config = CAN_TIMING_CONFIG_1MBITS();		break;
-			default:
-				t_config = CAN_TIMING_CONFIG_125KBITS();
-				can_speed = 125;
-			break;
-		}
-
-		//Install CAN driver
-		if( can_driver_install( &g_config, &t_config, &f_config ) == ESP_OK ){
-			ESP_DEBUG( "ESP: CAN Driver installed\n" );
-		}else{
-			ESP_DEBUG( "ESP: CAN Failed to install driver\n" );
-			return;
-		}
-
-		//Start CAN driver
-		if( can_start() == ESP_OK ){
-			ESP_DEBUG( "ESP: CAN Driver started\n" );
-		}else{
-			ESP_DEBUG( "ESP: CAN Failed to start driver\n" );
-			return;
-		}
-	}
-
-	//-------------------------------------------------------------------------------
-	uint16_t get_CAN_speed(void)
-	{
-		return can_speed;
-	}
-#endif
-	//-------------------------------------------------------------------------------
-	void printHexData(const uint8_t* data, size_t len)
-	{
-		ESP_DEBUG( "[" );
-		for( size_t i = 0; i < len; i++ ){
-			if( i > 0 ) ESP_DEBUG( " " );
-			ESP_DEBUG( "%02x", data[ i ] );
-		}
-		ESP_DEBUG( "]" );
-	}
-	//-------------------------------------------------------------------------------
-	void wdt_init(void)
-	{
-#if defined(ARDUINO_ARCH_ESP8266)
-		ESP.wdtEnable( WDT_TIMEOUT );
-#elif defined(ARDUINO_ARCH_ESP32)
-		esp_task_wdt_init( WDT_TIMEOUT, true ); //enable panic so ESP32 restarts
-		esp_task_wdt_add( NULL ); //add current thread to WDT watch
-#endif
-	}
-
-	//-------------------------------------------------------------------------------
-	void wdt_reset(void)
-	{
-#if defined(ARDUINO_ARCH_ESP8266)
-		ESP.wdtFeed();
-#elif defined(ARDUINO_ARCH_ESP32)
-		esp_task_wdt_reset();
-#endif
-	}
-
-#if defined(ARDUINO_ARCH_ESP32)
-	//-------------------------------------------------------------------------------
-	void rtc_setDateTime(int sc, int mn, int hr, int dy, int mt, int yr, int ms)
-	{
-		// seconds, minute, hour, day, month, year $ microseconds(optional)
-		// ie setTime(20, 34, 8, 1, 4, 2021) = 8:34:20 1/4/2021
-		struct tm t = {0, 0, 0, 0, 0, 0, 0, 0, 0};      // Initalize to all 0's
-		t.tm_year = yr - 1900;    // This is year-1900, so 121 = 2021
-		t.tm_mon = mt - 1;
-		t.tm_mday = dy;
-		t.tm_hour = hr;
-		t.tm_min = mn;
-		t.tm_sec = sc;
-		time_t timeSinceEpoch = mktime( &t );
-		rtc_set( timeSinceEpoch, ms );
-	}
-
-	//-------------------------------------------------------------------------------
-	void rtc_set(unsigned long epoch, int ms)
-	{
-		struct timeval tv;
-		if (epoch > 2082758399){
-			esp::flags.rtc_overflow = 1;
-			tv.tv_sec = epoch - 2082758399;  // epoch time (seconds)
-		} else {
-			esp::flags.rtc_overflow = 0;
-			tv.tv_sec = epoch;  // epoch time (seconds)
-		}
-		tv.tv_usec = ms;    // microseconds
-		settimeofday( &tv, NULL );
-	}
-
-	//-------------------------------------------------------------------------------
-	struct tm* rtc_getDateTime(void)
-	{
-		struct tm timeinfo;
-		time_t now;
-		time( &now );
-		localtime_r( &now, &timeinfo );
-		time_t tt = mktime( &timeinfo );
-		if( esp::flags.rtc_overflow ){
-			tt += 63071999;
-		}
-		if( esp::rtc_offset > 0){
-			tt += (unsigned int) esp::rtc_offset;
-		} else {
-			tt -= (unsigned int) (esp::rtc_offset * -1);
-		}
-		struct tm* tn = localtime( &tt );
-		if ( esp::flags.rtc_overflow ){
-			tn->tm_year += 64;
-		}
-		return tn;
-	}
-#endif
-	//-------------------------------------------------------------------------------
-}
+//------------ Includes -----------------------------------------------------------------
+#include "esp_functions.h"
+
+#if defined(ARDUINO_ARCH_ESP8266)
+	#include <LittleFS.h>
+	#include <ESP8266WiFi.h>
+	#include <ESP8266HTTPClient.h>
+	#include <WiFiClient.h>
+	#include <bearssl/bearssl_hash.h>
+	#ifdef ESP_UPDATE_PUBLIC_KEY
+		#error "Ed25519 update manifest signature is supported at ESP32 only"
+	#endif
+#elif defined(ARDUINO_ARCH_ESP32)
+	#include <SPIFFS.h>
+	#include <HTTPClient.h>
+	#include <Update.h>
+	#include <esp_wifi.h>
+	#include <rom/rtc.h>
+	#include <esp_task_wdt.h>
+	#include <mbedtls/sha256.h>
+	#include <esp_ota_ops.h>
+	#include <esp_partition.h>
+	#include <Ticker.h>
+	#ifdef ESP_UPDATE_PUBLIC_KEY
+		#include <sodium.h>
+	#endif
+#endif
+
+// Filesystem backend, may be predefined (e.g. host-side mock FS for simulation build)
+#ifndef ESP_FS
+	#if defined(ARDUINO_ARCH_ESP8266)
+		#define ESP_FS							LittleFS
+	#elif defined(ARDUINO_ARCH_ESP32)
+		#define ESP_FS							SPIFFS
+	#endif
+#endif
+
+//-------------------------------------------------------------------------------
+namespace esp {
+	//-------------------------------------------------------------------------------
+	Flags flags;
+	AuthStats authStats;
+	WebCacheStats webCacheStats;
+	int8_t countNetworks;
+	ScanResult scanResults[ ESP_WIFI_SCAN_MAX ];
+	uint8_t scanCount = 0;
+	uint32_t scanTime = 0;
+	const char* pageTop = nullptr;
+	const char* pageEndTop = nullptr;
+	const char* pageBottom = nullptr;
+	char* pageBuff = nullptr;
+	char tmpVal[ 11 ];
+	char systemLogin[ 16 ];
+	char systemPassword[ 16 ];
+	char updateKey[ 32 ];
+	char hostName[ 32 ];
+	uint8_t firstVersion;
+	uint8_t secondVersion;
+	uint16_t thridVersion;
+	int rtc_offset;
+	Data app;
+	static Data appSaved;									// last persisted copy of app
+	static uint32_t settingsFlushTime = 0;
+	static bool settingsDirty = false;
+	File updateFile;
+	uint16_t can_speed;
+#if defined(ARDUINO_ARCH_ESP32)
+	CanStats canStats;
+#endif
+	DownloadProgressCallback downloadProgressCb = nullptr;
+	UpdateManifest updateManifest;
+	KvStats kvStats;
+	StaStatus staStatus;
+	PromiscStats promiscStats;
+	HopStatus hopStatus;
+	HopChannelStats hopChannelStats[ ESP_HOP_CHANNELS_MAX ];
+	MacTableStats macTableStats;
+	ProvisionStats provisionStats;
+
+	//-------------------------------------------------------------------------------
+	typedef struct {
+		uint32_t token[ 2 ];
+		uint32_t ip;
+		uint32_t expire;
+	} AuthSession;
+	typedef struct {
+		uint32_t ip;
+		uint32_t until;
+		uint32_t last;
+		uint8_t fails;
+	} AuthBackoff;
+	static AuthSession authSessions[ ESP_AUTH_SESSIONS ];
+	static AuthBackoff authBackoff[ ESP_AUTH_BACKOFF_CLIENTS ];
+	typedef struct {
+		char path[ ESP_WEB_PATH_MAX_LEN ];		// requested path
+		uint8_t* data;
+		uint32_t size;
+		uint32_t lastUse;
+		time_t mtime;
+		bool acceptGzip;						// cached for client with gzip support
+		bool gzip;								// data is <path>.gz content
+	} WebCacheEntry;
+#if ESP_WEB_CACHE_SIZE > 0
+	static WebCacheEntry webCache[ ESP_WEB_CACHE_SLOTS ];
+	static uint32_t webCacheTick = 0;
+#endif
+	static const char* webHeaderKeys[] = { "Cookie", "Accept-Encoding", "If-None-Match", "If-Modified-Since" };
+
+#if defined(ARDUINO_ARCH_ESP8266)
+	typedef br_sha256_context Sha256Context;
+#elif defined(ARDUINO_ARCH_ESP32)
+	typedef mbedtls_sha256_context Sha256Context;
+#endif
+
+	typedef struct {
+		enum{
+			HEADER,
+			CONTROL,
+			DIFF,
+			EXTRA,
+			DONE,
+		};
+		uint8_t header[ 12 ];
+		uint32_t control[ 3 ];					// diff length, extra length, old position seek
+		uint32_t newSize;
+		uint32_t produced;
+		uint32_t oldPos;
+		uint32_t remain;
+		uint8_t field;
+		uint8_t state;
+	} PatchState;
+
+	typedef struct {
+		uint32_t magic;
+		uint16_t schema;
+		uint16_t reserved;
+		uint32_t length;
+		uint32_t sequence;
+		uint32_t crc;							// header before crc + data
+	} SettingsHeader;
+
+	typedef struct {
+		uint8_t keyLen;
+		uint8_t flags;
+		uint16_t length;
+		uint32_t crc;							// header before crc + key + value
+	} KvRecord;
+	typedef struct {
+		uint32_t hash;
+		uint32_t offset;						// ESP_KV_EMPTY - free slot
+		uint32_t size;							// record size
+	} KvIndexEntry;
+	static IPAddress apIp;
+	static IPAddress apGateway;
+	static IPAddress apMask;
+	static bool staFallback = false;
+	static bool staUseCache = true;
+	static bool scanRunning = false;
+	static uint8_t staNet = 0;
+	static int8_t staScore[ ESP_STA_NETWORKS ];			// past success of networks
+	static bool staRoamScan = false;
+	static uint32_t staRoamCheckTime = 0;
+	static uint32_t staRoamScanTime = 0;
+	static bool staSdkReconnect = false;			// SDK auto reconnect drives STA, state machine only follows it
+
+	static PromiscFrame promiscRing[ ESP_PROMISC_SLOTS ];
+	static uint32_t promiscHead = 0;				// written by producer only
+	static uint32_t promiscTail = 0;				// written by consumer only
+	static uint32_t promiscFilter = ESP_PROMISC_FILTER;
+	static wifi_promiscuous_cb_t promiscUserCb = nullptr;
+	static uint32_t hopFrames = 0;					// frames of all channels, written by callback
+	static uint32_t hopFramesStart = 0;
+	static uint16_t hopChannels = 0;				// bit per channel, 0 - hopping is off
+	static uint32_t hopStart = 0;
+	static uint32_t hopDwell = 0;
+	static MacStats macTable[ ESP_MAC_TABLE_SIZE ];	// packets = 0 - free slot
+	static uint32_t macTableAgeTime = 0;
+	static bool provWindow = false;					// raw configuration window after reset
+	static volatile bool provBusy = false;			// provisioning message is being received
+	static volatile bool restartPending = false;	// restart requested from WiFi driver context, done by esp::handle()
+#if defined(ARDUINO_ARCH_ESP32)
+	static Ticker doubleResetTicker;
+#endif
+	static uint32_t provSession = 0;
+	static uint32_t provTime = 0;
+	static uint16_t provMask = 0;					// received chunks
+	static uint8_t provCount = 0;
+	static uint8_t provTotal = 0;
+	static uint8_t provBuff[ ESP_PROV_MAX_LEN ];
+
+	static KvIndexEntry kvIndex[ ESP_KV_INDEX_SIZE ];
+	static uint32_t kvLogSize = 0;
+	static uint32_t kvLiveSize = 0;
+
+	static uint32_t downloadFailTime = 0;
+	static uint32_t downloadBackoff = 0;			// ms, 0 - last download succeeded
+
+	static WebCacheEntry* webCacheFind(const char* fileName, const bool acceptGzip);
+	static WebCacheEntry* webCachePut(const char* fileName, const bool acceptGzip, const bool gzip, const time_t mtime, File &f);
+
+	//-------------------------------------------------------------------------------
+	static uint32_t getRandom(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		return ESP.random();
+#elif defined(ARDUINO_ARCH_ESP32)
+		return esp_random();
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Find session by cookie value, returns nullptr if not found or expired
+#if defined(ARDUINO_ARCH_ESP8266)
+	static AuthSession* findAuthSession(ESP8266WebServer *webServer, const uint32_t ip, const uint32_t now)
+#elif defined(ARDUINO_ARCH_ESP32)
+	static AuthSession* findAuthSession(WebServer *webServer, const uint32_t ip, const uint32_t now)
+#endif
+	{
+		if( !webServer->hasHeader( "Cookie" ) ) return nullptr;
+
+		const String &cookie = webServer->header( "Cookie" );
+		int pos = cookie.indexOf( ESP_AUTH_COOKIE_NAME "=" );
+		if( pos < 0 ) return nullptr;
+		pos += sizeof( ESP_AUTH_COOKIE_NAME );
+		if( cookie.length() < (unsigned int)pos + 16 ) return nullptr;
+
+		char hex[ 9 ];
+		uint32_t token[ 2 ];
+		for( uint8_t i = 0; i < 2; i++ ){
+			memcpy( hex, cookie.c_str() + pos + i * 8, 8 );
+			hex[ 8 ] = '\0';
+			token[ i ] = strtoul( hex, nullptr, 16 );
+		}
+
+		for( uint8_t i = 0; i < ESP_AUTH_SESSIONS; i++ ){
+			AuthSession &session = esp::authSessions[ i ];
+			if( session.ip != ip || session.token[ 0 ] != token[ 0 ] || session.token[ 1 ] != token[ 1 ] ) continue;
+			if( (int32_t)( session.expire - now ) <= 0 ) return nullptr;
+			return &session;
+		}
+
+		return nullptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Get backoff slot for client, oldest slot is reused if table is full
+	static AuthBackoff* getAuthBackoff(const uint32_t ip, bool create)
+	{
+		AuthBackoff* oldest = &esp::authBackoff[ 0 ];
+		for( uint8_t i = 0; i < ESP_AUTH_BACKOFF_CLIENTS; i++ ){
+			AuthBackoff &item = esp::authBackoff[ i ];
+			if( item.ip == ip ) return &item;
+			if( item.ip == 0 || (int32_t)( item.last - oldest->last ) < 0 ) oldest = &item;
+		}
+		if( !create ) return nullptr;
+
+		memset( oldest, 0, sizeof( AuthBackoff ) );
+		oldest->ip = ip;
+		return oldest;
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	uint8_t checkWebAuth(ESP8266WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess)
+#elif defined(ARDUINO_ARCH_ESP32)
+	uint8_t checkWebAuth(WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess)
+#endif
+	{
+		uint32_t now = millis();
+		uint32_t ip = (uint32_t)webServer->client().remoteIP();
+
+		AuthSession* session = esp::findAuthSession( webServer, ip, now );
+		if( session != nullptr ){
+			session->expire = now + ESP_AUTH_SESSION_TIMEOUT * 1000UL;
+			esp::authStats.sessionHits++;
+			esp::authStats.accepted++;
+			return 1;
+		}
+
+		AuthBackoff* backoff = esp::getAuthBackoff( ip, false );
+		if( backoff != nullptr && (int32_t)( backoff->until - now ) > 0 ){
+			ESP_DEBUG( "ESP: Auth throttled for %s\n", webServer->client().remoteIP().toString().c_str() );
+			esp::authStats.throttled++;
+			utoa( ( backoff->until - now ) / 1000 + 1, esp::tmpVal, 10 );
+			webServer->sendHeader( "Retry-After", esp::tmpVal );
+			webServer->send( 429, "text/plain", failMess );
+			return 0;
+		}
+
+		if( !webServer->authenticate( user, password ) ){
+			// first request of digest handshake has no credentials, it is not an attempt
+			if( webServer->hasHeader( "Authorization" ) ){
+				esp::authStats.rejected++;
+				backoff = esp::getAuthBackoff( ip, true );
+				backoff->last = now;
+				if( backoff->fails < 0xFF ) backoff->fails++;
+				if( backoff->fails >= ESP_AUTH_FREE_ATTEMPTS ){
+					uint8_t shift = backoff->fails - ESP_AUTH_FREE_ATTEMPTS;
+					uint32_t wait = ( shift < 16 ) ? ( 1000UL << shift ) : ESP_AUTH_BACKOFF_MAX;
+					backoff->until = now + ( ( wait > ESP_AUTH_BACKOFF_MAX ) ? ESP_AUTH_BACKOFF_MAX : wait );
+				}
+			}
+			webServer->requestAuthentication( DIGEST_AUTH, realm, failMess );
+			return 0;
+		}
+
+		if( backoff != nullptr ) memset( backoff, 0, sizeof( AuthBackoff ) );
+
+		// open new session in free, expired or oldest slot
+		session = &esp::authSessions[ 0 ];
+		for( uint8_t i = 0; i < ESP_AUTH_SESSIONS; i++ ){
+			if( (int32_t)( esp::authSessions[ i ].expire - session->expire ) < 0 ) session = &esp::authSessions[ i ];
+		}
+		session->token[ 0 ] = esp::getRandom();
+		session->token[ 1 ] = esp::getRandom();
+		session->ip = ip;
+		session->expire = now + ESP_AUTH_SESSION_TIMEOUT * 1000UL;
+
+		char cookie[ sizeof( ESP_AUTH_COOKIE_NAME ) + 64 ];
+		snprintf( cookie, sizeof( cookie ), ESP_AUTH_COOKIE_NAME "=%08lx%08lx; Max-Age=%u; Path=/; HttpOnly", (unsigned long)session->token[ 0 ], (unsigned long)session->token[ 1 ], ESP_AUTH_SESSION_TIMEOUT );
+		webServer->sendHeader( "Set-Cookie", cookie );
+		esp::authStats.accepted++;
+
+		return 1;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Mounts ESP_FS, formats it on ESP32 if mount fails
+	static bool fsBegin(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		return ESP_FS.begin();
+#elif defined(ARDUINO_ARCH_ESP32)
+		return ESP_FS.begin( true );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Total and used bytes of ESP_FS
+	static bool fsInfo(uint64_t &total, uint64_t &used)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		FSInfo64 info;
+		if( !ESP_FS.info64( info ) ) return false;
+		total = info.totalBytes;
+		used = info.usedBytes;
+#elif defined(ARDUINO_ARCH_ESP32)
+		total = ESP_FS.totalBytes();
+		used = ESP_FS.usedBytes();
+#endif
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Reboot, settings deferred by ESP_SETTINGS_FLUSH_DELAY are written first
+	static void restart(void)
+	{
+		if( esp::settingsDirty ) esp::flushSystemSettings();
+		ESP.restart();
+	}
+
+	//-------------------------------------------------------------------------------
+	void removeFile(const char* file)
+	{
+		if( !esp::flags.useFS ) return;
+		esp::webCacheInvalidate( file );
+		if( esp::isFileExists( file ) ){
+			ESP_FS.remove( file );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void setWebRedirect(ESP8266WebServer *webServer, const String &target)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void setWebRedirect(WebServer *webServer, const String &target)
+#endif
+	{
+		String location = "http://" + target;
+		ESP_DEBUG( "WEB Redirect to [%s]\n", location.c_str() );
+
+		if( target == "" ) return;
+
+		// String location = "http://" + webServer->client().localIP().toString();
+		webServer->sendHeader( "Location", location, true );
+		webServer->send ( 302, "text/plain", "" );
+		webServer->client().stop();
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t isWiFiConnection(void)
+	{
+		uint8_t state = 0;
+		if( WiFi.status() == WL_CONNECTED ){
+			state = ( WiFi.localIP().toString() == "0.0.0.0" ) ? 0 : 1 ;
+		}
+		return state;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t getMyID(void)
+	{
+		#if defined(ARDUINO_ARCH_AVR)
+			uint32_t _id =
+				(uint32_t)boot_signature_byte_get(0x13) << 24 |
+				(uint32_t)boot_signature_byte_get(0x15) << 16 |
+				(uint32_t)boot_signature_byte_get(0x16) << 8 |
+				(uint32_t)boot_signature_byte_get(0x17);
+			return _id;
+		#elif defined(ARDUINO_ARCH_ESP8266)
+			return ESP.getChipId();
+		#elif defined(ARDUINO_ARCH_ESP32)
+			uint32_t _id = (uint32_t)((uint64_t)ESP.getEfuseMac() >> 16);
+			return ((((_id)&0xff000000) >> 24) | (((_id)&0x00ff0000) >> 8) | (((_id)&0x0000ff00) << 8) | (((_id)&0x000000ff) << 24)); // swap bits
+		#endif
+		return 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool wifi_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask)
+	{
+		ESP_DEBUG( "ESP: WiFi init at mode %u\n", esp::app.mode );
+
+		esp::apIp = ip;
+		esp::apGateway = gateway;
+		esp::apMask = mask;
+
+		if( esp::app.mode == esp::Mode::STA ){
+			return wifi_STA_init();
+		}else if( esp::app.mode == esp::Mode::AP ){
+			return wifi_AP_init(ip, gateway, mask );
+		}
+
+		return false;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool wifi_AP_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask)
+	{
+		ESP_DEBUG( "ESP: AP MODE INIT...\n" );
+
+		WiFi.disconnect();
+		WiFi.hostname( esp::hostName );
+		WiFi.mode( WiFiMode_t::WIFI_AP );
+		WiFi.persistent( false );
+
+		bool res = WiFi.softAP( esp::app.ap_ssid, esp::app.ap_key );
+#if defined(ARDUINO_ARCH_ESP8266)
+	
+#elif defined(ARDUINO_ARCH_ESP32)
+		WiFi.softAPConfig( ip, gateway, mask );
+#endif
+
+		ESP_DEBUG( "ESP: wifi_AP_init IP: %s SSID: %s HOSTNAME: %s\n", WiFi.softAPIP().toString().c_str(), WiFi.softAPSSID().c_str(), esp::hostName );
+
+		// AP is available at once, results are collected by esp::handle()
+		esp::startWiFiScan();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool startWiFiScan(void)
+	{
+		if( esp::scanRunning ) return true;
+
+		int8_t res = WiFi.scanNetworks( true );
+		esp::scanRunning = ( res == WIFI_SCAN_RUNNING );
+		ESP_DEBUG( "ESP: WiFi scan start %d\n", res );
+
+		return esp::scanRunning;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Collect async scan results, called from esp::handle() and readers of results
+	static void scanHandle(void)
+	{
+		if( !esp::scanRunning ) return;
+
+		int16_t count = WiFi.scanComplete();
+		if( count == WIFI_SCAN_RUNNING ) return;
+		esp::scanRunning = false;
+		if( count < 0 ){
+			ESP_DEBUG( "ESP: WiFi scan error %d\n", count );
+			return;
+		}
+
+		esp::countNetworks = ( count > 127 ) ? 127 : count;
+		esp::scanCount = 0;
+		for( int16_t i = 0; i < count; i++ ){
+			// keep strongest networks if there are more than ESP_WIFI_SCAN_MAX
+			int8_t rssi = WiFi.RSSI( i );
+			uint8_t slot = esp::scanCount;
+			if( esp::scanCount == ESP_WIFI_SCAN_MAX ){
+				slot = 0;
+				for( uint8_t j = 1; j < ESP_WIFI_SCAN_MAX; j++ ){
+					if( esp::scanResults[ j ].rssi < esp::scanResults[ slot ].rssi ) slot = j;
+				}
+				if( esp::scanResults[ slot ].rssi >= rssi ) continue;
+			}else{
+				esp::scanCount++;
+			}
+			ScanResult &res = esp::scanResults[ slot ];
+			strncpy( res.ssid, WiFi.SSID( i ).c_str(), sizeof( res.ssid ) - 1 );
+			res.ssid[ sizeof( res.ssid ) - 1 ] = '\0';
+			res.rssi = rssi;
+			res.channel = WiFi.channel( i );
+			uint8_t* bssid = WiFi.BSSID( i );
+			if( bssid != nullptr ) memcpy( res.bssid, bssid, sizeof( res.bssid ) );
+			res.auth = WiFi.encryptionType( i );
+		}
+		WiFi.scanDelete();
+		esp::scanTime = millis();
+
+		ESP_DEBUG( "ESP: WiFi scan found %d networks\n", count );
+	}
+
+	//-------------------------------------------------------------------------------
+	int8_t getCountNetworks(void)
+	{
+		esp::scanHandle();
+		return esp::countNetworks;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Change STA state machine state
+	static void staSetState(const uint8_t state)
+	{
+		esp::staStatus.state = state;
+		esp::staStatus.stateTime = millis();
+	}
+
+	//-------------------------------------------------------------------------------
+	// Forget BSSID/channel/IP of last connection
+	static void staClearCache(void)
+	{
+		memset( esp::app.sta_bssid, 0, sizeof( esp::app.sta_bssid ) );
+		esp::app.sta_channel = 0;
+		esp::app.sta_net = 0;
+		esp::app.sta_ip = 0;
+		esp::app.sta_gateway = 0;
+		esp::app.sta_mask = 0;
+		esp::app.sta_dns = 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Remember BSSID/channel/IP of current connection, written only if changed
+	static void staSaveCache(void)
+	{
+		Data prev;
+		memcpy( &prev, &esp::app, sizeof( Data ) );
+
+		uint8_t* bssid = WiFi.BSSID();
+		if( bssid != nullptr ) memcpy( esp::app.sta_bssid, bssid, sizeof( esp::app.sta_bssid ) );
+		esp::app.sta_channel = WiFi.channel();
+		esp::app.sta_net = esp::staNet;
+#if defined(ARDUINO_ARCH_ESP32)
+		esp::app.sta_ip = (uint32_t)WiFi.localIP();
+		esp::app.sta_gateway = (uint32_t)WiFi.gatewayIP();
+		esp::app.sta_mask = (uint32_t)WiFi.subnetMask();
+		esp::app.sta_dns = (uint32_t)WiFi.dnsIP();
+#endif
+
+		if( memcmp( &prev, &esp::app, sizeof( Data ) ) != 0 ) esp::saveSystemSettings();
+	}
+
+	//-------------------------------------------------------------------------------
+	// STA credentials by index, 0 - sta_ssid/sta_key
+	static char* staSsid(const uint8_t net)
+	{
+		return ( net == 0 ) ? esp::app.sta_ssid : esp::app.sta_extra[ net - 1 ].ssid;
+	}
+
+	//-------------------------------------------------------------------------------
+	static char* staKey(const uint8_t net)
+	{
+		return ( net == 0 ) ? esp::app.sta_key : esp::app.sta_extra[ net - 1 ].key;
+	}
+
+	//-------------------------------------------------------------------------------
+	// true if more than one network is configured
+	static bool staMultiple(void)
+	{
+		for( uint8_t i = 1; i < ESP_STA_NETWORKS; i++ ){
+			if( esp::staSsid( i )[ 0 ] != '\0' ) return true;
+		}
+		return false;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Best visible AP of configured networks by RSSI and past success, nullptr if none
+	static const ScanResult* staSelect(uint8_t &net)
+	{
+		const ScanResult* best = nullptr;
+		int16_t bestScore = INT16_MIN;
+		for( uint8_t i = 0; i < esp::scanCount; i++ ){
+			const ScanResult &res = esp::scanResults[ i ];
+			for( uint8_t n = 0; n < ESP_STA_NETWORKS; n++ ){
+				if( esp::staSsid( n )[ 0 ] == '\0' || strcmp( res.ssid, esp::staSsid( n ) ) != 0 ) continue;
+				int16_t score = res.rssi + esp::staScore[ n ] * ESP_STA_SUCCESS_BONUS;
+				if( score > bestScore ){
+					bestScore = score;
+					best = &res;
+					net = n;
+				}
+			}
+		}
+		return best;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Connect to network, channel 0 / bssid nullptr - any AP of network
+	static void staConnect(const uint8_t net, const uint8_t channel, const uint8_t* bssid)
+	{
+		ESP_DEBUG( "ESP: WiFi connecting to %s (ch %u)...\n", esp::staSsid( net ), channel );
+		esp::staNet = net;
+		esp::staStatus.network = net;
+		WiFi.begin( esp::staSsid( net ), esp::staKey( net ), channel, bssid );
+		esp::staSetState( esp::StaState::CONNECTING );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Connect to best network from fresh scan results, next configured network if nothing is visible
+	static void staConnectBest(void)
+	{
+		uint8_t net = 0;
+		const ScanResult* target = esp::staSelect( net );
+		if( target != nullptr ){
+			esp::staConnect( net, target->channel, target->bssid );
+			return;
+		}
+		// hidden networks are not in scan results
+		net = esp::staNet;
+		do{
+			net = ( net + 1 ) % ESP_STA_NETWORKS;
+		}while( esp::staSsid( net )[ 0 ] == '\0' && net != esp::staNet );
+		esp::staConnect( net, 0, nullptr );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Start one connection attempt, cached BSSID/channel skips full scan
+	static void staBegin(void)
+	{
+		esp::staStatus.attempts++;
+		esp::staStatus.fastConnect = esp::staUseCache && esp::app.sta_channel != 0 && esp::app.sta_net < ESP_STA_NETWORKS && esp::staSsid( esp::app.sta_net )[ 0 ] != '\0';
+		if( esp::staStatus.fastConnect ){
+#if defined(ARDUINO_ARCH_ESP32)
+			if( esp::app.sta_ip != 0 ) WiFi.config( IPAddress( esp::app.sta_ip ), IPAddress( esp::app.sta_gateway ), IPAddress( esp::app.sta_mask ), IPAddress( esp::app.sta_dns ) );
+#endif
+			esp::staConnect( esp::app.sta_net, esp::app.sta_channel, esp::app.sta_bssid );
+			return;
+		}
+#if defined(ARDUINO_ARCH_ESP32)
+		// back to DHCP
+		WiFi.config( IPAddress( (uint32_t)0 ), IPAddress( (uint32_t)0 ), IPAddress( (uint32_t)0 ) );
+#endif
+		if( !esp::staMultiple() ){
+			esp::staConnect( 0, 0, nullptr );
+		}else if( esp::scanTime != 0 && millis() - esp::scanTime < ESP_STA_SCAN_MAX_AGE && !esp::scanRunning ){
+			esp::staConnectBest();
+		}else if( esp::startWiFiScan() ){
+			esp::staSetState( esp::StaState::SCANNING );
+		}else{
+			esp::staConnectBest();
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Check signal of current AP, scan and move to better one if it is weak
+	static void staRoam(const uint32_t now)
+	{
+		if( ESP_STA_ROAM_RSSI == 0 || esp::staSdkReconnect ) return;
+
+		if( !esp::staRoamScan ){
+			if( now - esp::staRoamCheckTime < ESP_STA_ROAM_CHECK_INTERVAL ) return;
+			esp::staRoamCheckTime = now;
+			if( WiFi.RSSI() >= ESP_STA_ROAM_RSSI || now - esp::staRoamScanTime < ESP_STA_ROAM_INTERVAL ) return;
+			esp::staRoamScanTime = now;
+			esp::staRoamScan = esp::startWiFiScan();
+			return;
+		}
+		if( esp::scanRunning ) return;
+		esp::staRoamScan = false;
+
+		uint8_t net = 0;
+		const ScanResult* target = esp::staSelect( net );
+		uint8_t* bssid = WiFi.BSSID();
+		int32_t rssi = WiFi.RSSI();
+		if( target == nullptr || ( bssid != nullptr && memcmp( target->bssid, bssid, 6 ) == 0 ) || target->rssi < rssi + ESP_STA_ROAM_HYSTERESIS ) return;
+
+		ESP_DEBUG( "ESP: WiFi roam %d dBm -> %s %d dBm\n", rssi, target->ssid, target->rssi );
+		esp::staStatus.roams++;
+		esp::staStatus.connectStart = now;
+		esp::staStatus.attempts = 1;
+		esp::staStatus.fastConnect = false;
+#if defined(ARDUINO_ARCH_ESP32)
+		WiFi.config( IPAddress( (uint32_t)0 ), IPAddress( (uint32_t)0 ), IPAddress( (uint32_t)0 ) );
+#endif
+		esp::staConnect( net, target->channel, target->bssid );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Start AP beside STA while STA can not connect
+	static void staFallbackAP(const bool enable)
+	{
+		if( esp::staFallback == enable ) return;
+		esp::staFallback = enable;
+		ESP_DEBUG( "ESP: STA fallback AP %s\n", ( enable ) ? "ON" : "OFF" );
+
+		if( enable ){
+			WiFi.mode( WiFiMode_t::WIFI_AP_STA );
+			WiFi.softAP( esp::app.ap_ssid, esp::app.ap_key );
+#if defined(ARDUINO_ARCH_ESP32)
+			if( (uint32_t)esp::apIp != 0 ) WiFi.softAPConfig( esp::apIp, esp::apGateway, esp::apMask );
+#endif
+		}else{
+			WiFi.softAPdisconnect( true );
+			WiFi.mode( WiFiMode_t::WIFI_STA );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Advance STA state machine, called from esp::handle()
+	static void staHandle(void)
+	{
+		if( esp::staStatus.state == esp::StaState::IDLE ) return;
+
+		uint32_t now = millis();
+		uint32_t elapsed = now - esp::staStatus.stateTime;
+		wl_status_t status = WiFi.status();
+
+		switch( esp::staStatus.state ){
+			case esp::StaState::CONNECTING:
+				if( status == WL_CONNECTED ){
+					esp::staStatus.assocTime = elapsed;
+					esp::staStatus.connectTime = now - esp::staStatus.connectStart;
+					if( esp::staStatus.connects++ == 0 ) esp::staStatus.bootConnectTime = now;
+					ESP_DEBUG( "ESP: WiFi connected in %lu ms (assoc %lu ms%s), attempts: %u\n", (unsigned long)esp::staStatus.connectTime, (unsigned long)elapsed, ( esp::staStatus.fastConnect ) ? ", fast" : "", esp::staStatus.attempts );
+					if( esp::staScore[ esp::staNet ] < ESP_STA_SCORE_MAX ) esp::staScore[ esp::staNet ]++;
+					esp::staStatus.attempts = 0;
+					esp::staRoamCheckTime = now;
+					esp::staUseCache = true;
+					esp::staSetState( esp::StaState::CONNECTED );
+					esp::staFallbackAP( false );
+					esp::staSaveCache();
+				}else if( esp::staSdkReconnect ){
+					// SDK keeps trying, no timeout
+				}else if( elapsed >= ESP_STA_CONNECT_TIMEOUT || status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ){
+					ESP_DEBUG( "ESP: WiFi connect error %u\n", status );
+					WiFi.disconnect();
+					if( esp::staScore[ esp::staNet ] > -ESP_STA_SCORE_MAX ) esp::staScore[ esp::staNet ]--;
+					if( esp::staStatus.fastConnect ){
+						// AP moved or lease changed, retry at once with full scan and DHCP
+						esp::staUseCache = false;
+						esp::staStatus.attempts--;
+						esp::staBegin();
+					}else if( esp::staStatus.attempts >= ESP_STA_MAX_ATTEMPTS ){
+						esp::staSetState( esp::StaState::FAILED );
+						if( ESP_STA_AP_FALLBACK ) esp::staFallbackAP( true );
+					}else{
+						esp::staSetState( esp::StaState::BACKOFF );
+					}
+				}
+				break;
+			case esp::StaState::CONNECTED:
+				if( status != WL_CONNECTED ){
+					ESP_DEBUG( "ESP: WiFi connection lost\n" );
+					esp::staStatus.disconnects++;
+					esp::staStatus.connectStart = now;
+					esp::staRoamScan = false;
+					if( esp::staSdkReconnect ){
+						esp::staStatus.attempts = 1;
+						esp::staSetState( esp::StaState::CONNECTING );
+					}else{
+						esp::staBegin();
+					}
+				}else{
+					esp::staRoam( now );
+				}
+				break;
+			case esp::StaState::SCANNING:
+				if( !esp::scanRunning ) esp::staConnectBest();
+				break;
+			case esp::StaState::BACKOFF:{
+				uint32_t backoff = ESP_STA_BACKOFF_MIN << ( esp::staStatus.attempts - 1 );
+				if( esp::staStatus.attempts > 16 || backoff > ESP_STA_BACKOFF_MAX ) backoff = ESP_STA_BACKOFF_MAX;
+				if( elapsed >= backoff ) esp::staBegin();
+			} break;
+			case esp::StaState::FAILED:
+				// keep trying with max backoff, fallback AP stays up until connection
+				if( elapsed >= ESP_STA_BACKOFF_MAX ) esp::staBegin();
+				break;
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	bool wifi_STA_init()
+	{
+		ESP_DEBUG( "ESP: STA MODE INIT...\n" );
+
+		WiFi.softAPdisconnect( true );
+		WiFi.mode( WiFiMode_t::WIFI_STA );
+		// only one reconnect driver: esp::handle(), SDK takes over after blocking wait
+		WiFi.setAutoReconnect( false );
+		WiFi.setAutoConnect( false );
+		WiFi.persistent( false );
+		WiFi.hostname( esp::hostName );
+
+		esp::staFallback = false;
+		esp::staUseCache = true;
+		esp::staRoamScan = false;
+		esp::staSdkReconnect = false;
+		esp::staStatus.attempts = 0;
+		esp::staStatus.connectStart = millis();
+		esp::staBegin();
+
+#if ESP_STA_ASYNC == 0
+		// previous contract: wait for connection, false lets sketch start its own fallback
+		while( esp::staStatus.state != esp::StaState::CONNECTED && millis() - esp::staStatus.connectStart < ESP_STA_BLOCKING_TIMEOUT ){
+			delay( 10 );
+			esp::scanHandle();
+			esp::staHandle();
+		}
+		// sketch may not call esp::handle(), from now SDK reconnects
+		if( esp::staStatus.state != esp::StaState::CONNECTED && esp::staStatus.state != esp::StaState::CONNECTING ) esp::staConnectBest();
+		esp::staSdkReconnect = true;
+		WiFi.setAutoReconnect( true );
+		return esp::staStatus.state == esp::StaState::CONNECTED;
+#else
+		return true;
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void setNoCacheContent(ESP8266WebServer *webServer)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void setNoCacheContent(WebServer *webServer)
+#endif
+	{
+		webServer->sendHeader( "Cache-Control", "no-cache, no-store, must-revalidate" );
+		webServer->sendHeader( "Pragma", "no-cache" );
+		webServer->sendHeader( "Expires", "-1" );
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void addWebServerPages(ESP8266WebServer *webServer, bool wifiConfig, bool notFound)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void addWebServerPages(WebServer *webServer, bool wifiConfig, bool notFound)
+#endif
+	{
+		// NOTE: replaces headers collected before this call
+		webServer->collectHeaders( esp::webHeaderKeys, sizeof( esp::webHeaderKeys ) / sizeof( esp::webHeaderKeys[ 0 ] ) );
+
+		if( wifiConfig ){
+			webServer->on( "/wifi", [ webServer ](void){
+				ESP_DEBUG( "ESP: WEB /wifi\n" );
+				//if activated captive portal
+				if( esp::flags.captivePortal ){
+					esp::handleWebConfigPage( webServer );
+				}else{
+					if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
+						esp::handleWebConfigPage( webServer );
+					}
+				}
+			} );
+		}
+		if( notFound ){
+			webServer->onNotFound( [ webServer ](void){
+				String uri = webServer->uri();
+				ESP_DEBUG( "WEB 404 [%s]\n", uri.c_str() );
+				esp::handleWeb404Page( webServer );
+			} );
+		}
+
+		webServer->on( "/sysinfo", [ webServer ](void){
+			webServer->sendHeader( "Access-Control-Allow-Origin", "*" );
+
+			esp::JsonWriter json( webServer );
+			json.beginObject();
+			json.key( "cpu_freq" ).unum( ESP.getCpuFreqMHz() );
+
+			if( esp::flags.useFS ){
+				uint64_t total, used;
+				if( esp::fsInfo( total, used ) ){
+					json.key( "fs_total" ).unum( total );
+					json.key( "fs_used" ).unum( used );
+				}else{
+					json.key( "fs_total" ).num( -1 );
+					json.key( "fs_used" ).num( -1 );
+				}
+			}
+
+			json.beginObject( "sta" );
+			json.key( "state" ).unum( esp::staStatus.state );
+			json.key( "attempts" ).unum( esp::staStatus.attempts );
+			json.key( "connect_time" ).unum( esp::staStatus.connectTime );
+			json.key( "assoc_time" ).unum( esp::staStatus.assocTime );
+			json.key( "fast_connect" ).boolean( esp::staStatus.fastConnect );
+			json.key( "network" ).unum( esp::staStatus.network );
+			json.key( "roams" ).unum( esp::staStatus.roams );
+			json.key( "boot_connect_time" ).unum( esp::staStatus.bootConnectTime );
+			json.key( "connects" ).unum( esp::staStatus.connects );
+			json.key( "disconnects" ).unum( esp::staStatus.disconnects );
+			json.endObject();
+
+			json.beginObject( "web_cache" );
+			json.key( "hits" ).unum( esp::webCacheStats.hits );
+			json.key( "misses" ).unum( esp::webCacheStats.misses );
+			json.key( "evictions" ).unum( esp::webCacheStats.evictions );
+			json.key( "used" ).unum( esp::webCacheStats.used );
+			json.endObject();
+
+			json.key( "mode" ).unum( esp::app.mode );
+			json.beginArray( "version" ).unum( esp::firstVersion ).unum( esp::secondVersion ).unum( esp::thridVersion ).endArray();
+			json.endObject();
+			json.end();
+		} );
+
+		webServer->on( "/favicon.ico", [ webServer ](void){
+			esp::webSendFile( webServer, "/favicon.ico", "image/x-icon" );
+		} );
+		
+		webServer->on( "/index.css", [ webServer ](void){
+			esp::webSendFile( webServer, "/index.css", "text/css" );
+		} );
+		webServer->on( "/index.js", [ webServer ](void){
+			esp::webSendFile( webServer, "/index.js", "text/javascript" );
+		} );
+
+		webServer->on( "/format", [ webServer ](void){
+			if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
+				esp::webCacheInvalidate();
+				bool res = ESP_FS.format();
+				esp::kvInit();
+				if( res ){
+					webServer->send( 200, "application/json", "{ \"result\": \"OK\" }" );
+				}else{
+					webServer->send( 500, "application/json", "{ \"result\": \"ERROR\" }" );
+				}
+			}else{
+				webServer->send( 403, "application/json", "{ \"result\": \"access denied\" }" );
+			}
+		} );
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void addWebUpdate(ESP8266WebServer *webServer, const char* key)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void addWebUpdate(WebServer *webServer, const char* key)
+#endif
+	{
+		strcpy( esp::updateKey, key );
+		webServer->on( "/update", HTTP_POST, [ webServer ](void){
+			webServer->sendHeader( "Connection", "close" );
+    		webServer->send( 200, "text/plain", ( Update.hasError() ) ? "FAIL" : "OK" );
+			if( !esp::flags.updateError && esp::flags.updateFirmware ){
+				delay( 1000 );
+				esp::restart();
+			}
+		}, [ webServer ](void){
+			// webServer->sendHeader( "Access-Control-Allow-Origin", "*" );
+			// if( esp::checkWebAuth( webServer, esp::systemLogin, esp::systemPassword, ESP_AUTH_REALM, "access denied" ) ){
+				esp::updateProcess( webServer );
+			// }else{
+				// webServer->send( 403, "text/plain", "Access denied" );
+			// }
+		} );
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void activateCaptivePortal(ESP8266WebServer *webServer, const char* captiveRedirectTarget, ESP8266WebServer::THandlerFunction cp_handler)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void activateCaptivePortal(WebServer *webServer,  const char* captiveRedirectTarget, WebServer::THandlerFunction cp_handler)
+#endif
+	{
+		String target = WiFi.softAPSSID() + ".lan";
+		if( captiveRedirectTarget != nullptr ){
+			target += captiveRedirectTarget;
+		}
+		target.toLowerCase();
+
+		// webServer->on( "/fwlink", [ webServer, target, cp_handler ](void){
+		// 	if( target != "" ){
+		// 		esp::setWebRedirect( webServer, target );
+		// 	}else if( cp_handler != nullptr ){
+		// 		cp_handler();
+		// 	}else{
+		// 		esp::webSendFile( webServer, "/portal.html", "text/html", ( !esp::flags.captivePortalAccess ) ? 200 : 204 );
+		// 	}
+		// } );
+		// webServer->on( "/generate_204", [ webServer, target, cp_handler ](void){
+		// 	if( target != "" ){
+		// 		esp::setWebRedirect( webServer, target );
+		// 	}else if( cp_handler != nullptr ){
+		// 		cp_handler();
+		// 	}else{
+		// 		esp::webSendFile( webServer, "/portal.html", "text/html", ( !esp::flags.captivePortalAccess ) ? 200 : 204 );
+		// 	}
+		// } );
+		
+		webServer->on( ESP_CAPTIVE_PORTAL_URL, [ webServer, target, cp_handler ](void){
+			if( webServer->hasArg( "cmd" ) ){
+				if( webServer->arg( "cmd" ) == "OK" ){
+					esp::flags.captivePortalAccess = 1;
+					// esp::setWebRedirect( webServer, WiFi.softAPIP().toString() + "/" );
+				}
+			}
+
+			esp::webSendFile( webServer, "/portal.html", "text/html" );
+		} );
+		webServer->onNotFound( [ webServer, target, cp_handler ](void){
+			if( esp::flags.captivePortalAccess ){
+				webServer->send( 200, "text/html", "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>" );
+			}else{
+				esp::setWebRedirect( webServer, target );
+			}
+		} );
+		esp::flags.captivePortal = 1;
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void handleWebConfigPage(ESP8266WebServer *webServer)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void handleWebConfigPage(WebServer *webServer)
+#endif
+	{
+		bool success = false;
+
+		esp::setNoCacheContent( webServer );
+		//-------------------------------------------------------------
+		if( webServer->hasArg( "cmd" ) ){
+			const String &cmd = webServer->arg( "cmd" );
+			if( cmd == "ap_config" && webServer->hasArg( "ssid" ) && webServer->hasArg( "key" ) ){
+				if( webServer->arg( "ssid" ).length() > 0 ){
+					strcpy( esp::app.ap_ssid, webServer->arg( "ssid" ).c_str() );
+					strcpy( esp::app.ap_key, webServer->arg( "key" ).c_str() );
+					esp::saveSystemSettings();
+					success = true;
+				}
+			}else if( cmd == "sta_config" && webServer->hasArg( "ssid" ) && webServer->hasArg( "key" ) ){
+				// "index" selects additional network, empty ssid removes it
+				long net = ( webServer->hasArg( "index" ) ) ? webServer->arg( "index" ).toInt() : 0;
+				if( net >= 0 && net < ESP_STA_NETWORKS && ( net > 0 || webServer->arg( "ssid" ).length() > 0 )
+					&& webServer->arg( "ssid" ).length() < ESP_CONFIG_SSID_MAX_LEN && webServer->arg( "key" ).length() < ESP_CONFIG_KEY_MAX_LEN ){
+					strcpy( esp::staSsid( net ), webServer->arg( "ssid" ).c_str() );
+					strcpy( esp::staKey( net ), webServer->arg( "key" ).c_str() );
+					esp::staScore[ net ] = 0;
+					if( net == esp::app.sta_net ) esp::staClearCache();
+					esp::saveSystemSettings();
+					success = true;
+				}
+			}else if( cmd == "other" ){
+				ESP_DEBUG( "OTHER\n" );
+				if( webServer->hasArg( "mode" ) ){
+					esp::app.mode = (uint8_t)webServer->arg( "mode" ).toInt();
+					ESP_DEBUG( "NEW MODE: %u\n", esp::app.mode );
+					esp::saveSystemSettings();
+					success = true;
+				}
+			}else if( cmd == "remove_config" && esp::flags.useFS && webServer->hasArg( "reboot" ) ){
+				esp::removeSettings( ESP_SYSTEM_CONFIG_FILE );
+				// nothing is persisted now, pending write must not restore removed file
+				memset( &esp::appSaved, 0, sizeof( Data ) );
+				esp::settingsDirty = false;
+				if( webServer->arg( "reboot" ) == "on" ){
+					// webServer->send ( 200, "text/html", "Rebooting..." );
+					webServer->send ( 200, "application/json", "{\"success\":\"true\",\"message\":\"Rebooting...\"}" );
+					delay( 1000 );
+					esp::restart();
+					return;
+				}
+			}
+		}
+		//-------------------------------------------------------------
+		// cached scan results, "refresh" starts new scan (results are ready at next request)
+		if( webServer->arg( "cmd" ) == "scan" ){
+			// sketch may not call esp::handle()
+			esp::scanHandle();
+			if( webServer->hasArg( "refresh" ) ) esp::startWiFiScan();
+
+			esp::JsonWriter json( webServer );
+			json.beginObject();
+			json.key( "running" ).boolean( esp::scanRunning );
+			json.key( "age" ).num( ( esp::scanTime ) ? (int32_t)( ( millis() - esp::scanTime ) / 1000 ) : -1 );
+			json.key( "found" ).num( esp::countNetworks );
+			json.beginArray( "networks" );
+			for( uint8_t i = 0; i < esp::scanCount; i++ ){
+				json.beginObject();
+				json.key( "ssid" ).str( esp::scanResults[ i ].ssid );
+				json.key( "rssi" ).num( esp::scanResults[ i ].rssi );
+				json.key( "channel" ).unum( esp::scanResults[ i ].channel );
+				json.key( "auth" ).unum( esp::scanResults[ i ].auth );
+				json.endObject();
+			}
+			json.endArray();
+			json.endObject();
+			json.end();
+			return;
+		}
+		//-------------------------------------------------------------
+		//if activated captive portal
+		if( esp::flags.captivePortal ){
+			esp::setWebRedirect( webServer, ESP_CAPTIVE_PORTAL_URL );
+			return;
+		}
+
+		esp::JsonWriter json( webServer );
+		json.beginObject().key( "success" ).str( ( success ) ? "true" : "false" ).endObject();
+		json.end();
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void handleWeb404Page(ESP8266WebServer *webServer)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void handleWeb404Page(WebServer *webServer)
+#endif
+	{
+		if( !esp::webSendFile( webServer, "/404.html", "text/html", 0 ) && !esp::webSendFile( webServer, "/index.html", "text/html", 0 ) ){
+			esp::ResponseWriter page( webServer );
+			page.begin( 200, "text/html" );
+			page.raw( esp::pageTop );
+			page.raw( "<title>Not found</title>" );
+			page.raw( esp::pageEndTop );
+			page.raw( "<h1>404 Not found</h1>" );
+			page.html( webServer->uri().c_str() );
+			page.raw( esp::pageBottom );
+			page.end();
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	#if defined(ARDUINO_ARCH_ESP8266)
+	uint8_t webSendFile(ESP8266WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code)
+#elif defined(ARDUINO_ARCH_ESP32)
+	uint8_t webSendFile(WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code)
+#endif
+	{
+		ESP_DEBUG( "ESPF: Http send file [%s] %s\n", fileName, mimeType );
+		uint16_t sendCode = ( code ) ? code : 200;
+		bool acceptGzip = webServer->hasHeader( "Accept-Encoding" ) && webServer->header( "Accept-Encoding" ).indexOf( "gzip" ) >= 0;
+		WebCacheEntry* cached = esp::webCacheFind( fileName, acceptGzip );
+		bool gzip = false;
+		uint32_t size = 0;
+		time_t mtime = 0;
+		File f;
+
+		if( cached != nullptr ){
+			gzip = cached->gzip;
+			size = cached->size;
+			mtime = cached->mtime;
+		}else{
+			// precompressed sibling first, one open per variant instead of exists() + open()
+			char path[ ESP_WEB_PATH_MAX_LEN ];
+			if( esp::flags.useFS && acceptGzip && strlen( fileName ) + 4 <= sizeof( path ) ){
+				strcpy( path, fileName );
+				strcat( path, ".gz" );
+				f = ESP_FS.open( path, "r" );
+				gzip = (bool)f;
+			}
+			if( !gzip && esp::flags.useFS ) f = ESP_FS.open( fileName, "r" );
+
+			if( !f || f.isDirectory() ){
+				if( f ) f.close();
+				if( code ) webServer->send( ( code == 200 ) ? 404 : code, "text/html", "File not found :(");
+				return 0;
+			}
+			size = f.size();
+			mtime = f.getLastWrite();
+			cached = esp::webCachePut( fileName, acceptGzip, gzip, mtime, f );
+			if( cached != nullptr ) f.close();
+		}
+
+		// validators from size and mtime
+		char etag[ 32 ];
+		snprintf( etag, sizeof( etag ), "\"%lx-%lx%s\"", (unsigned long)size, (unsigned long)mtime, ( gzip ) ? "-gz" : "" );
+		char lastModified[ 32 ] = { 0 };
+		if( mtime > 0 ){
+			struct tm tm;
+			gmtime_r( &mtime, &tm );
+			strftime( lastModified, sizeof( lastModified ), "%a, %d %b %Y %H:%M:%S GMT", &tm );
+		}
+
+		webServer->sendHeader( "ETag", etag );
+		if( lastModified[ 0 ] ) webServer->sendHeader( "Last-Modified", lastModified );
+		webServer->sendHeader( "Vary", "Accept-Encoding" );
+		// versioned assets (/index.js?v=...) never change, others must be revalidated
+		webServer->sendHeader( "Cache-Control", ( webServer->hasArg( "v" ) ) ? "public, max-age=31536000, immutable" : "no-cache" );
+
+		if( sendCode == 200 ){
+			bool notModified = false;
+			if( webServer->hasHeader( "If-None-Match" ) ){
+				notModified = ( webServer->header( "If-None-Match" ) == etag );
+			}else if( lastModified[ 0 ] && webServer->hasHeader( "If-Modified-Since" ) ){
+				notModified = ( webServer->header( "If-Modified-Since" ) == lastModified );
+			}
+			if( notModified ){
+				if( cached == nullptr ) f.close();
+				webServer->send( 304, mimeType, "" );
+				return 1;
+			}
+		}
+
+		if( cached != nullptr ){
+			if( gzip ) webServer->sendHeader( "Content-Encoding", "gzip" );
+			webServer->setContentLength( cached->size );
+			webServer->send( sendCode, mimeType, "" );
+			webServer->sendContent( (const char*)cached->data, cached->size );
+			return 1;
+		}
+
+#if defined(ARDUINO_ARCH_ESP8266)
+		if( gzip ) webServer->sendHeader( "Content-Encoding", "gzip" );
+		webServer->send( sendCode, mimeType, f, f.size() );
+#elif defined(ARDUINO_ARCH_ESP32)
+		// streamFile sets Content-Encoding for *.gz files itself
+		webServer->streamFile( f, mimeType, sendCode );
+#endif
+		f.close();
+
+		return 1;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Find file at RAM cache
+	static WebCacheEntry* webCacheFind(const char* fileName, const bool acceptGzip)
+	{
+#if ESP_WEB_CACHE_SIZE > 0
+		for( uint8_t i = 0; i < ESP_WEB_CACHE_SLOTS; i++ ){
+			WebCacheEntry &item = esp::webCache[ i ];
+			if( item.data != nullptr && item.acceptGzip == acceptGzip && strcmp( item.path, fileName ) == 0 ){
+				item.lastUse = ++esp::webCacheTick;
+				esp::webCacheStats.hits++;
+				return &item;
+			}
+		}
+		esp::webCacheStats.misses++;
+#endif
+		return nullptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Read opened file to RAM cache, evicts least recently used files to fit budget
+	static WebCacheEntry* webCachePut(const char* fileName, const bool acceptGzip, const bool gzip, const time_t mtime, File &f)
+	{
+#if ESP_WEB_CACHE_SIZE > 0
+		uint32_t size = f.size();
+		if( size == 0 || size > ESP_WEB_CACHE_SIZE || strlen( fileName ) >= ESP_WEB_PATH_MAX_LEN ) return nullptr;
+
+		WebCacheEntry* slot = nullptr;
+		while( true ){
+			WebCacheEntry* lru = nullptr;
+			slot = nullptr;
+			for( uint8_t i = 0; i < ESP_WEB_CACHE_SLOTS; i++ ){
+				WebCacheEntry &item = esp::webCache[ i ];
+				if( item.data == nullptr ){
+					if( slot == nullptr ) slot = &item;
+				}else if( lru == nullptr || (int32_t)( item.lastUse - lru->lastUse ) < 0 ){
+					lru = &item;
+				}
+			}
+			if( slot != nullptr && esp::webCacheStats.used + size <= ESP_WEB_CACHE_SIZE ) break;
+			if( lru == nullptr ) return nullptr;
+			esp::webCacheStats.used -= lru->size;
+			free( lru->data );
+			lru->data = nullptr;
+			esp::webCacheStats.evictions++;
+		}
+
+#if defined(ARDUINO_ARCH_ESP32)
+		uint8_t* data = (uint8_t*)( ( psramFound() ) ? ps_malloc( size ) : malloc( size ) );
+#else
+		uint8_t* data = (uint8_t*)malloc( size );
+#endif
+		if( data == nullptr ) return nullptr;
+		if( f.read( data, size ) != size ){
+			free( data );
+			f.seek( 0 );
+			return nullptr;
+		}
+
+		strcpy( slot->path, fileName );
+		slot->data = data;
+		slot->size = size;
+		slot->mtime = mtime;
+		slot->acceptGzip = acceptGzip;
+		slot->gzip = gzip;
+		slot->lastUse = ++esp::webCacheTick;
+		esp::webCacheStats.used += size;
+
+		return slot;
+#else
+		return nullptr;
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void webCacheInvalidate(const char* filepath)
+	{
+#if ESP_WEB_CACHE_SIZE > 0
+		for( uint8_t i = 0; i < ESP_WEB_CACHE_SLOTS; i++ ){
+			WebCacheEntry &item = esp::webCache[ i ];
+			if( item.data == nullptr ) continue;
+			if( filepath != nullptr ){
+				// <path> and <path>.gz are both cached under <path>
+				size_t len = strlen( item.path );
+				if( strncmp( item.path, filepath, len ) != 0 ) continue;
+				if( filepath[ len ] != '\0' && strcmp( filepath + len, ".gz" ) != 0 ) continue;
+			}
+			esp::webCacheStats.used -= item.size;
+			free( item.data );
+			item.data = nullptr;
+		}
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Read small text file from url to buffer, returns length or -1 if error,
+	// httpCode (optional) gets HTTP code or HTTPC_ERROR_* of request
+	static int32_t httpGetText(const String &url, char *buff, const size_t size, int *httpCode)
+	{
+		int32_t res = -1;
+		HTTPClient http;
+#if defined(ARDUINO_ARCH_ESP8266)
+		WiFiClient client;
+		http.begin( client, url );
+#elif defined(ARDUINO_ARCH_ESP32)
+		http.begin( url );
+#endif
+		int code = http.GET();
+		if( httpCode != nullptr ) *httpCode = code;
+		if( code == HTTP_CODE_OK ){
+			WiFiClient* stream = http.getStreamPtr();
+			int32_t len = http.getSize();
+			size_t pos = 0;
+			uint32_t lastData = millis();
+			while( pos + 1 < size && len != 0 && millis() - lastData < ESP_DOWNLOAD_TIMEOUT ){
+				int c = stream->read( (uint8_t*)buff + pos, size - 1 - pos );
+				if( c > 0 ){
+					pos += c;
+					if( len > 0 ) len = ( len > c ) ? len - c : 0;
+					lastData = millis();
+				}else if( !stream->connected() ){
+					break;
+				}else{
+					delay( 1 );
+				}
+			}
+			buff[ pos ] = '\0';
+			res = pos;
+		}
+		http.end();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	static void sha256Begin(Sha256Context &ctx)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		br_sha256_init( &ctx );
+#elif defined(ARDUINO_ARCH_ESP32)
+		mbedtls_sha256_init( &ctx );
+		mbedtls_sha256_starts( &ctx, 0 );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	static void sha256Update(Sha256Context &ctx, const uint8_t* data, const size_t len)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		br_sha256_update( &ctx, data, len );
+#elif defined(ARDUINO_ARCH_ESP32)
+		mbedtls_sha256_update( &ctx, data, len );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	static void sha256Finish(Sha256Context &ctx, uint8_t* out)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		br_sha256_out( &ctx, out );
+#elif defined(ARDUINO_ARCH_ESP32)
+		mbedtls_sha256_finish( &ctx, out );
+		mbedtls_sha256_free( &ctx );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Release context which may be unfinished (ESP32 hardware SHA engine), can be called after sha256Finish
+	static void sha256Free(Sha256Context &ctx)
+	{
+#if defined(ARDUINO_ARCH_ESP32)
+		mbedtls_sha256_free( &ctx );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Check SHA-256 of file with update manifest
+	static bool checkFileSha256(const char* filepath)
+	{
+		File f = ESP_FS.open( filepath, "r" );
+		if( !f ) return false;
+		if( esp::updateManifest.size && f.size() != esp::updateManifest.size ){
+			f.close();
+			return false;
+		}
+
+		Sha256Context ctx;
+		uint8_t buff[ 256 ];
+		esp::sha256Begin( ctx );
+		while( true ){
+			size_t c = f.read( buff, sizeof( buff ) );
+			if( c == 0 ) break;
+			esp::sha256Update( ctx, buff, c );
+			yield();
+		}
+		f.close();
+		esp::sha256Finish( ctx, buff );
+
+		return memcmp( buff, esp::updateManifest.sha256, 32 ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Hex string to bytes, all string must be converted
+	static bool hexToBytes(const char* hex, uint8_t* out, const size_t len)
+	{
+		for( size_t i = 0; i < len * 2; i++ ){
+			char c = hex[ i ];
+			uint8_t v;
+			if( c >= '0' && c <= '9' ) v = c - '0';
+			else if( c >= 'a' && c <= 'f' ) v = c - 'a' + 10;
+			else if( c >= 'A' && c <= 'F' ) v = c - 'A' + 10;
+			else return false;
+			out[ i >> 1 ] = ( i & 1 ) ? ( out[ i >> 1 ] | v ) : ( v << 4 );
+		}
+		return hex[ len * 2 ] == '\0';
+	}
+
+	//-------------------------------------------------------------------------------
+	// Strict decimal number, all string must be converted
+	static bool parseNumber(const char* str, uint32_t &value)
+	{
+		if( *str == '\0' ) return false;
+		uint64_t res = 0;
+		for( const char* p = str; *p; p++ ){
+			if( *p < '0' || *p > '9' ) return false;
+			res = res * 10 + ( *p - '0' );
+			if( res > 0xFFFFFFFF ) return false;
+		}
+		value = res;
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool parseUpdateManifest(char* text, UpdateManifest &manifest)
+	{
+		memset( &manifest, 0, sizeof( UpdateManifest ) );
+
+		// legacy format: only version number
+		char* end = text + strlen( text );
+		while( end > text && ( end[ -1 ] == '\n' || end[ -1 ] == '\r' || end[ -1 ] == ' ' ) ) *--end = '\0';
+		if( strchr( text, '=' ) == nullptr ){
+#ifdef ESP_UPDATE_PUBLIC_KEY
+			return false;
+#else
+			manifest.valid = esp::parseNumber( text, manifest.version ) && manifest.version > 0;
+			return manifest.valid;
+#endif
+		}
+
+#ifdef ESP_UPDATE_PUBLIC_KEY
+		// signature covers all manifest bytes before "sig=" line (must be last)
+		char* sig = strstr( text, "\nsig=" );
+		if( sig == nullptr ) return false;
+		uint8_t signature[ 64 ];
+		uint8_t publicKey[ 32 ];
+		if( !esp::hexToBytes( sig + 5, signature, sizeof( signature ) ) ) return false;
+		if( !esp::hexToBytes( ESP_UPDATE_PUBLIC_KEY, publicKey, sizeof( publicKey ) ) ) return false;
+		if( crypto_sign_ed25519_verify_detached( signature, (const uint8_t*)text, sig + 1 - text, publicKey ) != 0 ){
+			ESP_DEBUG( "%s:%d Manifest signature error\n", __FILE__, __LINE__ );
+			return false;
+		}
+#endif
+
+		// parse "key=value" lines in place
+		bool hasVersion = false;
+		char* line = text;
+		while( line != nullptr && *line ){
+			char* next = strchr( line, '\n' );
+			if( next != nullptr ) *next++ = '\0';
+			size_t len = strlen( line );
+			if( len > 0 && line[ len - 1 ] == '\r' ) line[ --len ] = '\0';
+
+			char* value = strchr( line, '=' );
+			if( value == nullptr ) return false;
+			*value++ = '\0';
+
+			if( strcmp( line, "version" ) == 0 ){
+				hasVersion = esp::parseNumber( value, manifest.version );
+				if( !hasVersion ) return false;
+			}else if( strcmp( line, "size" ) == 0 ){
+				if( !esp::parseNumber( value, manifest.size ) ) return false;
+			}else if( strcmp( line, "base" ) == 0 ){
+				if( !esp::parseNumber( value, manifest.base ) ) return false;
+				manifest.hasBase = 1;
+			}else if( strcmp( line, "sha256" ) == 0 ){
+				if( !esp::hexToBytes( value, manifest.sha256, sizeof( manifest.sha256 ) ) ) return false;
+				manifest.hasSha256 = 1;
+			}else if( strcmp( line, "sig" ) == 0 ){
+				break;
+			}
+			// unknown keys are skipped for compatibility
+			line = next;
+		}
+		if( !hasVersion || manifest.version == 0 ) return false;
+#ifdef ESP_UPDATE_PUBLIC_KEY
+		if( !manifest.hasSha256 ) return false;
+#endif
+		manifest.valid = 1;
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t checkingUpdate(const char *repoURL, const uint16_t version)
+	{
+		uint32_t res = 0;
+		esp::updateManifest.valid = 0;
+
+		char text[ ESP_UPDATE_MANIFEST_MAX_LEN ];
+		int32_t len = esp::httpGetText( String( repoURL ) + String( ESP_FIRMWARE_VERSION_FILENAME ), text, sizeof( text ), nullptr );
+		if( len <= 0 || len >= (int32_t)sizeof( text ) - 1 ) return res;
+
+		// kept for updateFromFS after reboot, text is changed by parser
+		File f;
+		if( esp::flags.useFS ) f = ESP_FS.open( ESP_FIRMWARE_MANIFEST_FILEPATH, "w" );
+		if( f ){
+			f.write( (uint8_t*)text, len );
+			f.close();
+		}
+
+		if( esp::parseUpdateManifest( text, esp::updateManifest ) ){
+			res = esp::updateManifest.version;
+		}else{
+			ESP_DEBUG( "%s:%d Bad update manifest\n", __FILE__, __LINE__ );
+			esp::removeFile( ESP_FIRMWARE_MANIFEST_FILEPATH );
+		}
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Manifest saved by checkingUpdate, signature is verified again
+	static bool loadUpdateManifest(void)
+	{
+		File f = ESP_FS.open( ESP_FIRMWARE_MANIFEST_FILEPATH, "r" );
+		if( !f ) return false;
+
+		char text[ ESP_UPDATE_MANIFEST_MAX_LEN ];
+		size_t len = f.read( (uint8_t*)text, sizeof( text ) - 1 );
+		f.close();
+		text[ len ] = '\0';
+
+		return esp::parseUpdateManifest( text, esp::updateManifest );
+	}
+
+	//-------------------------------------------------------------------------------
+	// With ESP_UPDATE_PUBLIC_KEY firmware is flashed only with signed manifest (it always has hash)
+	static bool updateAllowed(void)
+	{
+#ifdef ESP_UPDATE_PUBLIC_KEY
+		if( !esp::updateManifest.valid ){
+			ESP_DEBUG( "%s:%d No signed update manifest, update refused\n", __FILE__, __LINE__ );
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Cancel started image, partial image is never committed
+	static void updateAbort(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		// no abort() in core, end() refuses incomplete image and resets updater
+		Update.end();
+#elif defined(ARDUINO_ARCH_ESP32)
+		Update.abort();
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void setDownloadProgressCallback(DownloadProgressCallback func)
+	{
+		esp::downloadProgressCb = func;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Stream response body to writer by ESP_DOWNLOAD_BUFFER_SIZE blocks aligned to start of file,
+	// waits only while socket is empty, stops after ESP_DOWNLOAD_TIMEOUT without data
+	// returns written bytes
+	static uint32_t downloadStream(HTTPClient &http, const std::function<bool(uint8_t*, size_t)> &writer, const uint32_t offset, const int32_t total)
+	{
+		uint8_t* buff = (uint8_t*)malloc( ESP_DOWNLOAD_BUFFER_SIZE );
+		if( buff == nullptr ){
+			ESP_DEBUG( "%s:%d no memory for download buffer\n", __FILE__, __LINE__ );
+			return 0;
+		}
+
+		WiFiClient* stream = http.getStreamPtr();
+		int32_t len = http.getSize();
+		uint32_t written = 0;
+		size_t fill = 0;
+		size_t block = ESP_DOWNLOAD_BUFFER_SIZE - ( offset % ESP_DOWNLOAD_BUFFER_SIZE );
+		uint32_t start = millis();
+		uint32_t lastData = start;
+		uint32_t lastReport = start;
+		bool error = false;
+
+		while( len != 0 ){
+			size_t size = stream->available();
+			if( size ){
+				size_t want = block - fill;
+				if( len > 0 && want > (size_t)len ) want = len;
+				if( want > size ) want = size;
+				int c = stream->read( buff + fill, want );
+				if( c > 0 ){
+					fill += c;
+					if( len > 0 ) len -= c;
+					lastData = millis();
+				}
+			}else if( !stream->connected() ){
+				break;
+			}else if( millis() - lastData > ESP_DOWNLOAD_TIMEOUT ){
+				ESP_DEBUG( "%s:%d[HTTP] Download timeout\n", __FILE__, __LINE__ );
+				break;
+			}else{
+				delay( 1 );
+				continue;
+			}
+
+			if( fill == block || len == 0 ){
+				if( !writer( buff, fill ) ){
+					error = true;
+					break;
+				}
+				written += fill;
+				fill = 0;
+				block = ESP_DOWNLOAD_BUFFER_SIZE;
+				yield();
+
+				uint32_t now = millis();
+				if( esp::downloadProgressCb != nullptr && ( now - lastReport >= ESP_DOWNLOAD_PROGRESS_INTERVAL || len == 0 ) ){
+					lastReport = now;
+					esp::downloadProgressCb( offset + written, total, ( now > start ) ? (uint32_t)( (uint64_t)written * 1000 / ( now - start ) ) : 0 );
+				}
+			}
+		}
+
+		if( fill > 0 && !error && writer( buff, fill ) ) written += fill;
+		free( buff );
+
+		uint32_t time = millis() - start;
+		ESP_DEBUG( "%s:%d[HTTP] %lu bytes at %lu ms\n", __FILE__, __LINE__, (unsigned long)written, (unsigned long)time );
+		if( esp::downloadProgressCb != nullptr ){
+			esp::downloadProgressCb( offset + written, total, ( time > 0 ) ? (uint32_t)( (uint64_t)written * 1000 / time ) : 0 );
+		}
+
+		return written;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Validator (ETag or Last-Modified) of response stored for If-Range of next attempt,
+	// without validator file is removed and partial file is not continued
+	static void downloadWriteValidator(HTTPClient &http, const char *tagFile)
+	{
+		String validator = http.header( "ETag" );
+		// weak ETag can not be used in If-Range
+		if( validator.length() == 0 || validator.startsWith( "W/" ) ) validator = http.header( "Last-Modified" );
+		if( validator.length() > 0 && validator.length() < ESP_DOWNLOAD_VALIDATOR_MAX_LEN ){
+			File f = ESP_FS.open( tagFile, "w" );
+			if( f && f.print( validator ) == validator.length() ){
+				f.close();
+				return;
+			}
+			if( f ) f.close();
+		}
+		ESP_FS.remove( tagFile );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Reads validator stored by downloadWriteValidator, returns its length (0 - none)
+	static size_t downloadReadValidator(const char *tagFile, char* validator)
+	{
+		validator[ 0 ] = '\0';
+		File f = ESP_FS.open( tagFile, "r" );
+		if( !f ) return 0;
+		size_t len = f.read( (uint8_t*)validator, ESP_DOWNLOAD_VALIDATOR_MAX_LEN - 1 );
+		f.close();
+		validator[ len ] = '\0';
+		return len;
+	}
+
+	//-------------------------------------------------------------------------------
+	// One download try to <file>.part, continue from its size with Range and If-Range request,
+	// received is increased by downloaded bytes
+	// returns 1 - file complete, 0 - interrupted (can retry), -1 - error
+	static int8_t downloadAttempt(const char *repoURL, const char *file, const char *partFile, const char *tagFile, uint32_t &received)
+	{
+		File f = ESP_FS.open( partFile, "a" );
+		if( !f ){
+			ESP_DEBUG( "%s:%d failed to open %s\n", __FILE__, __LINE__, partFile );
+			return -1;
+		}
+		uint32_t offset = f.size();
+
+		char validator[ ESP_DOWNLOAD_VALIDATOR_MAX_LEN ];
+		if( offset > 0 && esp::downloadReadValidator( tagFile, validator ) == 0 ){
+			// version of partial data is unknown, it can not be continued
+			ESP_DEBUG( "%s:%d[HTTP] No validator of %s, restart\n", __FILE__, __LINE__, partFile );
+			f.close();
+			f = ESP_FS.open( partFile, "w" );
+			if( !f ) return -1;
+			offset = 0;
+		}
+
+		HTTPClient http;
+#if defined(ARDUINO_ARCH_ESP8266)
+		WiFiClient client;
+		http.begin( client, String( repoURL ) + String( file ) );
+#elif defined(ARDUINO_ARCH_ESP32)
+		http.begin( String( repoURL ) + String( file ) );
+#endif
+		const char* headerKeys[] = { "Content-Range", "ETag", "Last-Modified" };
+		http.collectHeaders( headerKeys, sizeof( headerKeys ) / sizeof( headerKeys[ 0 ] ) );
+		if( offset > 0 ){
+			char range[ 24 ];
+			snprintf( range, sizeof( range ), "bytes=%lu-", (unsigned long)offset );
+			http.addHeader( "Range", range );
+			// changed file is sent whole with 200
+			http.addHeader( "If-Range", validator );
+		}
+
+		int8_t res = -1;
+		int32_t total = -1;
+		int httpCode = http.GET();
+		if( httpCode == HTTP_CODE_PARTIAL_CONTENT ){
+			// Content-Range: bytes <start>-<end>/<total>
+			String range = http.header( "Content-Range" );
+			int slash = range.indexOf( '/' );
+			if( range.startsWith( "bytes " ) && strtoul( range.c_str() + 6, nullptr, 10 ) == offset ){
+				if( slash > 0 && range[ slash + 1 ] != '*' ) total = atol( range.c_str() + slash + 1 );
+				res = 0;
+			}else{
+				ESP_DEBUG( "%s:%d[HTTP] Bad Content-Range [%s], restart\n", __FILE__, __LINE__, range.c_str() );
+				f.close();
+				f = ESP_FS.open( partFile, "w" );
+				http.end();
+				return ( f ) ? 0 : -1;
+			}
+		}else if( httpCode == HTTP_CODE_OK ){
+			// first request, file changed or server ignores Range
+			if( offset > 0 ){
+				ESP_DEBUG( "%s:%d[HTTP] %s changed, restart\n", __FILE__, __LINE__, file );
+				f.close();
+				f = ESP_FS.open( partFile, "w" );
+				offset = 0;
+			}
+			esp::downloadWriteValidator( http, tagFile );
+			total = http.getSize();
+			res = ( f ) ? 0 : -1;
+		}else if( httpCode == HTTP_CODE_RANGE_NOT_SATISFIABLE && offset > 0 ){
+			// Content-Range: bytes */<total>, file can be already complete
+			String range = http.header( "Content-Range" );
+			int slash = range.indexOf( '/' );
+			total = ( slash > 0 ) ? atol( range.c_str() + slash + 1 ) : -1;
+			f.close();
+			http.end();
+			if( total == (int32_t)offset ) return 1;
+			ESP_FS.open( partFile, "w" ).close();
+			return 0;
+		}else if( httpCode < 0 ){
+			ESP_DEBUG( "%s:%d[HTTP] GET... failed, error: %s\n", __FILE__, __LINE__, http.errorToString( httpCode ).c_str() );
+			res = 0;
+		}else{
+			ESP_DEBUG( "%s:%d[HTTP] GET... failed, code: %d\n", __FILE__, __LINE__, httpCode );
+		}
+
+		if( res == 0 && httpCode > 0 ){
+			ESP_DEBUG( "%s:%d[HTTP] Downloading [%s%s] from %lu...\n", __FILE__, __LINE__, repoURL, file, (unsigned long)offset );
+			uint32_t size = esp::downloadStream( http, [ &f ](uint8_t* data, size_t len){
+				return f.write( data, len ) == len;
+			}, offset, total );
+			received += size;
+			size += offset;
+			// length unknown - closed connection does not prove complete body, .part is kept
+			// and next attempt asks for the rest with Range to get total length from Content-Range
+			if( total >= 0 && size == (uint32_t)total ) res = 1;
+			ESP_DEBUG( "%s:%d[HTTP] Downloaded %lu / %ld\n", __FILE__, __LINE__, (unsigned long)size, (long)total );
+		}
+
+		if( f ) f.close();
+		http.end();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t downloadUpdate(const char *repoURL, const char *file)
+	{
+		uint8_t res = 0;
+		if( !esp::flags.useFS ) return res;
+
+		// backoff after failed call, no request is made
+		if( esp::downloadBackoff > 0 && millis() - esp::downloadFailTime < esp::downloadBackoff ) return res;
+
+		char partFile[ ESP_WEB_PATH_MAX_LEN ];
+		char tagFile[ ESP_WEB_PATH_MAX_LEN ];
+		if( strlen( file ) + sizeof( ESP_DOWNLOAD_PART_SUFFIX ) + sizeof( ESP_DOWNLOAD_VALIDATOR_SUFFIX ) > sizeof( tagFile ) + 1 ) return res;
+		strcpy( partFile, file );
+		strcat( partFile, ESP_DOWNLOAD_PART_SUFFIX );
+		strcpy( tagFile, partFile );
+		strcat( tagFile, ESP_DOWNLOAD_VALIDATOR_SUFFIX );
+
+		bool firmware = strcmp( file, ESP_FIRMWARE_FILEPATH ) == 0;
+		if( firmware && !esp::updateAllowed() ) return res;
+
+		// interrupted transfer is continued at once while server sends data
+		int8_t state = 0;
+		uint32_t received = 0;
+		for( uint8_t attempt = 0; attempt <= ESP_DOWNLOAD_RETRIES && state == 0; attempt++ ){
+			if( attempt > 0 ){
+				if( received == 0 ) break;
+				ESP_DEBUG( "%s:%d[HTTP] Retry %u...\n", __FILE__, __LINE__, attempt );
+				received = 0;
+			}
+			state = esp::downloadAttempt( repoURL, file, partFile, tagFile, received );
+		}
+		if( state != 1 ){
+			// next call waits ESP_DOWNLOAD_BACKOFF, doubled after every failed call
+			esp::downloadFailTime = millis();
+			esp::downloadBackoff = ( esp::downloadBackoff == 0 ) ? ESP_DOWNLOAD_BACKOFF : esp::downloadBackoff * 2;
+			if( esp::downloadBackoff > ESP_DOWNLOAD_BACKOFF_MAX ) esp::downloadBackoff = ESP_DOWNLOAD_BACKOFF_MAX;
+			ESP_DEBUG( "%s:%d[HTTP] Download failed, next try after %lu ms\n", __FILE__, __LINE__, (unsigned long)esp::downloadBackoff );
+			return res;
+		}
+		esp::downloadBackoff = 0;
+		ESP_FS.remove( tagFile );
+
+		if( firmware && esp::updateManifest.valid && esp::updateManifest.hasSha256 && !esp::checkFileSha256( partFile ) ){
+			ESP_DEBUG( "%s:%d %s does not match update manifest\n", __FILE__, __LINE__, file );
+			ESP_FS.remove( partFile );
+			return res;
+		}
+
+		// atomic replace, SPIFFS can not rename over existing file
+		esp::webCacheInvalidate( file );
+		if( !ESP_FS.rename( partFile, file ) ){
+			ESP_FS.remove( file );
+			if( !ESP_FS.rename( partFile, file ) ){
+				ESP_DEBUG( "%s:%d failed to rename %s\n", __FILE__, __LINE__, partFile );
+				return res;
+			}
+		}
+		res = 1;
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t downloadAndFlash(const char *repoURL)
+	{
+		uint8_t res = 0;
+		if( !esp::updateAllowed() ) return res;
+
+		// optional MD5 of image published at repository, checked by Update.end()
+		// only 404 means not published, other failure could skip the check
+		char md5[ 33 ] = { 0 };
+		int md5Code = 0;
+		int32_t md5Len = esp::httpGetText( String( repoURL ) + String( ESP_FIRMWARE_MD5_FILENAME ), md5, sizeof( md5 ), &md5Code );
+		if( md5Len == 32 ){
+			ESP_DEBUG( "%s:%d Firmware MD5: %s\n", __FILE__, __LINE__, md5 );
+		}else if( md5Code == HTTP_CODE_NOT_FOUND ){
+			md5[ 0 ] = '\0';
+		}else{
+			ESP_DEBUG( "%s:%d Firmware MD5 not read, code: %d length: %ld\n", __FILE__, __LINE__, md5Code, (long)md5Len );
+			return res;
+		}
+
+		HTTPClient http;
+#if defined(ARDUINO_ARCH_ESP8266)
+		WiFiClient client;
+		http.begin( client, String( repoURL ) + String( ESP_FIRMWARE_FILEPATH ) );
+#elif defined(ARDUINO_ARCH_ESP32)
+		http.begin( String( repoURL ) + String( ESP_FIRMWARE_FILEPATH ) );
+#endif
+		int httpCode = http.GET();
+		int32_t size = http.getSize();
+		bool checkHash = esp::updateManifest.valid && esp::updateManifest.hasSha256;
+		if( checkHash && esp::updateManifest.size && (uint32_t)size != esp::updateManifest.size ){
+			ESP_DEBUG( "%s:%d Image size %ld does not match update manifest\n", __FILE__, __LINE__, (long)size );
+			http.end();
+			return res;
+		}
+		if( httpCode != HTTP_CODE_OK || size <= 0 ){
+			ESP_DEBUG( "%s:%d[HTTP] GET... failed, code: %d size: %ld\n", __FILE__, __LINE__, httpCode, (long)size );
+			http.end();
+			return res;
+		}
+
+		if( !Update.begin( size ) ){
+			ESP_DEBUG( "%s:%d Not enough space to begin OTA\n", __FILE__, __LINE__ );
+			http.end();
+			return res;
+		}
+		if( md5[ 0 ] ) Update.setMD5( md5 );
+
+		ESP_DEBUG( "%s:%d[HTTP] Flashing [%s%s]...\n", __FILE__, __LINE__, repoURL, ESP_FIRMWARE_FILEPATH );
+		// with manifest hash the last block is written only if image matches, so Update.end() can not commit wrong image
+		Sha256Context ctx;
+		uint32_t done = 0;
+		if( checkHash ) esp::sha256Begin( ctx );
+		uint32_t written = esp::downloadStream( http, [ &ctx, &done, checkHash, size ](uint8_t* data, size_t len){
+			if( checkHash ){
+				esp::sha256Update( ctx, data, len );
+				done += len;
+				if( done == (uint32_t)size ){
+					uint8_t hash[ 32 ];
+					esp::sha256Finish( ctx, hash );
+					if( memcmp( hash, esp::updateManifest.sha256, sizeof( hash ) ) != 0 ){
+						ESP_DEBUG( "%s:%d Image does not match update manifest\n", __FILE__, __LINE__ );
+						return false;
+					}
+				}
+			}
+			return Update.write( data, len ) == len;
+		}, 0, size );
+		http.end();
+		if( checkHash ) esp::sha256Free( ctx );
+
+		if( written != (uint32_t)size ){
+			ESP_DEBUG( "%s:%d Written only: %lu / %ld\n", __FILE__, __LINE__, (unsigned long)written, (long)size );
+			esp::updateAbort();
+			return res;
+		}
+		if( Update.end() && Update.isFinished() ){
+			ESP_DEBUG( "%s:%d OTA done!\n", __FILE__, __LINE__ );
+			res = 1;
+		}else{
+			ESP_DEBUG( "%s:%d Error Occurred. Error #: %d\n", __FILE__, __LINE__, Update.getError() );
+		}
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Read running firmware image
+	static bool readRunningFirmware(const uint32_t offset, uint8_t* buff, const size_t len)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		if( offset + len > ESP.getSketchSize() ) return false;
+		return ESP.flashRead( offset, buff, len );
+#elif defined(ARDUINO_ARCH_ESP32)
+		const esp_partition_t* partition = esp_ota_get_running_partition();
+		if( partition == nullptr || offset + len > partition->size ) return false;
+		return esp_partition_read( partition, offset, buff, len ) == ESP_OK;
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Apply part of patch stream, new image data goes to emit function
+	static bool patchFeed(PatchState &patch, const uint8_t* data, size_t len, const std::function<bool(uint8_t*, size_t)> &emit)
+	{
+		uint8_t buff[ 256 ];
+
+		while( len > 0 ){
+			if( patch.state == PatchState::HEADER || patch.state == PatchState::CONTROL ){
+				// collect 12 bytes: magic + new size or diff length + extra length + old seek
+				uint8_t* field = ( patch.state == PatchState::HEADER ) ? patch.header : (uint8_t*)patch.control;
+				size_t part = 12 - patch.field;
+				if( part > len ) part = len;
+				memcpy( field + patch.field, data, part );
+				patch.field += part;
+				data += part;
+				len -= part;
+				if( patch.field < 12 ) continue;
+				patch.field = 0;
+
+				if( patch.state == PatchState::HEADER ){
+					if( memcmp( patch.header, ESP_PATCH_MAGIC, 8 ) != 0 ) return false;
+					memcpy( &patch.newSize, patch.header + 8, 4 );
+					patch.state = PatchState::CONTROL;
+					continue;
+				}
+				patch.remain = patch.control[ 0 ];
+				patch.state = PatchState::DIFF;
+				if( patch.produced + patch.control[ 0 ] + patch.control[ 1 ] > patch.newSize ) return false;
+			}
+
+			if( patch.state == PatchState::DIFF ){
+				// new = old + diff
+				while( patch.remain > 0 && len > 0 ){
+					size_t part = ( patch.remain < sizeof( buff ) ) ? patch.remain : sizeof( buff );
+					if( part > len ) part = len;
+					if( !esp::readRunningFirmware( patch.oldPos, buff, part ) ) return false;
+					for( size_t i = 0; i < part; i++ ) buff[ i ] += data[ i ];
+					if( !emit( buff, part ) ) return false;
+					patch.oldPos += part;
+					patch.produced += part;
+					patch.remain -= part;
+					data += part;
+					len -= part;
+				}
+				if( patch.remain > 0 ) break;
+				patch.remain = patch.control[ 1 ];
+				patch.state = PatchState::EXTRA;
+			}
+
+			if( patch.state == PatchState::EXTRA ){
+				// new data as is
+				size_t part = ( patch.remain < len ) ? patch.remain : len;
+				if( part > 0 ){
+					if( !emit( const_cast<uint8_t*>( data ), part ) ) return false;
+					patch.produced += part;
+					patch.remain -= part;
+					data += part;
+					len -= part;
+				}
+				if( patch.remain > 0 ) break;
+				patch.oldPos += (int32_t)patch.control[ 2 ];
+				patch.state = ( patch.produced == patch.newSize ) ? PatchState::DONE : PatchState::CONTROL;
+			}
+
+			if( patch.state == PatchState::DONE && len > 0 ) return false;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t downloadAndPatch(const char *repoURL, const uint32_t currentVersion)
+	{
+		uint8_t res = 0;
+		if( !esp::updateManifest.valid || !esp::updateManifest.hasBase || esp::updateManifest.base != currentVersion ){
+			ESP_DEBUG( "%s:%d No delta update for version %lu\n", __FILE__, __LINE__, (unsigned long)currentVersion );
+			return res;
+		}
+
+		HTTPClient http;
+#if defined(ARDUINO_ARCH_ESP8266)
+		WiFiClient client;
+		http.begin( client, String( repoURL ) + String( ESP_FIRMWARE_PATCH_FILENAME ) );
+#elif defined(ARDUINO_ARCH_ESP32)
+		http.begin( String( repoURL ) + String( ESP_FIRMWARE_PATCH_FILENAME ) );
+#endif
+		int httpCode = http.GET();
+		int32_t size = http.getSize();
+		if( httpCode != HTTP_CODE_OK ){
+			ESP_DEBUG( "%s:%d[HTTP] GET... failed, code: %d\n", __FILE__, __LINE__, httpCode );
+			http.end();
+			return res;
+		}
+
+		PatchState patch;
+		memset( &patch, 0, sizeof( PatchState ) );
+		Sha256Context ctx;
+		bool checkHash = esp::updateManifest.hasSha256;
+		bool started = false;
+		if( checkHash ) esp::sha256Begin( ctx );
+
+		// new image: hashed and written to Update, last block only if it matches manifest
+		auto emit = [ &patch, &ctx, &started, checkHash ](uint8_t* data, size_t len){
+			if( !started ){
+				if( esp::updateManifest.size && esp::updateManifest.size != patch.newSize ) return false;
+				if( !Update.begin( patch.newSize ) ){
+					ESP_DEBUG( "%s:%d Not enough space to begin OTA\n", __FILE__, __LINE__ );
+					return false;
+				}
+				started = true;
+			}
+			if( checkHash ){
+				esp::sha256Update( ctx, data, len );
+				if( patch.produced + len == patch.newSize ){
+					uint8_t hash[ 32 ];
+					esp::sha256Finish( ctx, hash );
+					if( memcmp( hash, esp::updateManifest.sha256, sizeof( hash ) ) != 0 ){
+						ESP_DEBUG( "%s:%d Patched image does not match update manifest\n", __FILE__, __LINE__ );
+						return false;
+					}
+				}
+			}
+			return Update.write( data, len ) == len;
+		};
+
+		ESP_DEBUG( "%s:%d[HTTP] Patching from [%s%s]...\n", __FILE__, __LINE__, repoURL, ESP_FIRMWARE_PATCH_FILENAME );
+		bool error = false;
+		esp::downloadStream( http, [ &patch, &emit, &error ](uint8_t* data, size_t len){
+			error = !esp::patchFeed( patch, data, len, emit );
+			return !error;
+		}, 0, size );
+		http.end();
+		if( checkHash ) esp::sha256Free( ctx );
+
+		if( error || patch.state != PatchState::DONE ){
+			ESP_DEBUG( "%s:%d Patch error, done %lu / %lu\n", __FILE__, __LINE__, (unsigned long)patch.produced, (unsigned long)patch.newSize );
+			if( started ) esp::updateAbort();
+			return res;
+		}
+		if( Update.end() && Update.isFinished() ){
+			ESP_DEBUG( "%s:%d OTA done!\n", __FILE__, __LINE__ );
+			res = 1;
+		}else{
+			ESP_DEBUG( "%s:%d Error Occurred. Error #: %d\n", __FILE__, __LINE__, Update.getError() );
+		}
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t updateFromFS(void)
+	{
+		uint8_t res = 0;
+		if( !esp::flags.useFS ) return res;
+
+		if( esp::isFileExists( ESP_FIRMWARE_FILEPATH ) ){
+			File f = ESP_FS.open( ESP_FIRMWARE_FILEPATH, "r");
+			if( f ){
+				if( f.isDirectory() ){
+					ESP_DEBUG( "%s:%d Error, %s is not a file\n", __FILE__, __LINE__, ESP_FIRMWARE_FILEPATH );
+					f.close();
+					return res;
+				}
+
+				// manifest of checkingUpdate before reboot
+				if( !esp::updateManifest.valid ) esp::loadUpdateManifest();
+				if( !esp::updateAllowed() ){
+					f.close();
+					return res;
+				}
+
+				size_t fileSize = f.size();
+				if( esp::updateManifest.valid && esp::updateManifest.hasSha256 && !esp::checkFileSha256( ESP_FIRMWARE_FILEPATH ) ){
+					ESP_DEBUG( "%s:%d Error, %s does not match update manifest\n", __FILE__, __LINE__, ESP_FIRMWARE_FILEPATH );
+					f.close();
+					return res;
+				}
+				if( fileSize > 0 ){
+					ESP_DEBUG( "%s:%d Trying to start update\n", __FILE__, __LINE__ );
+					if( Update.begin( fileSize ) ){
+						size_t written = Update.writeStream( f );
+						if( written == fileSize ){
+							ESP_DEBUG( "%s:%d Written : %d successfully\n", __FILE__, __LINE__, written );
+						}else{
+							ESP_DEBUG( "%s:%d Written only: %d / %d. Retry?\n", __FILE__, __LINE__, written, fileSize );
+						}
+
+						if( Update.end() ){
+							ESP_DEBUG( "%s:%d OTA done!?\n", __FILE__, __LINE__ );
+							if( !Update.isFinished() ){
+								ESP_DEBUG( "%s:%d Update not finished? Something went wrong!\n", __FILE__, __LINE__ );
+							}else{
+								res = 1;
+							}
+						}else{
+							ESP_DEBUG( "%s:%d Error Occurred. Error #: %d\n", __FILE__, __LINE__, Update.getError() );
+						}
+					}else{
+							ESP_DEBUG( "%s:%d Not enough space to begin OTA\n", __FILE__, __LINE__ );
+					}
+				}else{
+					ESP_DEBUG( "%s:%d Error, file is empty\n", __FILE__, __LINE__ );
+				}
+				f.close();
+			}
+		}else{
+			ESP_DEBUG( "%s:%d Could not load %s from spiffs root\n", __FILE__, __LINE__, ESP_FIRMWARE_FILEPATH );
+		}
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool isFileExists(const char *filepath)
+	{
+		if( !esp::flags.useFS ) return false;
+		return ESP_FS.exists( filepath );
+	}
+
+	//-------------------------------------------------------------------------------
+	void printAllFiles(HardwareSerial &SerialPort)
+	{
+		if( !esp::flags.useFS ) return;
+#if defined(ARDUINO_ARCH_ESP8266)
+		Dir root = ESP_FS.openDir( "/" );
+		while( root.next() ){
+			File file = root.openFile("r");
+			SerialPort.print( ": " );
+			SerialPort.println( root.fileName() );
+			file.close();
+		}
+#elif defined(ARDUINO_ARCH_ESP32)
+		File root = ESP_FS.open( "/" );
+		File file = root.openNextFile();
+		while( file ){
+			SerialPort.print( ": " );
+			SerialPort.println( file.name() );
+			file = root.openNextFile();
+		}
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Headerless config of library versions before Data had STA cache and extra networks,
+	// only mode and AP/STA credentials, the rest is cleared
+	static bool loadLegacySystemSettings(void)
+	{
+		const size_t legacySize = offsetof( Data, sta_bssid );
+		File f = ESP_FS.open( ESP_SYSTEM_CONFIG_FILE, "r" );
+		if( !f ) return false;
+
+		Data data;
+		memset( &data, 0, sizeof( Data ) );
+		bool res = f.size() == legacySize && f.read( (uint8_t*)&data, legacySize ) == legacySize;
+		f.close();
+		if( res ) memcpy( &esp::app, &data, sizeof( Data ) );
+
+		return res;
+	}
+
+#if defined(ARDUINO_ARCH_ESP32)
+	//-------------------------------------------------------------------------------
+	// Power on and EN pin reset have the same reason at ESP32, raw configuration window
+	// is opened only by second EN reset within ESP_DOUBLE_RESET_TIMEOUT (marker file, RTC memory is lost)
+	static bool checkDoubleReset(void)
+	{
+		if( !esp::flags.useFS || esp::getResetReason() != POWERON_RESET ) return false;
+
+		if( ESP_FS.exists( ESP_DOUBLE_RESET_FILE ) ){
+			ESP_FS.remove( ESP_DOUBLE_RESET_FILE );
+			ESP_DEBUG( "ESP: double reset\n" );
+			return true;
+		}
+		ESP_FS.open( ESP_DOUBLE_RESET_FILE, "w" ).close();
+		// removed by timer, sketch may not call esp::handle()
+		esp::doubleResetTicker.once_ms( ESP_DOUBLE_RESET_TIMEOUT, [](void){
+			ESP_FS.remove( ESP_DOUBLE_RESET_FILE );
+		} );
+		return false;
+	}
+
+#endif
+	//-------------------------------------------------------------------------------
+	void init(const char* deviceName, bool useFS)
+	{
+		esp::flags.useFS							= 0;
+
+		if( useFS ){
+			bool fs_init_res = esp::fsBegin();
+			delay( 50 );
+			ESP_DEBUG( "FS Init...%s\n", ( ( fs_init_res ) ? "OK" : "ERROR" ) );
+			esp::flags.useFS						= ( fs_init_res ) ? 1 : 0;
+		}
+		
+		esp::flags.captivePortal					= 0;
+		esp::flags.captivePortalAccess				= 0;
+		esp::flags.autoUpdate						= 0;
+		esp::app.mode								= esp::Mode::UNKNOWN;
+		esp::rtc_offset								= 0;
+
+		if( esp::isFileExists( ESP_AUTOUPDATE_FILENAME ) ) esp::flags.autoUpdate = 1;
+
+		pageTop = "<!DOCTYPE HTML><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"><meta charset=\"utf-8\"/><script type=\"text/javascript\" src=\"/index.js\"></script><link rel=\"stylesheet\" type=\"text/css\" href=\"/index.css\"/>";
+		pageEndTop = "</head><body><hr size=\"1\">";
+		pageBottom = "<hr size=\"1\" class=\"red\"></body></html>";
+
+		strcpy( esp::systemLogin, SYSTEM_LOGIN );
+		strcpy( esp::systemPassword, SYSTEM_PASSWORD );
+		strcpy( esp::app.ap_ssid, deviceName );
+		strcpy( esp::app.ap_key, DEFAULT_AP_KEY );
+		strcpy( esp::hostName, deviceName );
+
+		// system settings are stored in KV log
+		esp::kvInit();
+
+		if( esp::flags.useFS ){
+			ESP_DEBUG( "ESP: load System Settings..." );
+			if( loadSettings( (uint8_t*)&app, sizeof( app ), ESP_SYSTEM_CONFIG_FILE ) || esp::loadLegacySystemSettings() ){
+				memcpy( &esp::appSaved, &esp::app, sizeof( Data ) );
+				ESP_DEBUG( "OK\n" );
+			}else{
+				ESP_DEBUG( "ERROR\n" );
+			}
+		}
+
+		ESP_DEBUG( "ESP: Device mode:%u\n", esp::app.mode );
+
+#ifdef __DEV
+		ESP_DEBUG( "ESP: === filesystem ============\n" );
+		File root = ESP_FS.open( "/", "r" );
+		File file = root.openNextFile();
+		while( file ){
+			ESP_DEBUG( "FILE: %s\n", file.name() );
+			file = root.openNextFile();
+		}
+
+		ESP_DEBUG( "ESP: === end filesystem ========\n" );
+#endif
+
+		// Checking reboot reason
+#if defined(ARDUINO_ARCH_ESP32)
+		if( ( esp::app.mode == esp::Mode::STA || esp::app.mode == esp::Mode::AP ) && esp::checkDoubleReset() ){
+			disablePromiscMode();
+			enablePromiscMode();
+			esp::provWindow = true;
+		}
+#elif defined(ARDUINO_ARCH_ESP8266)
+		if( esp::app.mode == esp::Mode::STA || esp::app.mode == esp::Mode::AP ){
+			if( esp::getResetReason() == REASON_EXT_SYS_RST ){
+				// Включаем режим приема сырых данных для возможной конфигурации по сырым данным
+				disablePromiscMode();
+				enablePromiscMode();
+				esp::provWindow = true;
+			}
+		}
+#endif
+
+		if( esp::app.mode == esp::Mode::UNKNOWN ) esp::setMode( esp::Mode::AP );
+	}
+
+	//-------------------------------------------------------------------------------
+	void changeMAC(const uint8_t *mac)
+	{
+		ESP_DEBUG( "ESP: OLD ESP MAC: %s\n", WiFi.macAddress().c_str() );
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_set_macaddr( 0, const_cast<uint8*>(mac) );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_wifi_set_mac( WIFI_IF_STA, mac );
+#endif
+		ESP_DEBUG( "ESP: NEW ESP MAC: %s\n", WiFi.macAddress().c_str() );
+	}
+
+	//-------------------------------------------------------------------------------
+	int http_put(const String &url, const String &playload, String &response)
+	{
+		HTTPClient http;
+#if defined(ARDUINO_ARCH_ESP8266)
+		WiFiClient client;
+		http.begin( client, url );
+#elif defined(ARDUINO_ARCH_ESP32)
+		http.begin( url );
+#endif
+		String request = "{ \"user\": \"DrSmyrke\", \"message\": \"IR Reciever starting...\", \"key\": \"0f7d848c56094bf722ca34701d38938e\" }";
+		int httpCode = http.PUT( playload );
+		
+		// if( httpCode == HTTP_CODE_OK ){
+			response = http.getString();
+		// }
+
+		http.end();
+
+		return httpCode;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc)
+	{
+		static const uint32_t table[ 16 ] = {
+			0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+			0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+		};
+		crc = ~crc;
+		for( size_t i = 0; i < len; i++ ){
+			crc = table[ ( crc ^ data[ i ] ) & 0x0F ] ^ ( crc >> 4 );
+			crc = table[ ( crc ^ ( data[ i ] >> 4 ) ) & 0x0F ] ^ ( crc >> 4 );
+		}
+		return ~crc;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Settings slot file: 0 - <file>, 1 - <file>.1
+	static bool settingsSlotPath(const char* settingsFile, const uint8_t slot, char* path)
+	{
+		if( strlen( settingsFile ) + sizeof( ESP_SETTINGS_SLOT_SUFFIX ) > ESP_WEB_PATH_MAX_LEN ) return false;
+		strcpy( path, settingsFile );
+		if( slot ) strcat( path, ESP_SETTINGS_SLOT_SUFFIX );
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Read and check settings record, data is copied up to size (may be nullptr)
+	// returns true if header and CRC are correct
+	static bool settingsReadSlot(const char* path, SettingsHeader &header, uint8_t* data, const uint32_t size)
+	{
+		File f = ESP_FS.open( path, "r" );
+		if( !f ) return false;
+
+		bool res = false;
+		if( f.read( (uint8_t*)&header, sizeof( SettingsHeader ) ) == sizeof( SettingsHeader )
+			&& header.magic == ESP_SETTINGS_MAGIC && header.schema == ESP_SETTINGS_SCHEMA
+			&& f.size() == sizeof( SettingsHeader ) + header.length ){
+			uint32_t crc = esp::crc32( (const uint8_t*)&header, offsetof( SettingsHeader, crc ) );
+			uint8_t buff[ 64 ];
+			uint32_t pos = 0;
+			while( pos < header.length ){
+				uint32_t part = header.length - pos;
+				uint8_t* dst = buff;
+				if( data != nullptr && pos < size ){
+					dst = data + pos;
+					if( part > size - pos ) part = size - pos;
+				}else if( part > sizeof( buff ) ){
+					part = sizeof( buff );
+				}
+				if( f.read( dst, part ) != part ) break;
+				crc = esp::crc32( dst, part, crc );
+				pos += part;
+			}
+			res = ( pos == header.length && crc == header.crc );
+		}
+		f.close();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Find newest valid slot, returns -1 if not found
+	static int8_t settingsFindSlot(const char* settingsFile, SettingsHeader &header, uint8_t* data, const uint32_t size)
+	{
+		char path[ ESP_WEB_PATH_MAX_LEN ];
+		SettingsHeader headers[ 2 ];
+		bool present[ 2 ];
+		for( uint8_t slot = 0; slot < 2; slot++ ){
+			present[ slot ] = false;
+			if( !esp::settingsSlotPath( settingsFile, slot, path ) ) return -1;
+			File f = ESP_FS.open( path, "r" );
+			if( !f ) continue;
+			present[ slot ] = f.read( (uint8_t*)&headers[ slot ], sizeof( SettingsHeader ) ) == sizeof( SettingsHeader ) && headers[ slot ].magic == ESP_SETTINGS_MAGIC;
+			f.close();
+		}
+
+		// newest by sequence first, older one if newest is broken
+		uint8_t first = ( present[ 1 ] && ( !present[ 0 ] || (int32_t)( headers[ 1 ].sequence - headers[ 0 ].sequence ) > 0 ) ) ? 1 : 0;
+		for( uint8_t i = 0; i < 2; i++ ){
+			uint8_t slot = first ^ i;
+			if( !present[ slot ] ) continue;
+			esp::settingsSlotPath( settingsFile, slot, path );
+			// CRC is checked before data is read, broken record must not overwrite caller data
+			if( esp::settingsReadSlot( path, header, nullptr, 0 ) && ( data == nullptr || esp::settingsReadSlot( path, header, data, size ) ) ) return slot;
+			ESP_DEBUG( "ESP: settings slot %s is broken\n", path );
+		}
+
+		return -1;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Remove files of previous library versions (record slots and headerless file)
+	static void settingsRemoveFiles(const char* settingsFile)
+	{
+		char path[ ESP_WEB_PATH_MAX_LEN ];
+		for( uint8_t slot = 0; slot < 2; slot++ ){
+			if( esp::settingsSlotPath( settingsFile, slot, path ) ) esp::removeFile( path );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	void saveSettings(const uint8_t* data, uint32_t length, const char* settingsFile)
+	{
+		if( length <= 0 || data == nullptr || settingsFile == nullptr || !esp::flags.useFS ) return;
+		if( length > 0xFFFF ){
+			ESP_DEBUG( "ESP: settings %s are too long\n", settingsFile );
+			return;
+		}
+
+		// one KV record with file name as key, old record stays valid if power is lost while writing
+		if( esp::kvPut( settingsFile, data, length ) ){
+			esp::settingsRemoveFiles( settingsFile );
+		}else{
+			ESP_DEBUG( "ESP: settings %s are not saved\n", settingsFile );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t loadSettings(uint8_t* data, uint32_t size, const char* settingsFile)
+	{
+		uint32_t res = 0;
+		if( size <= 0 || data == nullptr || settingsFile == nullptr || !esp::flags.useFS ) return res;
+
+		// CRC is checked before data is read, broken record must not overwrite caller data
+		if( esp::kvGet( settingsFile, nullptr, 0 ) >= 0 ){
+			int32_t len = esp::kvGet( settingsFile, data, ( size > 0xFFFF ) ? 0xFFFF : size );
+			if( len >= 0 ){
+				res = ( (uint32_t)len < size ) ? len : size;
+				return res;
+			}
+		}
+
+		// files of previous library versions: record slots with header
+		SettingsHeader header;
+		if( esp::settingsFindSlot( settingsFile, header, data, size ) >= 0 ){
+			res = ( header.length < size ) ? header.length : size;
+			return res;
+		}
+
+		// or file without header, only complete one is accepted
+		File f = ESP_FS.open( settingsFile, "r");
+		if( f ){
+			if( f.size() == size ) res = f.read( data, size );
+			f.close();
+		}
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	void removeSettings(const char* settingsFile)
+	{
+		if( settingsFile == nullptr ) return;
+		esp::kvRemove( settingsFile );
+		esp::settingsRemoveFiles( settingsFile );
+	}
+
+	//-------------------------------------------------------------------------------
+	// FNV-1a
+	static uint32_t kvHash(const char* key)
+	{
+		uint32_t hash = 2166136261UL;
+		while( *key ){
+			hash ^= (uint8_t)*key++;
+			hash *= 16777619UL;
+		}
+		return hash;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Read record at offset, key is compared if not nullptr, value is copied up to size
+	// returns record size or 0 if record is broken or other key
+	static uint32_t kvReadRecord(File &f, const uint32_t offset, KvRecord &record, char* key, const char* checkKey, uint8_t* value, const uint16_t size)
+	{
+		if( !f.seek( offset ) || f.read( (uint8_t*)&record, sizeof( KvRecord ) ) != sizeof( KvRecord ) ) return 0;
+		if( record.keyLen == 0 || record.keyLen > ESP_KV_KEY_MAX_LEN ) return 0;
+		if( f.read( (uint8_t*)key, record.keyLen ) != record.keyLen ) return 0;
+		key[ record.keyLen ] = '\0';
+		if( checkKey != nullptr && strcmp( key, checkKey ) != 0 ) return 0;
+
+		uint32_t crc = esp::crc32( (const uint8_t*)&record, offsetof( KvRecord, crc ) );
+		crc = esp::crc32( (const uint8_t*)key, record.keyLen, crc );
+		uint8_t buff[ 32 ];
+		uint16_t pos = 0;
+		while( pos < record.length ){
+			uint16_t part = record.length - pos;
+			uint8_t* dst = buff;
+			if( value != nullptr && pos < size ){
+				dst = value + pos;
+				if( part > size - pos ) part = size - pos;
+			}else if( part > sizeof( buff ) ){
+				part = sizeof( buff );
+			}
+			if( f.read( dst, part ) != part ) return 0;
+			crc = esp::crc32( dst, part, crc );
+			pos += part;
+		}
+		if( crc != record.crc ) return 0;
+
+		return sizeof( KvRecord ) + record.keyLen + record.length;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Find index slot by key, returns slot of key or free slot to insert, -1 if table is full
+	static int16_t kvFind(File &f, const char* key, const uint32_t hash)
+	{
+		KvRecord record;
+		char name[ ESP_KV_KEY_MAX_LEN + 1 ];
+		for( uint16_t i = 0; i < ESP_KV_INDEX_SIZE; i++ ){
+			uint16_t slot = ( hash + i ) & ( ESP_KV_INDEX_SIZE - 1 );
+			KvIndexEntry &entry = esp::kvIndex[ slot ];
+			if( entry.offset == ESP_KV_EMPTY ) return slot;
+			if( entry.hash == hash && esp::kvReadRecord( f, entry.offset, record, name, key, nullptr, 0 ) ) return slot;
+		}
+		return -1;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Remove index slot with linear probing backward shift
+	static void kvIndexRemove(uint16_t slot)
+	{
+		uint16_t next = slot;
+		while( true ){
+			next = ( next + 1 ) & ( ESP_KV_INDEX_SIZE - 1 );
+			KvIndexEntry &entry = esp::kvIndex[ next ];
+			if( entry.offset == ESP_KV_EMPTY ) break;
+			uint16_t home = entry.hash & ( ESP_KV_INDEX_SIZE - 1 );
+			// move entry if its home is not between slot and next (cyclic)
+			if( ( next > slot ) ? ( home <= slot || home > next ) : ( home <= slot && home > next ) ){
+				esp::kvIndex[ slot ] = entry;
+				slot = next;
+			}
+		}
+		esp::kvIndex[ slot ].offset = ESP_KV_EMPTY;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Append record, returns offset or ESP_KV_EMPTY if error
+	static uint32_t kvAppend(File &f, const char* key, const uint8_t* value, const uint16_t length, const uint8_t flags)
+	{
+		KvRecord record;
+		record.keyLen = strlen( key );
+		record.flags = flags;
+		record.length = length;
+		record.crc = esp::crc32( (const uint8_t*)&record, offsetof( KvRecord, crc ) );
+		record.crc = esp::crc32( (const uint8_t*)key, record.keyLen, record.crc );
+		record.crc = esp::crc32( value, length, record.crc );
+
+		uint32_t offset = f.size();
+		if( f.write( (const uint8_t*)&record, sizeof( KvRecord ) ) != sizeof( KvRecord ) ) return ESP_KV_EMPTY;
+		if( f.write( (const uint8_t*)key, record.keyLen ) != record.keyLen ) return ESP_KV_EMPTY;
+		if( length && f.write( value, length ) != length ) return ESP_KV_EMPTY;
+		esp::kvStats.bytesWritten += sizeof( KvRecord ) + record.keyLen + length;
+
+		return offset;
+	}
+
+	//-------------------------------------------------------------------------------
+	void kvInit(void)
+	{
+		for( uint16_t i = 0; i < ESP_KV_INDEX_SIZE; i++ ) esp::kvIndex[ i ].offset = ESP_KV_EMPTY;
+		esp::kvLogSize = 0;
+		esp::kvLiveSize = 0;
+		esp::kvStats.dropped = 0;
+		if( !esp::flags.useFS ) return;
+
+		// compaction was interrupted after old log removal
+		if( !ESP_FS.exists( ESP_KV_FILE ) && ESP_FS.exists( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX ) ){
+			ESP_FS.rename( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX, ESP_KV_FILE );
+		}
+
+		File f = ESP_FS.open( ESP_KV_FILE, "r" );
+		if( !f ) return;
+
+		KvRecord record;
+		char key[ ESP_KV_KEY_MAX_LEN + 1 ];
+		uint32_t offset = 0;
+		uint32_t fileSize = f.size();
+		while( offset < fileSize ){
+			uint32_t size = esp::kvReadRecord( f, offset, record, key, nullptr, nullptr, 0 );
+			if( size == 0 ) break;
+			uint32_t hash = esp::kvHash( key );
+			uint32_t pos = f.position();
+			int16_t slot = esp::kvFind( f, key, hash );
+			f.seek( pos );
+			if( slot >= 0 ){
+				KvIndexEntry &entry = esp::kvIndex[ slot ];
+				if( entry.offset != ESP_KV_EMPTY ){
+					esp::kvLiveSize -= entry.size;
+					esp::kvIndexRemove( slot );
+				}
+				if( !( record.flags & ESP_KV_DELETED ) ){
+					slot = esp::kvFind( f, key, hash );
+					esp::kvIndex[ slot ].hash = hash;
+					esp::kvIndex[ slot ].offset = offset;
+					esp::kvIndex[ slot ].size = size;
+					esp::kvLiveSize += size;
+				}
+			}else{
+				esp::kvStats.dropped++;
+			}
+			offset += size;
+		}
+		f.close();
+		esp::kvLogSize = offset;
+		if( esp::kvStats.dropped ) ESP_DEBUG( "ESP: KV index is full, %lu records are not indexed\n", (unsigned long)esp::kvStats.dropped );
+
+		// broken tail (power lost while writing) is dropped by rewrite, if it fails
+		// values are readable and writes are refused until kvCompact succeeds
+		if( offset < fileSize ){
+			ESP_DEBUG( "ESP: KV log broken at %lu / %lu\n", (unsigned long)offset, (unsigned long)fileSize );
+			esp::kvCompact();
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Open log for append, broken tail is removed first (records after it would be lost by kvInit)
+	static File kvOpenLog(void)
+	{
+		File f = ESP_FS.open( ESP_KV_FILE, "a+" );
+		if( f && f.size() != esp::kvLogSize ){
+			f.close();
+			if( !esp::kvCompact() ) return File();
+			f = ESP_FS.open( ESP_KV_FILE, "a+" );
+		}
+		return f;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Compact log when it is big and at least half of it is garbage
+	static void kvCheckCompact(void)
+	{
+		if( esp::kvLogSize > ESP_KV_COMPACT_SIZE && esp::kvLiveSize * 2 < esp::kvLogSize ) esp::kvCompact();
+	}
+
+	//-------------------------------------------------------------------------------
+	bool kvPut(const char* key, const void* value, const uint16_t length)
+	{
+		if( !esp::flags.useFS || key == nullptr || *key == '\0' || strlen( key ) > ESP_KV_KEY_MAX_LEN || ( value == nullptr && length ) ) return false;
+
+		File f = esp::kvOpenLog();
+		if( !f ) return false;
+		uint32_t hash = esp::kvHash( key );
+		int16_t slot = esp::kvFind( f, key, hash );
+		if( slot < 0 ){
+			f.close();
+			return false;
+		}
+		f.seek( f.size() );
+		uint32_t offset = esp::kvAppend( f, key, (const uint8_t*)value, length, 0 );
+		f.close();
+		if( offset == ESP_KV_EMPTY ) return false;
+
+		KvIndexEntry &entry = esp::kvIndex[ slot ];
+		if( entry.offset != ESP_KV_EMPTY ) esp::kvLiveSize -= entry.size;
+		entry.hash = hash;
+		entry.offset = offset;
+		entry.size = sizeof( KvRecord ) + strlen( key ) + length;
+		esp::kvLiveSize += entry.size;
+		esp::kvLogSize = offset + entry.size;
+		esp::kvStats.puts++;
+
+		esp::kvCheckCompact();
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	int32_t kvGet(const char* key, void* value, const uint16_t size)
+	{
+		if( !esp::flags.useFS || key == nullptr ) return -1;
+
+		File f = ESP_FS.open( ESP_KV_FILE, "r" );
+		if( !f ) return -1;
+		int32_t res = -1;
+		int16_t slot = esp::kvFind( f, key, esp::kvHash( key ) );
+		if( slot >= 0 && esp::kvIndex[ slot ].offset != ESP_KV_EMPTY ){
+			KvRecord record;
+			char name[ ESP_KV_KEY_MAX_LEN + 1 ];
+			if( esp::kvReadRecord( f, esp::kvIndex[ slot ].offset, record, name, key, (uint8_t*)value, size ) ){
+				res = record.length;
+			}
+		}
+		f.close();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool kvRemove(const char* key)
+	{
+		if( !esp::flags.useFS || key == nullptr ) return false;
+
+		File f = esp::kvOpenLog();
+		if( !f ) return false;
+		int16_t slot = esp::kvFind( f, key, esp::kvHash( key ) );
+		if( slot < 0 || esp::kvIndex[ slot ].offset == ESP_KV_EMPTY ){
+			f.close();
+			return false;
+		}
+		f.seek( f.size() );
+		uint32_t offset = esp::kvAppend( f, key, nullptr, 0, ESP_KV_DELETED );
+		f.close();
+		if( offset == ESP_KV_EMPTY ) return false;
+
+		esp::kvLiveSize -= esp::kvIndex[ slot ].size;
+		esp::kvLogSize = offset + sizeof( KvRecord ) + strlen( key );
+		esp::kvIndexRemove( slot );
+		esp::kvCheckCompact();
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool kvCompact(void)
+	{
+		if( !esp::flags.useFS ) return false;
+		// values of keys out of index would be lost
+		if( esp::kvStats.dropped ){
+			ESP_DEBUG( "ESP: KV compact refused, %lu records are not indexed\n", (unsigned long)esp::kvStats.dropped );
+			return false;
+		}
+		ESP_DEBUG( "ESP: KV compact %lu -> %lu\n", (unsigned long)esp::kvLogSize, (unsigned long)esp::kvLiveSize );
+
+		File src = ESP_FS.open( ESP_KV_FILE, "r" );
+		File dst = ESP_FS.open( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX, "w" );
+		if( !src || !dst ){
+			if( src ) src.close();
+			if( dst ) dst.close();
+			return false;
+		}
+
+		// copy live records as is, checked by kvReadRecord, index is kept for old log until rename
+		bool error = false;
+		uint32_t offset = 0;
+		uint8_t buff[ 64 ];
+		KvRecord record;
+		char key[ ESP_KV_KEY_MAX_LEN + 1 ];
+		for( uint16_t i = 0; i < ESP_KV_INDEX_SIZE && !error; i++ ){
+			KvIndexEntry &entry = esp::kvIndex[ i ];
+			if( entry.offset == ESP_KV_EMPTY ) continue;
+			if( !esp::kvReadRecord( src, entry.offset, record, key, nullptr, nullptr, 0 ) || !src.seek( entry.offset ) ){
+				error = true;
+				break;
+			}
+			uint32_t pos = 0;
+			while( pos < entry.size ){
+				uint32_t part = entry.size - pos;
+				if( part > sizeof( buff ) ) part = sizeof( buff );
+				if( src.read( buff, part ) != part || dst.write( buff, part ) != part ){
+					error = true;
+					break;
+				}
+				pos += part;
+			}
+			offset += entry.size;
+			esp::kvStats.bytesWritten += entry.size;
+		}
+		src.close();
+		dst.close();
+
+		if( error ){
+			ESP_DEBUG( "ESP: KV compact error\n" );
+			ESP_FS.remove( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX );
+			return false;
+		}
+		// new log is taken by kvInit if rename fails after removal
+		if( !ESP_FS.remove( ESP_KV_FILE ) || !ESP_FS.rename( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX, ESP_KV_FILE ) ){
+			ESP_DEBUG( "ESP: KV compact rename error\n" );
+			return false;
+		}
+
+		// records are in index order
+		offset = 0;
+		for( uint16_t i = 0; i < ESP_KV_INDEX_SIZE; i++ ){
+			KvIndexEntry &entry = esp::kvIndex[ i ];
+			if( entry.offset == ESP_KV_EMPTY ) continue;
+			entry.offset = offset;
+			offset += entry.size;
+		}
+		esp::kvLogSize = offset;
+		esp::kvLiveSize = offset;
+		esp::kvStats.compactions++;
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	void changeSystemUserPassword(const char* login, const char* password)
+	{
+		if( login == nullptr || password == nullptr ) return;
+		if( strlen( login ) > sizeof( esp::systemLogin ) ) return;
+		if( strlen( password ) > sizeof( esp::systemPassword ) ) return;
+
+		strcpy( esp::systemLogin, login );
+		strcpy( esp::systemPassword, password );
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void updateProcess(ESP8266WebServer *webServer)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void updateProcess(WebServer *webServer)
+#endif
+	{
+		HTTPUpload& upload = webServer->upload();
+		if( upload.status == UPLOAD_FILE_START ){
+			esp::flags.updateError = 0;
+			esp::flags.updateFirmware = 0;
+			esp::flags.updateFile = 0;
+			ESP_DEBUG( "Update: %s [ %s ]\n", upload.filename.c_str(), upload.name.c_str() );
+
+			if( webServer->hasArg( "sdf" ) ){
+				ESP_DEBUG( "[%s/%s]\n", webServer->arg( "sdf" ).c_str(), esp::updateKey );
+				if( strcmp( webServer->arg( "sdf" ).c_str(), esp::updateKey ) == 0 ){
+					if( upload.name == "firmware" && upload.filename == ESP_FIRMWARE_FILENAME ){
+						ESP_DEBUG( "Update begin\n" );
+						esp::flags.updateFirmware = 1;
+
+						// if( !Update.begin( UPDATE_SIZE_UNKNOWN ) ){ //start with max available size
+#if defined(ARDUINO_ARCH_ESP8266)
+						if( !Update.begin( upload.contentLength ) ){
+#elif defined(ARDUINO_ARCH_ESP32)
+						if( !Update.begin( upload.totalSize ) ){
+#endif
+							Update.printError( Serial );
+							webServer->send ( 500, "text/html", "update begin fs error" );
+							esp::flags.updateError = 1;
+							esp::flags.updateFirmware = 0;
+						}
+					}else if( upload.name == "filesystem" ){
+						ESP_DEBUG( "Update begin\n" );
+						esp::flags.updateFirmware = 1;
+
+#if defined(ARDUINO_ARCH_ESP8266)
+						if( !Update.begin( upload.contentLength, U_FS ) ){
+#elif defined(ARDUINO_ARCH_ESP32)
+						if( !Update.begin( upload.totalSize, U_SPIFFS ) ){
+#endif
+							Update.printError( Serial );
+							webServer->send ( 500, "text/html", "update begin fs error" );
+							esp::flags.updateError = 1;
+							esp::flags.updateFirmware = 0;
+						}
+					}else if( upload.name == "file" ){
+						String path = "/" + upload.filename;
+						esp::webCacheInvalidate( path.c_str() );
+						updateFile = ESP_FS.open( path, "w" );
+						if( updateFile ){
+							esp::flags.updateFile = 1;
+						}else{
+							esp::flags.updateError = 1;
+						}
+					}else{
+						ESP_DEBUG( "Unknown update\n" );
+						webServer->send ( 500, "text/html", "Unknown update: error" );
+						esp::flags.updateError = 1;
+					}
+				}else{
+					ESP_DEBUG( "Unknown key\n" );
+					webServer->send ( 500, "text/html", "Update: Unknown key :(" );
+					esp::flags.updateError = 1;
+				}
+			}else{
+				ESP_DEBUG( "Unknown key\n" );
+				webServer->send ( 500, "text/html", "Update: Unknown key :(" );
+				esp::flags.updateError = 1;
+			}
+		}else if( upload.status == UPLOAD_FILE_WRITE ){
+			// flashing firmware to ESP
+			if( !esp::flags.updateError && esp::flags.updateFirmware ){
+				if( Update.write( upload.buf, upload.currentSize ) != upload.currentSize ){
+					Update.printError( Serial );
+					webServer->send ( 500, "text/html", "update error" );
+					esp::flags.updateError = 1;
+				}
+			}else if( !esp::flags.updateError && esp::flags.updateFile ){
+				if( updateFile ){
+					updateFile.write( upload.buf, upload.currentSize );
+				}else{
+					esp::flags.updateError = 1;
+				}
+			}
+		}else if( upload.status == UPLOAD_FILE_END ){
+			// finish flashing firmware to ESP
+			if( !esp::flags.updateError && esp::flags.updateFirmware ){
+				if( Update.end( true ) ){ //true to set the size to the current progress
+					ESP_DEBUG( "Update Success: %u\nRebooting...\n", upload.totalSize );
+				}else{
+					Update.printError( Serial );
+					webServer->send ( 500, "text/html", "update error 2" );
+					esp::flags.updateError = 1;
+				}
+			}else if( !esp::flags.updateError && esp::flags.updateFile ){
+				if( updateFile ){
+					// if( upload.currentSize ) updateFile.write( upload.buf, upload.currentSize );
+					updateFile.close();
+				}
+				// file could be cached by request during upload
+				esp::webCacheInvalidate( ( "/" + upload.filename ).c_str() );
+			}
+		}else if( upload.status == UPLOAD_FILE_ABORTED ){
+			Update.end();
+			ESP_DEBUG( "Update was aborted\n" );
+			webServer->send ( 500, "text/html", "update aborted" );
+			esp::flags.updateError = 1;
+		}
+
+		
+		/*
+		HTTPUpload& upload = webServer->upload();
+
+		ESP_DEBUG( "updateProcess [%s][%s] %d %d/%d\n", upload.name, upload.filename, upload.status, upload.currentSize, upload.totalSize );
+
+		if( upload.status == UPLOAD_FILE_START ){
+			esp::flags.updateError = 0;
+			if( upload.name == "filesystem" ){
+#if defined(ARDUINO_ARCH_ESP8266)
+				FSInfo64 info;
+				bool resInfo = LittleFS.info64( info );
+				size_t fsSize = info.totalBytes - info.usedBytes;
+				LittleFS.end();
+				//start with max available size
+				if( !Update.begin( fsSize, U_FS ) ){
+#elif defined(ARDUINO_ARCH_ESP32)
+				size_t fsSize = SPIFFS.totalBytes() - SPIFFS.usedBytes();
+				SPIFFS.end();
+				//start with max available size
+				if( !Update.begin( fsSize, U_SPIFFS ) ){
+#endif
+					webServer->send ( 500, "text/html", "update begin fs error" );
+					esp::flags.updateError = 1;
+				}
+			}else if( upload.name == "firmware" && upload.filename == ESP_FIRMWARE_FILENAME ){
+				ESP_DEBUG( "Update begin\n" );
+				uint32_t maxSketchSpace = ( ESP.getFreeSketchSpace() - 0x1000 ) & 0xFFFFF000;
+				//start with max available size
+				if( !Update.begin( maxSketchSpace, U_FLASH ) ){
+					webServer->send ( 500, "text/html", "update begin firmware error" );
+					esp::flags.updateError = 1;
+				}
+			}
+		}else if( upload.status == UPLOAD_FILE_WRITE && !esp::flags.updateError ){
+			ESP_DEBUG( "." );
+			if( Update.write( upload.buf, upload.currentSize ) != upload.currentSize ){
+				webServer->send ( 500, "text/html", "update error" );
+			}
+		}else if( upload.status == UPLOAD_FILE_END && !esp::flags.updateError ){
+			//true to set the size to the current progress
+			if( Update.end( true ) ){
+				ESP_DEBUG( "Update Success: %zu\nRebooting...\n", upload.totalSize );
+			} else {
+				webServer->send ( 500, "text/html", "update error" );
+			}
+		}else if( upload.status == UPLOAD_FILE_ABORTED ){
+			Update.end();
+			ESP_DEBUG( "Update was aborted\n" );
+			webServer->send ( 500, "text/html", "update aborted" );
+		}
+		*/
+	}
+
+	//-------------------------------------------------------------------------------
+	void setVersion(const uint8_t first, const uint8_t second, const uint16_t thrid)
+	{
+		esp::firstVersion = first;
+		esp::secondVersion = second;
+		esp::thridVersion = thrid;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t getMode(void)
+	{
+		return esp::app.mode;
+	}
+
+	//-------------------------------------------------------------------------------
+	void setMode(const uint8_t value)
+	{
+		esp::app.mode = value;
+		saveSystemSettings();
+	}
+
+	//-------------------------------------------------------------------------------
+	void saveSystemSettings(void)
+	{
+		if( !esp::flags.useFS ) return;
+
+		// skip identical write, defer changes to coalesce bursts (see esp::handle)
+		if( memcmp( &esp::app, &esp::appSaved, sizeof( Data ) ) == 0 ){
+			esp::settingsDirty = false;
+			return;
+		}
+#if ESP_SETTINGS_FLUSH_DELAY > 0
+		esp::settingsDirty = true;
+		esp::settingsFlushTime = millis() + ESP_SETTINGS_FLUSH_DELAY;
+#else
+		esp::flushSystemSettings();
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void flushSystemSettings(void)
+	{
+		esp::settingsDirty = false;
+		if( !esp::flags.useFS || memcmp( &esp::app, &esp::appSaved, sizeof( Data ) ) == 0 ) return;
+
+		ESP_DEBUG( "ESP: saveSystemSettings...\n" );
+		saveSettings( (uint8_t*)&app, sizeof( app ), ESP_SYSTEM_CONFIG_FILE );
+		memcpy( &esp::appSaved, &esp::app, sizeof( Data ) );
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t getResetReason(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		rst_info *resetInfo;
+		resetInfo = ESP.getResetInfoPtr();
+		return resetInfo->reason;
+#elif defined(ARDUINO_ARCH_ESP32)
+		return rtc_get_reset_reason( 0 );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Count frames for channel hopping, then pass to installed callback
+#if defined(ARDUINO_ARCH_ESP8266)
+	static void promiscCountCb(uint8_t *buf, uint16_t len)
+#elif defined(ARDUINO_ARCH_ESP32)
+	static void promiscCountCb(void *buf, wifi_promiscuous_pkt_type_t type)
+#endif
+	{
+		__atomic_fetch_add( &esp::hopFrames, 1, __ATOMIC_RELAXED );
+#if defined(ARDUINO_ARCH_ESP8266)
+		esp::promiscUserCb( buf, len );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp::promiscUserCb( buf, type );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void enablePromiscMode(wifi_promiscuous_cb_t func)
+	{
+		ESP_DEBUG( "ESP: Enabled Promiscous mode at %u chanel\n", PROMISCUOUS_MODE_CHANNEL );
+
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_set_opmode( STATION_MODE );
+		WiFi.disconnect();
+		wifi_set_channel( PROMISCUOUS_MODE_CHANNEL );
+#elif defined(ARDUINO_ARCH_ESP32)
+		WiFi.mode( WiFiMode_t::WIFI_STA );
+		WiFi.disconnect();
+		esp_wifi_set_channel( PROMISCUOUS_MODE_CHANNEL, WIFI_SECOND_CHAN_NONE );
+		// frames of other types are dropped by hardware, callback is not called
+		wifi_promiscuous_filter_t filter;
+		filter.filter_mask = esp::promiscFilter;
+		esp_wifi_set_promiscuous_filter( &filter );
+#endif
+		
+		// frames are counted for channel hopping and passed to func
+		esp::promiscUserCb = ( func == nullptr ) ? promisc_rx_cb : func;
+		esp::hopStatus.channel = PROMISCUOUS_MODE_CHANNEL;
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_set_promiscuous_rx_cb( esp::promiscCountCb );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_wifi_set_promiscuous_rx_cb( esp::promiscCountCb );
+#endif
+
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_promiscuous_enable( true );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_wifi_set_promiscuous( true );
+#endif
+
+		esp::app.mode = esp::Mode::PROMISCUOUS;
+	}
+
+	//-------------------------------------------------------------------------------
+	void disablePromiscMode(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_promiscuous_enable( false );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_wifi_set_promiscuous( false );
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void startChannelHopping(const uint16_t channels)
+	{
+		esp::hopChannels = channels & ( ( 1 << ( ESP_HOP_CHANNELS_MAX + 1 ) ) - 2 );
+		esp::hopStatus.channels = esp::hopChannels;
+		if( esp::hopChannels == 0 ) return;
+
+		ESP_DEBUG( "ESP: Channel hopping 0x%04X\n", esp::hopChannels );
+		esp::hopDwell = ESP_HOP_DWELL_MIN;
+		esp::hopStart = millis();
+		esp::hopFramesStart = __atomic_load_n( &esp::hopFrames, __ATOMIC_RELAXED );
+	}
+
+	//-------------------------------------------------------------------------------
+	void stopChannelHopping(void)
+	{
+		esp::hopChannels = 0;
+		esp::hopStatus.channels = 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Close dwell on current channel and move to next one, called from esp::handle()
+	static void hopHandle(void)
+	{
+		if( esp::hopChannels == 0 || esp::app.mode != esp::Mode::PROMISCUOUS ) return;
+
+		uint32_t now = millis();
+		uint32_t elapsed = now - esp::hopStart;
+		if( elapsed < esp::hopDwell ) return;
+
+		// traffic of finished dwell, rate is EWMA of frames/sec
+		uint32_t frames = __atomic_load_n( &esp::hopFrames, __ATOMIC_RELAXED );
+		uint8_t channel = esp::hopStatus.channel;
+		if( channel >= 1 && channel <= ESP_HOP_CHANNELS_MAX ){
+			HopChannelStats &stats = esp::hopChannelStats[ channel - 1 ];
+			uint32_t count = frames - esp::hopFramesStart;
+			stats.frames += count;
+			stats.visits++;
+			stats.time += elapsed;
+			stats.rate = ( stats.rate * 3 + count * 1000 / elapsed ) / 4;
+		}
+
+		// next channel of set
+		uint32_t maxRate = 1;
+		for( uint8_t ch = 1; ch <= ESP_HOP_CHANNELS_MAX; ch++ ){
+			if( ( esp::hopChannels & ( 1 << ch ) ) && esp::hopChannelStats[ ch - 1 ].rate > maxRate ) maxRate = esp::hopChannelStats[ ch - 1 ].rate;
+		}
+		do{
+			channel = ( channel >= ESP_HOP_CHANNELS_MAX ) ? 1 : channel + 1;
+		}while( !( esp::hopChannels & ( 1 << channel ) ) );
+
+		// busy channels get longer dwell
+		esp::hopDwell = ESP_HOP_DWELL_MIN + (uint32_t)( ESP_HOP_DWELL_MAX - ESP_HOP_DWELL_MIN ) * esp::hopChannelStats[ channel - 1 ].rate / maxRate;
+		esp::hopChannelStats[ channel - 1 ].dwell = esp::hopDwell;
+
+		uint32_t start = micros();
+#if defined(ARDUINO_ARCH_ESP8266)
+		wifi_set_channel( channel );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_wifi_set_channel( channel, WIFI_SECOND_CHAN_NONE );
+#endif
+		esp::hopStatus.latency = micros() - start;
+		if( esp::hopStatus.latency > esp::hopStatus.latencyMax ) esp::hopStatus.latencyMax = esp::hopStatus.latency;
+		esp::hopStatus.hops++;
+		esp::hopStatus.channel = channel;
+
+		esp::hopStart = millis();
+		esp::hopFramesStart = __atomic_load_n( &esp::hopFrames, __ATOMIC_RELAXED );
+	}
+
+	//-------------------------------------------------------------------------------
+	void setPromiscFilter(const uint32_t mask)
+	{
+		esp::promiscFilter = mask;
+#if defined(ARDUINO_ARCH_ESP32)
+		if( esp::app.mode == esp::Mode::PROMISCUOUS ){
+			wifi_promiscuous_filter_t filter;
+			filter.filter_mask = mask;
+			esp_wifi_set_promiscuous_filter( &filter );
+		}
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	// Copy frame to ring, producer side (WiFi driver context): one memcpy, no logging
+	static void promiscPush(const uint8_t* buf, const uint16_t len)
+	{
+		uint32_t head = __atomic_load_n( &esp::promiscHead, __ATOMIC_RELAXED );
+		uint32_t tail = __atomic_load_n( &esp::promiscTail, __ATOMIC_ACQUIRE );
+		if( head - tail >= ESP_PROMISC_SLOTS ){
+			esp::promiscStats.dropped++;
+			return;
+		}
+
+		PromiscFrame &frame = esp::promiscRing[ head & ( ESP_PROMISC_SLOTS - 1 ) ];
+		frame.len = len;
+		frame.size = len;
+		if( len > ESP_PROMISC_SLOT_SIZE ){
+			frame.size = ESP_PROMISC_SLOT_SIZE;
+			esp::promiscStats.overrun++;
+		}
+		frame.time = millis();
+		memcpy( frame.data, buf, frame.size );
+		esp::promiscStats.captured++;
+
+		__atomic_store_n( &esp::promiscHead, head + 1, __ATOMIC_RELEASE );
+	}
+
+	//-------------------------------------------------------------------------------
+	uint16_t promiscAvailable(void)
+	{
+		return __atomic_load_n( &esp::promiscHead, __ATOMIC_ACQUIRE ) - __atomic_load_n( &esp::promiscTail, __ATOMIC_RELAXED );
+	}
+
+	//-------------------------------------------------------------------------------
+	uint16_t promiscDrain(PromiscFrameCallback cb, const uint16_t max)
+	{
+		uint16_t count = 0;
+		uint32_t tail = __atomic_load_n( &esp::promiscTail, __ATOMIC_RELAXED );
+		uint32_t head = __atomic_load_n( &esp::promiscHead, __ATOMIC_ACQUIRE );
+		while( tail != head && ( max == 0 || count < max ) ){
+			// slot belongs to consumer until tail is moved
+			if( cb != nullptr ) cb( esp::promiscRing[ tail & ( ESP_PROMISC_SLOTS - 1 ) ] );
+			tail++;
+			__atomic_store_n( &esp::promiscTail, tail, __ATOMIC_RELEASE );
+			count++;
+			if( tail == head ) head = __atomic_load_n( &esp::promiscHead, __ATOMIC_ACQUIRE );
+		}
+		return count;
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	void promisc_rx_cb(uint8_t *buf, uint16_t len)
+#elif defined(ARDUINO_ARCH_ESP32)
+	void promisc_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type)
+#endif
+	{
+		static uint8_t counter = 0;
+
+#if defined(ARDUINO_ARCH_ESP8266)
+		// no hardware filter: 12 bytes RxControl, then 802.11 header (if any), type is bits 2-3 of frame control
+		uint32_t typeMask = ( len > 12 ) ? ( 1UL << ( ( buf[ 12 ] >> 2 ) & 0x03 ) ) : ESP_PROMISC_FILTER_MISC;
+		if( typeMask & esp::promiscFilter ){
+			esp::promiscPush( buf, len );
+		}else{
+			esp::promiscStats.filtered++;
+		}
+#elif defined(ARDUINO_ARCH_ESP32)
+		// rx_ctrl + frame (sig_len with FCS), frame type is filtered by hardware
+		const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+		esp::promiscPush( (const uint8_t*)buf, sizeof( wifi_pkt_rx_ctrl_t ) + pkt->rx_ctrl.sig_len );
+#endif
+
+		// sniffer without raw configuration window runs forever
+		if( !esp::provWindow ) return;
+
+		// window is extended while provisioning message is received
+		if( counter >= READ_RAW_PACKETS_BEFORE_START && !esp::provBusy ){
+			disablePromiscMode();
+			// no FS writes in WiFi driver context, deferred settings are flushed by esp::handle()
+			if( esp::settingsDirty ){
+				esp::restartPending = true;
+			}else{
+				ESP.restart();
+			}
+			// while( 1 );
+			return;
+		}
+
+		if( counter < 255 ) counter++;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool parseFrame(const PromiscFrame &raw, WifiFrame &frame)
+	{
+		const uint8_t* data;
+		uint16_t len;
+#if defined(ARDUINO_ARCH_ESP8266)
+		// RxControl: rssi at byte 0, channel at low bits of byte 10; frame after 12 bytes,
+		// 112 bytes for management frames (len 128), 36 bytes of header for other ones
+		if( raw.size <= 12 ) return false;
+		frame.rssi = (int8_t)raw.data[ 0 ];
+		frame.channel = raw.data[ 10 ] & 0x0F;
+		data = raw.data + 12;
+		len = ( raw.len == 128 ) ? 112 : 36;
+		if( len > raw.size - 12 ) len = raw.size - 12;
+#elif defined(ARDUINO_ARCH_ESP32)
+		if( raw.size <= sizeof( wifi_pkt_rx_ctrl_t ) ) return false;
+		const wifi_pkt_rx_ctrl_t* ctrl = (const wifi_pkt_rx_ctrl_t*)raw.data;
+		frame.rssi = ctrl->rssi;
+		frame.channel = ctrl->channel;
+		data = raw.data + sizeof( wifi_pkt_rx_ctrl_t );
+		len = raw.size - sizeof( wifi_pkt_rx_ctrl_t );
+		// without FCS
+		if( ctrl->sig_len >= 4 && len > ctrl->sig_len - 4 ) len = ctrl->sig_len - 4;
+#endif
+		if( len < 10 ) return false;
+
+		frame.frameControl = data[ 0 ] | ( data[ 1 ] << 8 );
+		frame.type = ( data[ 0 ] >> 2 ) & 0x03;
+		frame.subtype = ( data[ 0 ] >> 4 ) & 0x0F;
+		frame.addr1 = data + 4;
+		frame.addr2 = ( len >= 16 ) ? data + 10 : nullptr;
+		frame.addr3 = nullptr;
+		frame.sequence = 0;
+		frame.body = nullptr;
+		frame.bodyLen = 0;
+		// control frames have no addr3 and sequence
+		if( frame.type == ESP_FRAME_TYPE_CTRL || len < 24 ) return true;
+
+		frame.addr3 = data + 16;
+		frame.sequence = ( data[ 22 ] | ( data[ 23 ] << 8 ) ) >> 4;
+		uint16_t header = 24;
+		if( ( data[ 1 ] & 0x03 ) == 0x03 ) header += 6;							// toDS and fromDS: addr4
+		if( frame.type == ESP_FRAME_TYPE_DATA && ( frame.subtype & 0x08 ) ) header += 2;	// QoS control
+		if( len > header ){
+			frame.body = data + header;
+			frame.bodyLen = len - header;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// FNV-1a of MAC
+	static uint16_t macHash(const uint8_t* mac)
+	{
+		uint32_t hash = 2166136261UL;
+		for( uint8_t i = 0; i < 6; i++ ){
+			hash ^= mac[ i ];
+			hash *= 16777619UL;
+		}
+		return hash & ( ESP_MAC_TABLE_SIZE - 1 );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Remove entry with linear probing backward shift
+	static void macTableRemove(uint16_t slot)
+	{
+		uint16_t next = slot;
+		while( true ){
+			next = ( next + 1 ) & ( ESP_MAC_TABLE_SIZE - 1 );
+			MacStats &entry = esp::macTable[ next ];
+			if( entry.packets == 0 ) break;
+			uint16_t home = esp::macHash( entry.mac );
+			if( ( next > slot ) ? ( home <= slot || home > next ) : ( home <= slot && home > next ) ){
+				esp::macTable[ slot ] = entry;
+				slot = next;
+			}
+		}
+		esp::macTable[ slot ].packets = 0;
+		esp::macTableStats.entries--;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Remove entries not seen for ESP_MAC_MAX_AGE
+	static void macTableAge(const uint32_t now)
+	{
+		uint16_t i = 0;
+		while( i < ESP_MAC_TABLE_SIZE ){
+			MacStats &entry = esp::macTable[ i ];
+			if( entry.packets != 0 && now - entry.lastSeen > ESP_MAC_MAX_AGE ){
+				// shifted entry takes this slot, check it again
+				esp::macTableRemove( i );
+				esp::macTableStats.expired++;
+				continue;
+			}
+			i++;
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Probe request SSID (first element of body)
+	static void macTableProbe(MacStats &entry, const WifiFrame &frame)
+	{
+		if( frame.bodyLen < 2 || frame.body[ 0 ] != 0 || frame.body[ 1 ] == 0 || frame.body[ 1 ] > 32 || frame.body[ 1 ] + 2 > frame.bodyLen ) return;
+
+		memcpy( entry.ssid, frame.body + 2, frame.body[ 1 ] );
+		entry.ssid[ frame.body[ 1 ] ] = '\0';
+
+		uint32_t hash = esp::crc32( frame.body + 2, frame.body[ 1 ] );
+		for( uint8_t i = 0; i < entry.probeCount && i < ESP_MAC_PROBE_SSIDS; i++ ){
+			if( entry.probes[ i ] == hash ) return;
+		}
+		if( entry.probeCount < ESP_MAC_PROBE_SSIDS ) entry.probes[ entry.probeCount ] = hash;
+		if( entry.probeCount < 255 ) entry.probeCount++;
+	}
+
+	//-------------------------------------------------------------------------------
+	void macTableAdd(const WifiFrame &frame, const uint32_t time)
+	{
+		if( frame.addr2 == nullptr ) return;
+
+		if( time - esp::macTableAgeTime >= ESP_MAC_AGE_INTERVAL ){
+			esp::macTableAgeTime = time;
+			esp::macTableAge( time );
+		}
+
+		uint16_t slot = esp::macHash( frame.addr2 );
+		while( esp::macTable[ slot ].packets != 0 && memcmp( esp::macTable[ slot ].mac, frame.addr2, 6 ) != 0 ){
+			slot = ( slot + 1 ) & ( ESP_MAC_TABLE_SIZE - 1 );
+		}
+
+		if( esp::macTable[ slot ].packets == 0 ){
+			// keep one slot free for probing, evict least recently seen
+			if( esp::macTableStats.entries >= ESP_MAC_TABLE_SIZE - 1 ){
+				uint16_t oldest = slot;
+				for( uint16_t i = 0; i < ESP_MAC_TABLE_SIZE; i++ ){
+					if( esp::macTable[ i ].packets == 0 ) continue;
+					if( oldest == slot || (int32_t)( esp::macTable[ i ].lastSeen - esp::macTable[ oldest ].lastSeen ) < 0 ) oldest = i;
+				}
+				esp::macTableRemove( oldest );
+				esp::macTableStats.evictions++;
+				slot = esp::macHash( frame.addr2 );
+				while( esp::macTable[ slot ].packets != 0 ) slot = ( slot + 1 ) & ( ESP_MAC_TABLE_SIZE - 1 );
+			}
+			MacStats &entry = esp::macTable[ slot ];
+			memset( &entry, 0, sizeof( MacStats ) );
+			memcpy( entry.mac, frame.addr2, 6 );
+			entry.firstSeen = time;
+			esp::macTableStats.entries++;
+		}
+
+		MacStats &entry = esp::macTable[ slot ];
+		entry.packets++;
+		entry.lastSeen = time;
+		entry.rssiSum += frame.rssi;
+		entry.channel = frame.channel;
+		entry.sequence = frame.sequence;
+		if( frame.type == ESP_FRAME_TYPE_MGMT && frame.subtype == ESP_FRAME_SUBTYPE_PROBE_REQ ) esp::macTableProbe( entry, frame );
+		esp::macTableStats.frames++;
+	}
+
+	//-------------------------------------------------------------------------------
+	void aggregateFrame(const PromiscFrame &raw)
+	{
+		WifiFrame frame;
+		if( esp::parseFrame( raw, frame ) ) esp::macTableAdd( frame, raw.time );
+	}
+
+	//-------------------------------------------------------------------------------
+	void macTableJson(JsonWriter &json, const uint32_t now)
+	{
+		char mac[ 18 ];
+		json.beginArray();
+		for( uint16_t i = 0; i < ESP_MAC_TABLE_SIZE; i++ ){
+			const MacStats &entry = esp::macTable[ i ];
+			if( entry.packets == 0 ) continue;
+			snprintf( mac, sizeof( mac ), "%02x:%02x:%02x:%02x:%02x:%02x", entry.mac[ 0 ], entry.mac[ 1 ], entry.mac[ 2 ], entry.mac[ 3 ], entry.mac[ 4 ], entry.mac[ 5 ] );
+			json.beginObject();
+			json.key( "mac" ).str( mac );
+			json.key( "ch" ).unum( entry.channel );
+			json.key( "rssi" ).num( entry.rssiSum / (int32_t)entry.packets );
+			json.key( "packets" ).unum( entry.packets );
+			json.key( "first" ).unum( ( now - entry.firstSeen ) / 1000 );
+			json.key( "last" ).unum( ( now - entry.lastSeen ) / 1000 );
+			json.key( "probes" ).unum( entry.probeCount );
+			if( entry.ssid[ 0 ] != '\0' ) json.key( "ssid" ).str( entry.ssid );
+			json.endObject();
+		}
+		json.endArray();
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t macTableExport(uint8_t* buff, const size_t size, const uint32_t now)
+	{
+		if( buff == nullptr || size < 2 ) return 0;
+
+		// uint16 count, then records: mac[6], channel, rssi, packets, first age, last age (sec), probes
+		size_t pos = 2;
+		uint16_t count = 0;
+		for( uint16_t i = 0; i < ESP_MAC_TABLE_SIZE && pos + ESP_MAC_EXPORT_RECORD_SIZE <= size; i++ ){
+			const MacStats &entry = esp::macTable[ i ];
+			if( entry.packets == 0 ) continue;
+			uint8_t* p = buff + pos;
+			memcpy( p, entry.mac, 6 );
+			p[ 6 ] = entry.channel;
+			p[ 7 ] = (uint8_t)(int8_t)( entry.rssiSum / (int32_t)entry.packets );
+			uint32_t values[ 3 ] = { entry.packets, ( now - entry.firstSeen ) / 1000, ( now - entry.lastSeen ) / 1000 };
+			for( uint8_t v = 0; v < 3; v++ ){
+				for( uint8_t b = 0; b < 4; b++ ) p[ 8 + v * 4 + b ] = values[ v ] >> ( b * 8 );
+			}
+			p[ 20 ] = entry.probeCount;
+			pos += ESP_MAC_EXPORT_RECORD_SIZE;
+			count++;
+		}
+		buff[ 0 ] = count;
+		buff[ 1 ] = count >> 8;
+
+		return pos;
+	}
+
+	//-------------------------------------------------------------------------------
+	void macTableClear(void)
+	{
+		for( uint16_t i = 0; i < ESP_MAC_TABLE_SIZE; i++ ) esp::macTable[ i ].packets = 0;
+		esp::macTableStats.entries = 0;
+	}
+
+#ifdef ESP_PROVISION_KEY
+	//-------------------------------------------------------------------------------
+	// HMAC-SHA256 of data1 + data2 (key up to 64 bytes)
+	static void hmacSha256(const uint8_t* key, const size_t keyLen, const uint8_t* data1, const size_t len1, const uint8_t* data2, const size_t len2, uint8_t* out)
+	{
+		uint8_t pad[ 64 ];
+		Sha256Context ctx;
+
+		for( uint8_t i = 0; i < sizeof( pad ); i++ ) pad[ i ] = ( ( i < keyLen ) ? key[ i ] : 0 ) ^ 0x36;
+		esp::sha256Begin( ctx );
+		esp::sha256Update( ctx, pad, sizeof( pad ) );
+		esp::sha256Update( ctx, data1, len1 );
+		esp::sha256Update( ctx, data2, len2 );
+		esp::sha256Finish( ctx, out );
+
+		for( uint8_t i = 0; i < sizeof( pad ); i++ ) pad[ i ] ^= 0x36 ^ 0x5C;
+		esp::sha256Begin( ctx );
+		esp::sha256Update( ctx, pad, sizeof( pad ) );
+		esp::sha256Update( ctx, out, 32 );
+		esp::sha256Finish( ctx, out );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Check and apply reassembled message
+	static bool provApply(void)
+	{
+		// flags, counter (LE), chip id (LE, 0 - any), ssid len, ssid, key len, encrypted key, hmac
+		const uint8_t* msg = esp::provBuff;
+		uint16_t len = esp::provTotal;
+		if( len < 1 + 4 + 4 + 1 + 1 + ESP_PROV_MAC_LEN ) return false;
+		len -= ESP_PROV_MAC_LEN;
+
+		// separate keys for message authentication and key encryption
+		uint8_t macKey[ 32 ];
+		uint8_t encKey[ 32 ];
+		esp::hmacSha256( (const uint8_t*)ESP_PROVISION_KEY, strlen( ESP_PROVISION_KEY ), (const uint8_t*)"mac", 3, nullptr, 0, macKey );
+		esp::hmacSha256( (const uint8_t*)ESP_PROVISION_KEY, strlen( ESP_PROVISION_KEY ), (const uint8_t*)"enc", 3, nullptr, 0, encKey );
+
+		uint8_t mac[ 32 ];
+		esp::hmacSha256( macKey, sizeof( macKey ), msg, len, nullptr, 0, mac );
+		uint8_t diff = 0;
+		for( uint8_t i = 0; i < ESP_PROV_MAC_LEN; i++ ) diff |= mac[ i ] ^ msg[ len + i ];
+		if( diff != 0 ) return false;
+
+		uint32_t counter = msg[ 1 ] | ( msg[ 2 ] << 8 ) | ( msg[ 3 ] << 16 ) | ( (uint32_t)msg[ 4 ] << 24 );
+		uint32_t chipId = msg[ 5 ] | ( msg[ 6 ] << 8 ) | ( msg[ 7 ] << 16 ) | ( (uint32_t)msg[ 8 ] << 24 );
+		if( chipId != 0 && chipId != esp::getMyID() ) return false;
+
+		uint16_t pos = 9;
+		uint8_t ssidLen = msg[ pos++ ];
+		if( ssidLen == 0 || ssidLen >= ESP_CONFIG_SSID_MAX_LEN || pos + ssidLen + 1 > len ) return false;
+		const uint8_t* ssid = msg + pos;
+		pos += ssidLen;
+		uint8_t keyLen = msg[ pos++ ];
+		if( keyLen >= ESP_CONFIG_KEY_MAX_LEN || pos + keyLen != len ) return false;
+
+		// captured message can not be replayed: counter must be above last accepted one
+		uint32_t last = 0;
+		esp::kvGet( ESP_PROV_COUNTER_KEY, &last, sizeof( last ) );
+		if( counter <= last ){
+			ESP_DEBUG( "ESP: provisioning counter %lu is not above %lu\n", (unsigned long)counter, (unsigned long)last );
+			esp::provisionStats.replayed++;
+			return false;
+		}
+		if( !esp::kvPut( ESP_PROV_COUNTER_KEY, &counter, sizeof( counter ) ) ) return false;
+
+		// key keystream: HMAC-SHA256( encKey, counter + chip id ), sender never repeats counter
+		uint8_t stream[ 32 ];
+		esp::hmacSha256( encKey, sizeof( encKey ), msg + 1, 8, nullptr, 0, stream );
+
+		memcpy( esp::app.sta_ssid, ssid, ssidLen );
+		esp::app.sta_ssid[ ssidLen ] = '\0';
+		for( uint8_t i = 0; i < keyLen; i++ ) esp::app.sta_key[ i ] = msg[ pos + i ] ^ stream[ i ];
+		esp::app.sta_key[ keyLen ] = '\0';
+		esp::app.mode = esp::Mode::STA;
+		esp::staClearCache();
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Find provisioning payload (after OUI and type) in vendor action frame or vendor element of beacon/probe request
+	static const uint8_t* provPayload(const WifiFrame &frame, uint16_t &len)
+	{
+		if( frame.type != ESP_FRAME_TYPE_MGMT || frame.body == nullptr ) return nullptr;
+
+		const uint8_t oui[ 4 ] = { ( ESP_PROV_OUI >> 16 ) & 0xFF, ( ESP_PROV_OUI >> 8 ) & 0xFF, ESP_PROV_OUI & 0xFF, ESP_PROV_TYPE };
+		const uint8_t* body = frame.body;
+		uint16_t bodyLen = frame.bodyLen;
+		if( frame.subtype == ESP_FRAME_SUBTYPE_ACTION ){
+			// vendor specific category
+			if( bodyLen < 5 || body[ 0 ] != 127 || memcmp( body + 1, oui, 4 ) != 0 ) return nullptr;
+			len = bodyLen - 5;
+			return body + 5;
+		}
+		if( frame.subtype == ESP_FRAME_SUBTYPE_BEACON ){
+			// timestamp, interval, capabilities
+			if( bodyLen < 12 ) return nullptr;
+			body += 12;
+			bodyLen -= 12;
+		}else if( frame.subtype != ESP_FRAME_SUBTYPE_PROBE_REQ ){
+			return nullptr;
+		}
+		while( bodyLen >= 2 && body[ 1 ] + 2 <= bodyLen ){
+			if( body[ 0 ] == 221 && body[ 1 ] >= 4 && memcmp( body + 2, oui, 4 ) == 0 ){
+				len = body[ 1 ] - 4;
+				return body + 6;
+			}
+			bodyLen -= body[ 1 ] + 2;
+			body += body[ 1 ] + 2;
+		}
+		return nullptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Collect chunk of provisioning message, PromiscFrameCallback
+	static void provFrame(const PromiscFrame &raw)
+	{
+		WifiFrame frame;
+		uint16_t len = 0;
+		if( !esp::parseFrame( raw, frame ) ) return;
+		const uint8_t* p = esp::provPayload( frame, len );
+		// session (LE), index, count, total length, chunk length, data
+		if( p == nullptr || len < 8 ) return;
+
+		uint32_t session = p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 );
+		uint8_t index = p[ 4 ];
+		uint8_t count = p[ 5 ];
+		uint8_t total = p[ 6 ];
+		uint8_t size = p[ 7 ];
+		uint16_t offset = index * ESP_PROV_CHUNK_SIZE;
+		if( count == 0 || count > 16 || index >= count || total > ESP_PROV_MAX_LEN || size > len - 8 || offset + size > total
+			|| size != ( ( index + 1 == count ) ? total - offset : ESP_PROV_CHUNK_SIZE ) ){
+			esp::provisionStats.rejected++;
+			return;
+		}
+
+		if( session != esp::provSession || !esp::provBusy || total != esp::provTotal || count != esp::provCount ){
+			esp::provSession = session;
+			esp::provTotal = total;
+			esp::provCount = count;
+			esp::provMask = 0;
+		}
+		esp::provBusy = true;
+		esp::provTime = millis();
+		if( esp::provMask & ( 1 << index ) ) return;
+		memcpy( esp::provBuff + offset, p + 8, size );
+		esp::provMask |= 1 << index;
+		esp::provisionStats.chunks++;
+
+		if( esp::provMask != ( 1UL << count ) - 1 ) return;
+		if( !esp::provApply() ){
+			ESP_DEBUG( "ESP: provisioning message rejected\n" );
+			esp::provisionStats.rejected++;
+			esp::provMask = 0;
+			esp::provBusy = false;
+			return;
+		}
+
+		ESP_DEBUG( "ESP: provisioned to %s\n", esp::app.sta_ssid );
+		esp::provisionStats.done++;
+		esp::provWindow = false;
+		esp::provBusy = false;
+		esp::disablePromiscMode();
+		esp::saveSystemSettings();
+		esp::flushSystemSettings();
+		esp::wifi_STA_init();
+	}
+#endif
+
+	//-------------------------------------------------------------------------------
+	// Decode provisioning frames of raw configuration window, called from esp::handle()
+	static void provHandle(void)
+	{
+#ifdef ESP_PROVISION_KEY
+		if( !esp::provWindow ) return;
+		esp::promiscDrain( esp::provFrame );
+		// unfinished session is dropped, promisc_rx_cb restarts device if window is over
+		if( esp::provBusy && millis() - esp::provTime >= ESP_PROV_TIMEOUT ) esp::provBusy = false;
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void handle(void)
+	{
+		esp::staHandle();
+		esp::scanHandle();
+		esp::hopHandle();
+		esp::provHandle();
+		if( esp::settingsDirty && (int32_t)( millis() - esp::settingsFlushTime ) >= 0 ) esp::flushSystemSettings();
+		if( esp::restartPending ) esp::restart();
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+
+#elif defined(ARDUINO_ARCH_ESP32)
+	static can_message_t canRxRing[ ESP_CAN_RX_SLOTS ];
+	static uint32_t canRxHead = 0;					// written by CAN task
+	static uint32_t canRxTail = 0;					// written by CAN_read
+	static can_message_t canTxRing[ ESP_CAN_TX_SLOTS ];
+	static uint32_t canTxHead = 0;					// written by CAN_write
+	static uint32_t canTxTail = 0;					// written by holder of canTxBusy
+	static bool canTxBusy = false;					// tx lock: submit to driver and its counters
+	static TaskHandle_t canTask = nullptr;
+	static can_status_info_t canLastStatus;			// driver counters at last canUpdateStatus
+	static uint32_t canTxSubmitted = 0;				// frames passed to driver since install
+	static uint32_t canTxDone = 0;					// of them left driver queue
+	static volatile bool canActive = false;			// driver is installed and started
+	static volatile bool canIdle = true;			// CAN task does not use driver
+	static CanFilter canFilters[ ESP_CAN_FILTERS_MAX ];
+	static uint8_t canFilterCount = 0;				// 0 - software filter is off
+	static bool canFilterMeasure = false;			// hardware filter is emulated in software
+	static can_filter_config_t canFilterConfig = CAN_FILTER_CONFIG_ACCEPT_ALL();
+	static can_timing_config_t canTiming;			// configuration of last esp::CAN_Init, for reinstall with new filter
+	static gpio_num_t canTxPin;
+	static gpio_num_t canRxPin;
+	static can_mode_t canMode;
+
+	//-------------------------------------------------------------------------------
+	// Takes tx lock, holder may be preempted task on same core, delay() lets it run
+	static void canTxLock(void)
+	{
+		while( __atomic_test_and_set( &esp::canTxBusy, __ATOMIC_SEQ_CST ) ) delay( 1 );
+	}
+
+	//-------------------------------------------------------------------------------
+	static void canTxUnlock(void)
+	{
+		__atomic_clear( &esp::canTxBusy, __ATOMIC_SEQ_CST );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Stops CAN task and CAN_write from using driver
+	static bool canPause(void)
+	{
+		bool active = esp::canActive;
+		esp::canActive = false;
+		// CAN task waits for alerts up to ESP_CAN_TASK_PERIOD
+		for( uint16_t i = 0; i < ESP_CAN_TASK_PERIOD + 50 && !esp::canIdle; i++ ) delay( 1 );
+		// submit of CAN_write in progress is finished
+		esp::canTxLock();
+		esp::canTxUnlock();
+		return active;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Acceptance filter of controller (SJA1000 layout) applied in software
+	static bool canHwAccept(const can_message_t &msg, const can_filter_config_t &config)
+	{
+		const uint32_t care = ~config.acceptance_mask;
+		const uint32_t rtr = msg.rtr ? 1 : 0;
+		const uint8_t d0 = ( !msg.rtr && msg.data_length_code > 0 ) ? msg.data[ 0 ] : 0;
+		const uint8_t d1 = ( !msg.rtr && msg.data_length_code > 1 ) ? msg.data[ 1 ] : 0;
+
+		if( config.single_filter ){
+			uint32_t value = msg.extd ? ( msg.identifier << 3 ) | ( rtr << 2 ) : ( msg.identifier << 21 ) | ( rtr << 20 ) | ( d0 << 8 ) | d1;
+			return ( ( value ^ config.acceptance_code ) & care ) == 0;
+		}
+		if( msg.extd ){
+			uint32_t value = ( msg.identifier >> 13 ) & 0xFFFF;
+			return ( ( ( value << 16 ) ^ config.acceptance_code ) & care & 0xFFFF0000 ) == 0
+				|| ( ( value ^ config.acceptance_code ) & care & 0x0000FFFF ) == 0;
+		}
+		uint32_t value1 = ( msg.identifier << 21 ) | ( rtr << 20 ) | ( ( d0 >> 4 ) << 16 ) | ( d0 & 0x0F );
+		uint32_t value2 = ( msg.identifier << 5 ) | ( rtr << 4 );
+		return ( ( value1 ^ config.acceptance_code ) & care & 0xFFFF000F ) == 0
+			|| ( ( value2 ^ config.acceptance_code ) & care & 0x0000FFF0 ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Exact filter for frames passed by hardware filter
+	static bool canSwAccept(const can_message_t &msg)
+	{
+		if( esp::canFilterCount == 0 ) return true;
+
+		for( uint8_t i = 0; i < esp::canFilterCount; i++ ){
+			const CanFilter &filter = esp::canFilters[ i ];
+			if( filter.extd == (bool)msg.extd && ( ( msg.identifier ^ filter.id ) & filter.mask ) == 0 ) return true;
+		}
+		return false;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Merges filters selected by bits of group into one code/care pair
+	// dual - 16 bit word of dual filter mode (ID28..13 or ID10..0 << 5), otherwise single filter layout
+	static bool canFilterMerge(const uint32_t group, const bool dual, uint32_t &code, uint32_t &care)
+	{
+		bool first = true;
+		for( uint8_t i = 0; i < esp::canFilterCount; i++ ){
+			if( !( group & ( 1UL << i ) ) ) continue;
+
+			const CanFilter &filter = esp::canFilters[ i ];
+			uint32_t c, k;
+			if( filter.extd ){
+				c = dual ? ( filter.id >> 13 ) & 0xFFFF : filter.id << 3;
+				k = dual ? ( filter.mask >> 13 ) & 0xFFFF : filter.mask << 3;
+			}else{
+				c = filter.id << ( dual ? 5 : 21 );
+				k = filter.mask << ( dual ? 5 : 21 );
+			}
+			if( first ){
+				code = c;
+				care = k;
+				first = false;
+			}else{
+				// bits where filters differ are don't care
+				care &= k & ~( code ^ c );
+			}
+		}
+		code &= care;
+		return !first;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Part of standard and extended ID space passed by code/care, lower is better
+	static float canFilterCost(const uint32_t care, const uint32_t stdBits, const uint32_t extBits)
+	{
+		return 1.0f / ( 1UL << __builtin_popcount( care & stdBits ) ) + 1.0f / ( 1UL << __builtin_popcount( care & extBits ) );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Chooses between single filter and every split of filters to dual filter
+	static void canFilterCompute(void)
+	{
+		uint32_t code, care;
+		can_filter_config_t &config = esp::canFilterConfig;
+
+		config = CAN_FILTER_CONFIG_ACCEPT_ALL();
+		if( !esp::canFilterMerge( 0xFFFFFFFF, false, code, care ) ) return;
+
+		config.acceptance_code = code;
+		config.acceptance_mask = ~care;
+		float best = esp::canFilterCost( care, 0xFFE00000, 0xFFFFFFF8 );
+
+		const uint32_t all = ( 1UL << esp::canFilterCount ) - 1;
+		for( uint32_t group = 1; group < all; group++ ){
+			uint32_t code1, care1, code2, care2;
+			esp::canFilterMerge( group, true, code1, care1 );
+			esp::canFilterMerge( all & ~group, true, code2, care2 );
+
+			// low nibble of filter 2 is data byte of standard frames in filter 1
+			for( uint8_t i = 0; i < esp::canFilterCount; i++ ){
+				if( ( group & ( 1UL << i ) ) && !esp::canFilters[ i ].extd ){
+					care2 &= 0xFFF0;
+					break;
+				}
+			}
+			float cost = esp::canFilterCost( care1, 0xFFE0, 0xFFFF ) + esp::canFilterCost( care2, 0xFFE0, 0xFFFF );
+			if( cost < best ){
+				best = cost;
+				config.acceptance_code = ( code1 << 16 ) | ( code2 & care2 );
+				config.acceptance_mask = ~( ( care1 << 16 ) | care2 );
+				config.single_filter = false;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Driver queue -> rx ring
+	static void canReceive(void)
+	{
+		can_message_t msg;
+		while( can_receive( &msg, 0 ) == ESP_OK ){
+			if( esp::canFilterMeasure && !esp::canHwAccept( msg, esp::canFilterConfig ) ){
+				esp::canStats.hwRejected++;
+				continue;
+			}
+			if( !esp::canSwAccept( msg ) ){
+				esp::canStats.swRejected++;
+				continue;
+			}
+			uint32_t head = __atomic_load_n( &esp::canRxHead, __ATOMIC_RELAXED );
+			if( head - __atomic_load_n( &esp::canRxTail, __ATOMIC_ACQUIRE ) >= ESP_CAN_RX_SLOTS ){
+				esp::canStats.rxOverrun++;
+				continue;
+			}
+			esp::canRxRing[ head & ( ESP_CAN_RX_SLOTS - 1 ) ] = msg;
+			__atomic_store_n( &esp::canRxHead, head + 1, __ATOMIC_RELEASE );
+			esp::canStats.rx++;
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Tx ring -> driver queue, as many as driver accepts, tx lock is held
+	// @return false if driver queue is full
+	static bool canTransmit(void)
+	{
+		uint32_t tail = __atomic_load_n( &esp::canTxTail, __ATOMIC_RELAXED );
+		uint32_t head = __atomic_load_n( &esp::canTxHead, __ATOMIC_ACQUIRE );
+		while( tail != head ){
+			if( can_transmit( &esp::canTxRing[ tail & ( ESP_CAN_TX_SLOTS - 1 ) ], 0 ) != ESP_OK ) return false;
+			esp::canTxSubmitted++;
+			tail++;
+			__atomic_store_n( &esp::canTxTail, tail, __ATOMIC_RELEASE );
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Submit tx ring from CAN_write or CAN task, whoever finds lock taken leaves frames to holder:
+	// holder checks ring again after unlock
+	static void canTxFlush(void)
+	{
+		bool more = true;
+		while( more && esp::canActive && !__atomic_test_and_set( &esp::canTxBusy, __ATOMIC_SEQ_CST ) ){
+			more = esp::canActive && esp::canTransmit();
+			esp::canTxUnlock();
+			more = more && __atomic_load_n( &esp::canTxHead, __ATOMIC_SEQ_CST ) != __atomic_load_n( &esp::canTxTail, __ATOMIC_RELAXED );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Counters from deltas of driver status, alerts are latched bits and one alert may stand for many events
+	// dropped - frames which left driver queue since last call were not sent (queue cleared by bus-off recovery)
+	// tx lock is held, submitted frames and driver queue are read consistently
+	static void canUpdateStatus(const bool dropped)
+	{
+		can_status_info_t status;
+		if( can_get_status_info( &status ) != ESP_OK ) return;
+
+		can_status_info_t &last = esp::canLastStatus;
+		uint32_t failed = status.tx_failed_count - last.tx_failed_count;
+		esp::canStats.txFailed += failed;
+		esp::canStats.busErrors += status.bus_error_count - last.bus_error_count;
+		esp::canStats.arbLost += status.arb_lost_count - last.arb_lost_count;
+		esp::canStats.driverOverrun += status.rx_missed_count - last.rx_missed_count;
+
+		// frame left driver queue: sent or failed
+		uint32_t done = esp::canTxSubmitted - status.msgs_to_tx;
+		uint32_t left = done - esp::canTxDone;
+		if( left > failed ){
+			if( dropped ){
+				esp::canStats.txFailed += left - failed;
+			}else{
+				esp::canStats.tx += left - failed;
+			}
+		}
+		esp::canTxDone = done;
+		last = status;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Moves frames between driver and rings, woken by driver alerts: rx data, tx done (refill of driver queue),
+	// errors. CAN_write submits by itself, timeout only bounds reaction to esp::canPause
+	static void canTaskLoop(void* param)
+	{
+		uint32_t alerts;
+		while( true ){
+			if( !esp::canActive ){
+				esp::canIdle = true;
+				delay( 10 );
+				continue;
+			}
+			esp::canIdle = false;
+
+			if( can_read_alerts( &alerts, pdMS_TO_TICKS( ESP_CAN_TASK_PERIOD ) ) == ESP_OK ){
+				if( alerts & CAN_ALERT_RX_DATA ) esp::canReceive();
+				if( alerts & CAN_ALERT_BUS_OFF ){
+					esp::canStats.busOff++;
+					esp::canTxLock();
+					esp::canUpdateStatus( false );
+					can_initiate_recovery();
+					esp::canUpdateStatus( true );
+					esp::canTxUnlock();
+				}
+				if( alerts & CAN_ALERT_BUS_RECOVERED ) can_start();
+			}
+			// frames may come between alerts reading
+			esp::canReceive();
+			esp::canTxLock();
+			esp::canUpdateStatus( false );
+			esp::canTxUnlock();
+			esp::canTxFlush();
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+	// Bit rate of timing config, bit/s
+	static uint32_t canBitrate(const can_timing_config_t &timing)
+	{
+		return ESP_CAN_CLOCK / ( timing.brp * ( 1 + timing.tseg_1 + timing.tseg_2 ) );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Reinstalls and starts driver, CAN task must be paused
+	static bool canInstall(const can_timing_config_t &t_config, const can_filter_config_t &f_config, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode)
+	{
+		can_stop();
+		can_driver_uninstall();
+
+		can_general_config_t g_config = CAN_GENERAL_CONFIG_DEFAULT( tx_pin, rx_pin, mode );
+		g_config.rx_queue_len = ESP_CAN_DRIVER_QUEUE_LEN;
+		g_config.tx_queue_len = ESP_CAN_DRIVER_QUEUE_LEN;
+		g_config.alerts_enabled = CAN_ALERT_RX_DATA | CAN_ALERT_TX_SUCCESS | CAN_ALERT_TX_IDLE | CAN_ALERT_TX_FAILED | CAN_ALERT_BUS_ERROR | CAN_ALERT_ARB_LOST
+			| CAN_ALERT_RX_QUEUE_FULL | CAN_ALERT_BUS_OFF | CAN_ALERT_BUS_RECOVERED;
+
+		//Install CAN driver
+		if( can_driver_install( &g_config, &t_config, &f_config ) == ESP_OK ){
+			ESP_DEBUG( "ESP: CAN Driver installed\n" );
+		}else{
+			ESP_DEBUG( "ESP: CAN Failed to install driver\n" );
+			return false;
+		}
+
+		//Start CAN driver
+		if( can_start() == ESP_OK ){
+			ESP_DEBUG( "ESP: CAN Driver started\n" );
+		}else{
+			ESP_DEBUG( "ESP: CAN Failed to start driver\n" );
+			return false;
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool CAN_timing(const uint32_t bitrate, const uint16_t samplePoint, can_timing_config_t &timing)
+	{
+		if( bitrate == 0 ) return false;
+
+		uint32_t bestRate = 0xFFFFFFFF;
+		uint32_t bestPoint = 0xFFFFFFFF;
+
+		for( uint32_t brp = 2; brp <= ESP_CAN_BRP_MAX; brp += 2 ){
+			uint32_t tq = ( ESP_CAN_CLOCK / brp + bitrate / 2 ) / bitrate;
+			if( tq < 8 ) break;				// brp only grows
+			if( tq > 25 ) continue;			// 1 + max tseg_1 + max tseg_2
+
+			uint32_t rate = ESP_CAN_CLOCK / ( brp * tq );
+			uint32_t rateError = ( rate > bitrate ) ? rate - bitrate : bitrate - rate;
+			if( (uint64_t)rateError * 1000 > (uint64_t)bitrate * ESP_CAN_BITRATE_TOLERANCE ) continue;
+
+			for( uint32_t tseg2 = 1; tseg2 <= 8; tseg2++ ){
+				uint32_t tseg1 = tq - 1 - tseg2;
+				if( tseg1 < 1 || tseg1 > 16 ) continue;
+
+				uint32_t point = ( 1 + tseg1 ) * 1000 / tq;
+				uint32_t pointError = ( point > samplePoint ) ? point - samplePoint : samplePoint - point;
+				// exact rate first, then sample point, then more time quanta (brp ascending)
+				if( rateError < bestRate || ( rateError == bestRate && pointError < bestPoint ) ){
+					bestRate = rateError;
+					bestPoint = pointError;
+					timing.brp = brp;
+					timing.tseg_1 = tseg1;
+					timing.tseg_2 = tseg2;
+					timing.sjw = ( tseg2 < 3 ) ? tseg2 : 3;
+					timing.triple_sampling = false;
+				}
+			}
+		}
+		return bestRate != 0xFFFFFFFF;
+	}
+
+	//-------------------------------------------------------------------------------
+	void CAN_Init(const can_timing_config_t &timing, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode)
+	{
+		// CAN task must not use driver while it is reinstalled
+		esp::canPause();
+
+		esp::canTiming = timing;
+		esp::canTxPin = tx_pin;
+		esp::canRxPin = rx_pin;
+		esp::canMode = mode;
+		can_speed = ( esp::canBitrate( timing ) + 500 ) / 1000;
+		ESP_DEBUG( "ESP: CAN Initialize at %u, %u pins %ukbit/s mode: %u\n", tx_pin, rx_pin, can_speed, mode );
+
+		can_filter_config_t f_config = esp::canFilterMeasure ? (can_filter_config_t)CAN_FILTER_CONFIG_ACCEPT_ALL() : esp::canFilterConfig;
+		if( !esp::canInstall( timing, f_config, tx_pin, rx_pin, mode ) ) return;
+
+		// driver counters start from 0 after install
+		memset( &esp::canLastStatus, 0, sizeof( can_status_info_t ) );
+		esp::canTxSubmitted = 0;
+		esp::canTxDone = 0;
+
+		// frames of previous configuration are dropped
+		__atomic_store_n( &esp::canRxTail, __atomic_load_n( &esp::canRxHead, __ATOMIC_ACQUIRE ), __ATOMIC_RELEASE );
+		if( esp::canTask == nullptr ){
+			xTaskCreatePinnedToCore( esp::canTaskLoop, "esp_can", ESP_CAN_TASK_STACK, nullptr, ESP_CAN_TASK_PRIORITY, &esp::canTask, ESP_CAN_TASK_CORE );
+		}
+		esp::canIdle = false;
+		esp::canActive = true;
+		// frames queued before init
+		esp::canTxFlush();
+	}
+
+	//-------------------------------------------------------------------------------
+	void CAN_Init(const uint16_t speed, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode)
+	{
+		can_timing_config_t t_config = CAN_TIMING_CONFIG_125KBITS();
+
+		switch( speed ){
+			case 25:	t_config = CAN_TIMING_CONFIG_25KBITS();		break;
+			case 50:	t_config = CAN_TIMING_CONFIG_50KBITS();		break;
+			case 100:	t_config = CAN_TIMING_CONFIG_100KBITS();	break;
+			case 125:	t_config = CAN_TIMING_CONFIG_125KBITS();	break;
+			case 250:	t_config = CAN_TIMING_CONFIG_250KBITS();	break;
+			case 500:	t_config = CAN_TIMING_CONFIG_500KBITS();	break;
+			case 800:	t_config = CAN_TIMING_CONFIG_800KBITS();	break;
+			case 1000:	t_config = CAN_TIMING_CONFIG_1MBITS();		break;
+			default:
+				if( !esp::CAN_timing( (uint32_t)speed * 1000, ESP_CAN_SAMPLE_POINT, t_config ) ){
+					ESP_DEBUG( "ESP: CAN No timing for %ukbit/s, using 125kbit/s\n", speed );
+					t_config = CAN_TIMING_CONFIG_125KBITS();
+				}
+			break;
+		}
+		esp::CAN_Init( t_config, tx_pin, rx_pin, mode );
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t CAN_autobaud(const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode, const uint32_t* rates, uint8_t count)
+	{
+		static const uint32_t defaultRates[] = { 500000, 250000, 125000, 1000000, 800000, 100000, 83333, 50000, 33333, 25000 };
+		if( rates == nullptr || count == 0 ){
+			rates = defaultRates;
+			count = sizeof( defaultRates ) / sizeof( defaultRates[ 0 ] );
+		}
+
+		esp::canPause();
+
+		const can_filter_config_t f_config = CAN_FILTER_CONFIG_ACCEPT_ALL();
+		for( uint8_t i = 0; i < count; i++ ){
+			can_timing_config_t timing;
+			if( !esp::CAN_timing( rates[ i ], ESP_CAN_SAMPLE_POINT, timing ) ) continue;
+			// listen only - wrong rate does not disturb bus with error frames
+			if( !esp::canInstall( timing, f_config, tx_pin, rx_pin, CAN_MODE_LISTEN_ONLY ) ) continue;
+
+			uint8_t frames = 0;
+			bool errors = false;
+			uint32_t start = millis();
+			while( !errors && frames < ESP_CAN_AUTOBAUD_FRAMES && millis() - start < ESP_CAN_AUTOBAUD_TIMEOUT ){
+				can_message_t msg;
+				if( can_receive( &msg, pdMS_TO_TICKS( 10 ) ) == ESP_OK ) frames++;
+
+				can_status_info_t status;
+				if( can_get_status_info( &status ) == ESP_OK ){
+					errors = status.bus_error_count > 0 || status.rx_error_counter > 0;
+				}
+			}
+			ESP_DEBUG( "ESP: CAN autobaud %ubit/s frames: %u errors: %u\n", rates[ i ], frames, errors );
+
+			if( !errors && frames >= ESP_CAN_AUTOBAUD_FRAMES ){
+				esp::CAN_Init( timing, tx_pin, rx_pin, mode );
+				return esp::canBitrate( timing );
+			}
+		}
+
+		can_stop();
+		can_driver_uninstall();
+		return 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool CAN_setFilters(const CanFilter* filters, const uint8_t count, const bool measure)
+	{
+		if( count > ESP_CAN_FILTERS_MAX ) return false;
+
+		bool active = esp::canPause();
+		for( uint8_t i = 0; i < count; i++ ){
+			esp::canFilters[ i ] = filters[ i ];
+			esp::canFilters[ i ].mask &= filters[ i ].extd ? 0x1FFFFFFF : 0x7FF;
+			esp::canFilters[ i ].id &= esp::canFilters[ i ].mask;
+		}
+		esp::canFilterCount = count;
+		esp::canFilterMeasure = measure;
+		esp::canFilterCompute();
+
+		ESP_DEBUG( "ESP: CAN %s filter code: %08X mask: %08X\n", esp::canFilterConfig.single_filter ? "single" : "dual",
+			esp::canFilterConfig.acceptance_code, esp::canFilterConfig.acceptance_mask );
+
+		// hardware filter is set by driver install only
+		if( active ) esp::CAN_Init( esp::canTiming, esp::canTxPin, esp::canRxPin, esp::canMode );
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool CAN_read(can_message_t &msg)
+	{
+		uint32_t tail = __atomic_load_n( &esp::canRxTail, __ATOMIC_RELAXED );
+		if( tail == __atomic_load_n( &esp::canRxHead, __ATOMIC_ACQUIRE ) ) return false;
+
+		msg = esp::canRxRing[ tail & ( ESP_CAN_RX_SLOTS - 1 ) ];
+		__atomic_store_n( &esp::canRxTail, tail + 1, __ATOMIC_RELEASE );
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint16_t CAN_available(void)
+	{
+		return __atomic_load_n( &esp::canRxHead, __ATOMIC_ACQUIRE ) - __atomic_load_n( &esp::canRxTail, __ATOMIC_RELAXED );
+	}
+
+	//-------------------------------------------------------------------------------
+	uint16_t CAN_write(const can_message_t* msgs, const uint16_t count)
+	{
+		uint32_t head = __atomic_load_n( &esp::canTxHead, __ATOMIC_RELAXED );
+		uint32_t free = ESP_CAN_TX_SLOTS - ( head - __atomic_load_n( &esp::canTxTail, __ATOMIC_ACQUIRE ) );
+		uint16_t res = ( count < free ) ? count : free;
+		for( uint16_t i = 0; i < res; i++ ) esp::canTxRing[ ( head + i ) & ( ESP_CAN_TX_SLOTS - 1 ) ] = msgs[ i ];
+		// whole batch is published at once
+		__atomic_store_n( &esp::canTxHead, head + res, __ATOMIC_SEQ_CST );
+		esp::canStats.txOverrun += count - res;
+		// CAN task waits in can_read_alerts, notification does not wake it, frames are submitted at once
+		esp::canTxFlush();
+
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool CAN_write(const can_message_t &msg)
+	{
+		return esp::CAN_write( &msg, 1 ) == 1;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint16_t get_CAN_speed(void)
+	{
+		return can_speed;
+	}
+#endif
+	//-------------------------------------------------------------------------------
+	void printHexData(const uint8_t* data, size_t len)
+	{
+		ESP_DEBUG( "[" );
+		for( size_t i = 0; i < len; i++ ){
+			if( i > 0 ) ESP_DEBUG( " " );
+			ESP_DEBUG( "%02x", data[ i ] );
+		}
+		ESP_DEBUG( "]" );
+	}
+	//-------------------------------------------------------------------------------
+	void wdt_init(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		ESP.wdtEnable( WDT_TIMEOUT );
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_task_wdt_init( WDT_TIMEOUT, true ); //enable panic so ESP32 restarts
+		esp_task_wdt_add( NULL ); //add current thread to WDT watch
+#endif
+	}
+
+	//-------------------------------------------------------------------------------
+	void wdt_reset(void)
+	{
+#if defined(ARDUINO_ARCH_ESP8266)
+		ESP.wdtFeed();
+#elif defined(ARDUINO_ARCH_ESP32)
+		esp_task_wdt_reset();
+#endif
+	}
+
+#if defined(ARDUINO_ARCH_ESP32)
+	//-------------------------------------------------------------------------------
+	void rtc_setDateTime(int sc, int mn, int hr, int dy, int mt, int yr, int ms)
+	{
+		// seconds, minute, hour, day, month, year $ microseconds(optional)
+		// ie setTime(20, 34, 8, 1, 4, 2021) = 8:34:20 1/4/2021
+		struct tm t = {0, 0, 0, 0, 0, 0, 0, 0, 0};      // Initalize to all 0's
+		t.tm_year = yr - 1900;    // This is year-1900, so 121 = 2021
+		t.tm_mon = mt - 1;
+		t.tm_mday = dy;
+		t.tm_hour = hr;
+		t.tm_min = mn;
+		t.tm_sec = sc;
+		time_t timeSinceEpoch = mktime( &t );
+		rtc_set( timeSinceEpoch, ms );
+	}
+
+	//-------------------------------------------------------------------------------
+	void rtc_set(unsigned long epoch, int ms)
+	{
+		struct timeval tv;
+		if (epoch > 2082758399){
+			esp::flags.rtc_overflow = 1;
+			tv.tv_sec = epoch - 2082758399;  // epoch time (seconds)
+		} else {
+			esp::flags.rtc_overflow = 0;
+			tv.tv_sec = epoch;  // epoch time (seconds)
+		}
+		tv.tv_usec = ms;    // microseconds
+		settimeofday( &tv, NULL );
+	}
+
+	//-------------------------------------------------------------------------------
+	struct tm* rtc_getDateTime(void)
+	{
+		struct tm timeinfo;
+		time_t now;
+		time( &now );
+		localtime_r( &now, &timeinfo );
+		time_t tt = mktime( &timeinfo );
+		if( esp::flags.rtc_overflow ){
+			tt += 63071999;
+		}
+		if( esp::rtc_offset > 0){
+			tt += (unsigned int) esp::rtc_offset;
+		} else {
+			tt -= (unsigned int) (esp::rtc_offset * -1);
+		}
+		struct tm* tn = localtime( &tt );
+		if ( esp::flags.rtc_overflow ){
+			tn->tm_year += 64;
+		}
+		return tn;
+	}
+#endif
+	//-------------------------------------------------------------------------------
+	ResponseWriter::ResponseWriter(char* buff, size_t size)
+		: ResponseWriter( nullptr, buff, size )
+	{
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	ResponseWriter::ResponseWriter(ESP8266WebServer *webServer, char* buff, size_t size)
+#elif defined(ARDUINO_ARCH_ESP32)
+	ResponseWriter::ResponseWriter(WebServer *webServer, char* buff, size_t size)
+#endif
+		: webServer( webServer )
+		, buff( ( buff != nullptr && size > 1 ) ? buff : chunk )
+		, size( ( buff != nullptr && size > 1 ) ? size : sizeof( chunk ) )
+		, pos( 0 )
+		, code( 200 )
+		, contentType( "text/html" )
+		, overflow( false )
+		, chunked( false )
+	{
+		this->buff[ 0 ] = '\0';
+	}
+
+	//-------------------------------------------------------------------------------
+	void ResponseWriter::begin(const uint16_t code, const char* contentType)
+	{
+		this->code = code;
+		this->contentType = contentType;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool ResponseWriter::end(void)
+	{
+		if( webServer == nullptr ) return !overflow;
+
+		if( chunked ){
+			flush();
+			webServer->sendContent( "" );
+		}else{
+			webServer->setContentLength( pos );
+			webServer->send( code, contentType, "" );
+			webServer->sendContent( buff, pos );
+		}
+		pos = 0;
+		buff[ 0 ] = '\0';
+
+		return !overflow;
+	}
+
+	//-------------------------------------------------------------------------------
+	ResponseWriter& ResponseWriter::raw(const char* text)
+	{
+		if( text != nullptr ) write( text, strlen( text ) );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	ResponseWriter& ResponseWriter::html(const char* text)
+	{
+		for( const char* p = text; p != nullptr && *p; p++ ){
+			switch( *p ){
+				case '&':	write( "&amp;", 5 );	break;
+				case '<':	write( "&lt;", 4 );		break;
+				case '>':	write( "&gt;", 4 );		break;
+				case '"':	write( "&quot;", 6 );	break;
+				case '\'':	write( "&#39;", 5 );	break;
+				default:	put( *p );				break;
+			}
+		}
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	void ResponseWriter::put(const char c)
+	{
+		if( pos + 1 >= size ){
+			flush();
+			if( pos + 1 >= size ){
+				overflow = true;
+				return;
+			}
+		}
+		buff[ pos++ ] = c;
+		buff[ pos ] = '\0';
+	}
+
+	//-------------------------------------------------------------------------------
+	void ResponseWriter::write(const char* data, size_t len)
+	{
+		while( len > 0 ){
+			if( pos + 1 >= size ){
+				flush();
+				if( pos + 1 >= size ){
+					overflow = true;
+					return;
+				}
+			}
+			size_t part = size - 1 - pos;
+			if( part > len ) part = len;
+			memcpy( buff + pos, data, part );
+			pos += part;
+			data += part;
+			len -= part;
+		}
+		buff[ pos ] = '\0';
+	}
+
+	//-------------------------------------------------------------------------------
+	void ResponseWriter::flush(void)
+	{
+		if( webServer == nullptr || pos == 0 ) return;
+
+		if( !chunked ){
+			webServer->setContentLength( CONTENT_LENGTH_UNKNOWN );
+			webServer->send( code, contentType, "" );
+			chunked = true;
+		}
+		webServer->sendContent( buff, pos );
+		pos = 0;
+		buff[ 0 ] = '\0';
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter::JsonWriter(char* buff, size_t size)
+		: JsonWriter( nullptr, buff, size )
+	{
+	}
+
+	//-------------------------------------------------------------------------------
+#if defined(ARDUINO_ARCH_ESP8266)
+	JsonWriter::JsonWriter(ESP8266WebServer *webServer, char* buff, size_t size)
+#elif defined(ARDUINO_ARCH_ESP32)
+	JsonWriter::JsonWriter(WebServer *webServer, char* buff, size_t size)
+#endif
+		: ResponseWriter( webServer, buff, size )
+		, first( 1 )
+		, depth( 0 )
+		, afterKey( false )
+	{
+		contentType = "application/json";
+	}
+
+	//-------------------------------------------------------------------------------
+	void JsonWriter::begin(const uint16_t code, const char* contentType)
+	{
+		ResponseWriter::begin( code, contentType );
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::beginObject(const char* name)
+	{
+		if( name != nullptr ) key( name );
+		separator();
+		put( '{' );
+		if( depth < 31 ) depth++;
+		first |= ( 1UL << depth );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::endObject(void)
+	{
+		if( depth > 0 ) depth--;
+		put( '}' );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::beginArray(const char* name)
+	{
+		if( name != nullptr ) key( name );
+		separator();
+		put( '[' );
+		if( depth < 31 ) depth++;
+		first |= ( 1UL << depth );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::endArray(void)
+	{
+		if( depth > 0 ) depth--;
+		put( ']' );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::key(const char* name)
+	{
+		str( name );
+		put( ':' );
+		afterKey = true;
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::str(const char* value)
+	{
+		separator();
+		put( '"' );
+		for( const char* p = value; p != nullptr && *p; p++ ){
+			uint8_t c = (uint8_t)*p;
+			if( c == '"' || c == '\\' ){
+				put( '\\' );
+				put( c );
+			}else if( c < 0x20 ){
+				static const char* hex = "0123456789abcdef";
+				write( "\\u00", 4 );
+				put( hex[ c >> 4 ] );
+				put( hex[ c & 0x0F ] );
+			}else{
+				put( c );
+			}
+		}
+		put( '"' );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::num(const int32_t value)
+	{
+		char tmp[ 12 ];
+		separator();
+		ltoa( value, tmp, 10 );
+		return raw( tmp );
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::unum(const uint32_t value)
+	{
+		char tmp[ 11 ];
+		separator();
+		ultoa( value, tmp, 10 );
+		return raw( tmp );
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::boolean(const bool value)
+	{
+		separator();
+		return raw( ( value ) ? "true" : "false" );
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::null(void)
+	{
+		separator();
+		return raw( "null" );
+	}
+
+	//-------------------------------------------------------------------------------
+	JsonWriter& JsonWriter::raw(const char* text)
+	{
+		ResponseWriter::raw( text );
+		return *this;
+	}
+
+	//-------------------------------------------------------------------------------
+	void JsonWriter::separator(void)
+	{
+		if( afterKey ){
+			afterKey = false;
+			return;
+		}
+		if( first & ( 1UL << depth ) ){
+			first &= ~( 1UL << depth );
+		}else{
+			put( ',' );
+		}
+	}
+
+	//-------------------------------------------------------------------------------
+}
@@ -1,451 +1,1263 @@
-#ifndef __ESP_FUNCTIONS_H__
-#define __ESP_FUNCTIONS_H__
-
-
-//-------------------------------------------------------------------------------
-#define ESP_CONFIG_SSID_MAX_LEN					32
-#define ESP_CONFIG_KEY_MAX_LEN					32
-#define ESP_FIRMWARE_FILENAME					"firmware.bin"
-#define ESP_FIRMWARE_FILEPATH					"/firmware.bin"
-#define ESP_CAPTIVE_PORTAL_URL					"/portal"
-#define ESP_AUTOUPDATE_FILENAME					"/autoupdate"
-#define ESP_FIRMWARE_VERSION_FILENAME			"/version"
-#define USER_SETTINGS_FILE						"/settings.dat"
-#define ESP_SYSTEM_CONFIG_FILE					"/config.dat"
-#define SYSTEM_LOGIN							"admin"
-#define SYSTEM_PASSWORD							"admin"
-#define ESP_AUTH_REALM							"Dr.Smyrke TECH"
-#ifndef DEFAULT_UPDATE_KEY
-	#define DEFAULT_UPDATE_KEY					""
-#endif
-#ifndef DEFAULT_AP_KEY
-	#define DEFAULT_AP_KEY						"1234567890"
-#endif
-#ifndef DEFAULT_DEVICE_NAME
-	#define DEFAULT_DEVICE_NAME					"ESP_DEVICE"
-#endif
-#ifndef UPDATE_SIZE_UNKNOWN
-	#define UPDATE_SIZE_UNKNOWN					0xFFFFFFFF
-#endif
-#ifndef FIRMWARE_REVISION
-	#define FIRMWARE_REVISION					0
-#endif
-
-#define PROMISCUOUS_MODE_CHANNEL				7
-#ifndef READ_RAW_PACKETS_BEFORE_START
-	#define READ_RAW_PACKETS_BEFORE_START		100
-#endif
-
-#ifndef WDT_TIMEOUT
-	#if defined(ARDUINO_ARCH_ESP8266)
-		#define WDT_TIMEOUT						WDTO_8S
-	#elif defined(ARDUINO_ARCH_ESP32)
-		#define WDT_TIMEOUT						8
-	#endif
-#endif
-
-//-------------------------------------------------------------------------------
-#include <stdint.h>
-
-#if defined(ARDUINO_ARCH_ESP8266)
-	#include <ESP8266WebServer.h>
-#elif defined(ARDUINO_ARCH_ESP32)
-	#include <WebServer.h>
-	#include <esp_wifi.h>
-	#include <driver/can.h>
-	#include <time.h>
-#endif
-
-//-------------------------------------------------------------------------------
-#ifdef DEBUG_ESP
-	#ifdef DEBUG_ESP_PORT
-		#define ESP_DEBUG(fmt, ...) DEBUG_ESP_PORT.printf_P( (PGM_P)PSTR(fmt), ##__VA_ARGS__ )
-	#endif
-#else
-	#define ESP_DEBUG(...) asm("nop")
-#endif
-
-//-------------------------------------------------------------------------------
-namespace esp {
-	struct Mode{
-		//NOTE: If you change this enum, you must be change options in wifi page! Find ": Wifi mode options" in .cpp file
-		enum{
-			UNKNOWN,
-			STA,
-			AP,
-			NO_WIFI,
-			PROMISCUOUS,
-		};
-	};
-	typedef struct {
-		unsigned char captivePortal: 1;
-		unsigned char captivePortalAccess: 1;
-		unsigned char autoUpdate: 1;
-		unsigned char useFS: 1;
-		unsigned char updateError: 1;
-		unsigned char updateFirmware: 1;
-		unsigned char updateFile: 1;
-		unsigned char rtc_overflow: 1;
-	} Flags;
-	typedef struct {
-		uint8_t mode;
-		char ap_ssid[ ESP_CONFIG_SSID_MAX_LEN ];
-		char ap_key[ ESP_CONFIG_KEY_MAX_LEN ];
-		char sta_ssid[ ESP_CONFIG_SSID_MAX_LEN ];
-		char sta_key[ ESP_CONFIG_KEY_MAX_LEN ];
-	} Data;
-	extern Flags flags;
-	extern int8_t countNetworks;
-	extern const char* pageTop;
-	extern const char* pageEndTop;
-	extern const char* pageBottom;
-	extern char* pageBuff;
-	extern char tmpVal[ 11 ];
-	extern uint8_t firstVersion;
-	extern uint8_t secondVersion;
-	extern uint16_t thridVersion;
-	extern int rtc_offset;									//offest gmt offset in seconds
-	
-	/**
-	 * checking acces from web
-	 * @param {WebServer*} user
-	 * @param {char*} user
-	 * @param {char*} password
-	 * @param {char*} realm
-	 * @param {char*} failMess
-	 * @return {uint8_t} result ( 1 - success, 0 - error )
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	uint8_t checkWebAuth(ESP8266WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess);
-#elif defined(ARDUINO_ARCH_ESP32)
-	uint8_t checkWebAuth(WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess);
-#endif
-	/**
-	 * remove from spi fs
-	 * @param {char*} filepath
-	 * @return none
-	 */
-	void removeFile(const char* file);
-	/**
-	 * set redirect to / from web
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void setWebRedirect(ESP8266WebServer *webServer, const String &target = "");
-#elif defined(ARDUINO_ARCH_ESP32)
-	void setWebRedirect(WebServer *webServer, const String &target = "");
-#endif
-	/**
-	 * checking Connections for AP from STA mode
-	 * @return none
-	 */
-	uint8_t isWiFiConnection(void);
-	/**
-	 * get esp chip ID
-	 * @return {uint32_t} ID or 0 if unknown device
-	 */
-	uint32_t getMyID(void);
-	/**
-	 * initialize wifi subsystem AP or STA
-	 * @param {IPAddress} ip
-	 * @param {IPAddress} gateway
-	 * @param {IPAddress} mask
-	 * @return {bool} true if correct
-	 */
-	bool wifi_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask);
-	/**
-	 * initialize wifi AP
-	 * @param {IPAddress} ip
-	 * @param {IPAddress} gateway
-	 * @param {IPAddress} mask
-	 * @return {bool} true if correct
-	 */
-	bool wifi_AP_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask);
-	/**
-	 * initialize wifi STA
-	 * @return {bool} true if correct
-	 */
-	bool wifi_STA_init(void);
-	/**
-	 * checking acces from web
-	 * @param {WebServer*} pointer
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void setNoCacheContent(ESP8266WebServer *webServer);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void setNoCacheContent(WebServer *webServer);
-#endif
-	/**
-	 * add web server default pages callback
-	 * @param {WebServer*} pointer
-	 * @param {bool} wifi config page (default: true)
-	 * @param {bool} not found page (default: true)
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void addWebServerPages(ESP8266WebServer *webServer, bool wifiConfig = true, bool notFound = true);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void addWebServerPages(WebServer *webServer, bool wifiConfig = true, bool notFound = true);
-#endif
-	/**
-	 * add web server update logic
-	 * @param {WebServer*} pointer
-	 * @param {const char*} key (default: #define DEFAULT_UPDATE_KEY)
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void addWebUpdate(ESP8266WebServer *webServer, const char* key = DEFAULT_UPDATE_KEY);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void addWebUpdate(WebServer *webServer, const char* key = DEFAULT_UPDATE_KEY);
-#endif
-	/**
-	 * Activate web server Captive Portal logic
-	 * @param {WebServer*} pointer
-	 * @param {char*} url redirect to Captive portal page (default: nullptr)
-	 * @param {HandlerFunction} hanler function to Captive portal page (default: nullptr)
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void activateCaptivePortal(ESP8266WebServer *webServer, const char* captiveRedirectTarget = ESP_CAPTIVE_PORTAL_URL, ESP8266WebServer::THandlerFunction cp_handler = nullptr);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void activateCaptivePortal(WebServer *webServer, const char* captiveRedirectTarget = ESP_CAPTIVE_PORTAL_URL, WebServer::THandlerFunction cp_handler = nullptr);
-#endif
-	/**
-	 * web config page
-	 * @param {WebServer*} pointer
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void handleWebConfigPage(ESP8266WebServer *webServer);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void handleWebConfigPage(WebServer *webServer);
-#endif
-	/**
-	 * web not found page
-	 * @param {WebServer*} pointer
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void handleWeb404Page(ESP8266WebServer *webServer);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void handleWeb404Page(WebServer *webServer);
-#endif
-	/**
-	 * web send file to client or generate 404 error if file not found
-	 * @param {WebServer*} pointer
-	 * @param {char*} fileName
-	 * @param {char*} mimeType
-	 * @return none
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	uint8_t webSendFile(ESP8266WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code = 200);
-#elif defined(ARDUINO_ARCH_ESP32)
-	uint8_t webSendFile(WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code = 200);
-#endif
-	/**
-	 * Checking for updates 
-	 * @param {char*} repository url (http://example.com/folder)
-	 * @param {uint16_t} number of version
-	 * @return {uint32_t} available version number
-	 */
-	uint32_t checkingUpdate(const char *repoURL, const uint16_t version);
-	/**
-	 * Download new files
-	 * @param {char*} repository url (http://example.com/folder)
-	 * @param {char*} file (/firmware.bin)
-	 * @return {uint8_t} 0 if error, 1 if success
-	 */
-	uint8_t downloadUpdate(const char *repoURL, const char *file);
-	/**
-	 * Update firmware from FS
-	 * @return {uint8_t} 0 if error, 1 if success
-	 */
-	uint8_t updateFromFS(void);
-	/**
-	 * Checking file in memory 
-	 * @param {char*} file path
-	 * @return {bool} available version number
-	 */
-	bool isFileExists(const char *filepath);
-	/**
-	 * Printing all files in memory
-	 * @param {HardwareSerial} Serial object
-	 * @return {none}
-	 */
-	void printAllFiles(HardwareSerial &SerialPort);
-	/**
-	 * Initialize for library methods
-	 * @param {char*} name - Device Name
-	 * @param {boolean} useFS (default: true)
-	 * @return {none}
-	 */
-	void init(const char* deviceName = DEFAULT_DEVICE_NAME, bool useFS = true);
-	/**
-	 * Change MAC (!!! use after Connection initialize)
-	 * @return {none}
-	 */
-	void changeMAC(const uint8_t *mac);
-	/**
-	 * HTTP Put request
-	 * @param {String &} URL
-	 * @param {String &} playload
-	 * @param {String &} response
-	 * @return {int} http response code
-	 */
-	int http_put(const String &url, const String &playload, String &response);
-	/**
-	 * Save settings at file from SPI FS
-	 * @param {const uint8_t*} data buffer (default: nullptr)
-	 * @param {uint32_t} length data (default: 0)
-	 * @param {const char*} settingsFile - filepath (default: USER_SETTINGS_FILE)
-	 * @return {none}
-	 */
-	void saveSettings(const uint8_t* data = nullptr, uint32_t length = 0, const char* settingsFile = USER_SETTINGS_FILE);
-	/**
-	 * Read settings at file from SPI FS
-	 * @param {uint8_t*} data buffer (default: nullptr)
-	 * @param {uint32_t} length data (default: 0)
-	 * @param {const char*} settingsFile - filepath (default: USER_SETTINGS_FILE)
-	 * @return {uint32_t} reading length
-	 */
-	uint32_t loadSettings(uint8_t* data = nullptr, uint32_t size = 0, const char* settingsFile = USER_SETTINGS_FILE);
-	/**
-	 * Set system user and password
-	 * @param {const char*} login (default: nullptr)
-	 * @param {const char*} password (default: nullptr)
-	 * @return {none}
-	 */
-	void changeSystemUserPassword(const char* login = nullptr, const char* password = nullptr);
-	/**
-	 * Update process function
-	 * @return {none}
-	 */
-#if defined(ARDUINO_ARCH_ESP8266)
-	void updateProcess(ESP8266WebServer *webServer);
-#elif defined(ARDUINO_ARCH_ESP32)
-	void updateProcess(WebServer *webServer);
-#endif
-	/**
-	 * Set application version
-	 * @param {const uint8_t} first version <FIRST>.1.256
-	 * @param {const uint8_t} second version 0.<SECOND>.256
-	 * @param {const uint16_t} thrid version 0.1.<THRID>
-	 * @return {none}
-	 */
-	void setVersion(const uint8_t first = 0, const uint8_t second = 1, const uint16_t thrid = 0);
-	/**
-	 * Get mode value
-	 * @return {uint8_t} esp::Mode enum
-	 */
-	uint8_t getMode(void);
-	/**
-	 * Set mode value
-	 * @param {const uint8_t} value must be lower at esp::Mode enum
-	 * @return none
-	 */
-	void setMode(const uint8_t value);
-	/**
-	 * Save system settings (internal method don`t use this method!!!)
-	 * @return {none}
-	 */
-	void saveSystemSettings(void);
-	/**
-	 * Get reset reason
-	 * @return {uint32_t}
-	 */
-	uint32_t getResetReason(void);
-	/**
-	 * Enable Promisc mode method
-	 * @param {Callback function} (default: nullptr)
-	 * @return none
-	*/
-	void enablePromiscMode(wifi_promiscuous_cb_t func = nullptr);
-	/**
-	 * Disable Promisc mode method
-	 * @return none
-	*/
-	void disablePromiscMode(void);
-	/**
-	 * Callback to recieve RAW data
-	 * @return none
-	 */
-	void promisc_rx_cb(uint8_t *buf, uint16_t len);
-	
-#if defined(ARDUINO_ARCH_ESP8266)
-
-#elif defined(ARDUINO_ARCH_ESP32)
-	/**
-	 * Initialize CAN module
-	 * @param {uint16_t} CAN Speed
-	 * @param {gpio_num_t} tx pin
-	 * @param {gpio_num_t} rx pin
-	 * @param {can_mode_t} mode (default: CAN_MODE_NORMAL)
-	 * @return none
-	 */
-	void CAN_Init(const uint16_t speed, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode = CAN_MODE_NORMAL);
-	/**
-	 * Getter for CAN speed value
-	 * @return {uint16_t} speed value
-	 */
-	uint16_t get_CAN_speed(void);
-#endif
-	/**
-	 * Print data at HEX format
-	 * @return {const uint8_t*} data pointer
-	 * @return {size_t} data length
-	 * @return none
-	*/
-	void printHexData(const uint8_t* data, size_t len);
-	/**
-	 * Initialize WDT
-	 * @return none
-	*/
-	void wdt_init(void);
-	/**
-	 * Reset WDT
-	 * @return none
-	*/
-	void wdt_reset(void);
-#if defined(ARDUINO_ARCH_ESP32)
-	/**
-	 * @brief Set RTC Date Time
-	 * @param  sc
-            second (0-59)
-    	@param  mn
-            minute (0-59)
-    	@param  hr
-            hour of day (0-23)
-    	@param  dy
-            day of month (1-31)
-	    @param  mt
-            month (1-12)
-    	@param  yr
-            year ie 2021
-    	@param  ms
-            microseconds (optional)
-	 * @return none
-	*/
-	void rtc_setDateTime(int sc, int mn, int hr, int dy, int mt, int yr, int ms = 0);
-	/**
-    	@brief  set the internal RTC time
-    	@param  epoch
-            epoch time in seconds
-    	@param  ms
-            microseconds (optional)
-	**/
-	void rtc_set(unsigned long epoch = 1609459200, int ms = 0);	// default (1609459200) = 1st Jan 2021
-	/**
-		@brief  get the internal RTC time as a tm struct
-		@return none
-	**/
-	struct tm* rtc_getDateTime(void);
-#endif
-}
-/*!
-    @brief  set the internal RTC time
-    
-*/
-//-------------------------------------------------------------------------------
-
-#endif /* __ESP_FUNCTIONS_H__ */
+#ifndef __ESP_FUNCTIONS_H__
+#define __ESP_FUNCTIONS_H__
+
+
+//-------------------------------------------------------------------------------
+#define ESP_CONFIG_SSID_MAX_LEN					32
+#define ESP_CONFIG_KEY_MAX_LEN					32
+#define ESP_FIRMWARE_FILENAME					"firmware.bin"
+#define ESP_FIRMWARE_FILEPATH					"/firmware.bin"
+#define ESP_FIRMWARE_MD5_FILENAME				"/firmware.md5"
+#define ESP_FIRMWARE_PATCH_FILENAME				"/firmware.patch"
+#define ESP_FIRMWARE_MANIFEST_FILEPATH			"/firmware.manifest"
+#define ESP_PATCH_MAGIC							"ESPDIFF1"
+#define ESP_CAPTIVE_PORTAL_URL					"/portal"
+#define ESP_AUTOUPDATE_FILENAME					"/autoupdate"
+#define ESP_FIRMWARE_VERSION_FILENAME			"/version"
+#define USER_SETTINGS_FILE						"/settings.dat"
+#define ESP_SYSTEM_CONFIG_FILE					"/config.dat"
+#define ESP_SETTINGS_SLOT_SUFFIX				".1"			// record slots of previous library versions, read only
+#define ESP_SETTINGS_MAGIC						0x53505345		// "ESPS"
+#define ESP_SETTINGS_SCHEMA						1
+#define ESP_KV_FILE								"/kv.log"
+#define ESP_DOUBLE_RESET_FILE					"/drd"
+#define ESP_KV_COMPACT_SUFFIX					".tmp"
+#define ESP_KV_EMPTY							0xFFFFFFFF
+#define ESP_KV_DELETED							0x01
+#ifndef ESP_KV_KEY_MAX_LEN
+	#define ESP_KV_KEY_MAX_LEN					32
+#endif
+#ifndef ESP_KV_INDEX_SIZE
+	#define ESP_KV_INDEX_SIZE					64			// max keys, must be power of 2
+#endif
+#ifndef ESP_KV_COMPACT_SIZE
+	#define ESP_KV_COMPACT_SIZE					8192		// log size to start compaction (if half is garbage)
+#endif
+#ifndef ESP_SETTINGS_FLUSH_DELAY
+	#define ESP_SETTINGS_FLUSH_DELAY			0			// ms, > 0 - system settings are written from esp::handle()
+#endif
+#define SYSTEM_LOGIN							"admin"
+#define SYSTEM_PASSWORD							"admin"
+#define ESP_AUTH_REALM							"Dr.Smyrke TECH"
+#define ESP_AUTH_COOKIE_NAME					"ESPSID"
+#ifndef ESP_AUTH_SESSIONS
+	#define ESP_AUTH_SESSIONS					4
+#endif
+#ifndef ESP_AUTH_SESSION_TIMEOUT
+	#define ESP_AUTH_SESSION_TIMEOUT			600			// seconds
+#endif
+#ifndef ESP_AUTH_BACKOFF_CLIENTS
+	#define ESP_AUTH_BACKOFF_CLIENTS			8
+#endif
+#ifndef ESP_AUTH_FREE_ATTEMPTS
+	#define ESP_AUTH_FREE_ATTEMPTS				3
+#endif
+#ifndef ESP_AUTH_BACKOFF_MAX
+	#define ESP_AUTH_BACKOFF_MAX				60000		// ms
+#endif
+#ifndef DEFAULT_UPDATE_KEY
+	#define DEFAULT_UPDATE_KEY					""
+#endif
+#ifndef DEFAULT_AP_KEY
+	#define DEFAULT_AP_KEY						"1234567890"
+#endif
+#ifndef DEFAULT_DEVICE_NAME
+	#define DEFAULT_DEVICE_NAME					"ESP_DEVICE"
+#endif
+#ifndef UPDATE_SIZE_UNKNOWN
+	#define UPDATE_SIZE_UNKNOWN					0xFFFFFFFF
+#endif
+#ifndef FIRMWARE_REVISION
+	#define FIRMWARE_REVISION					0
+#endif
+
+#ifndef ESP_STA_ASYNC
+	#define ESP_STA_ASYNC						1			// 0 - wifi_STA_init waits up to ESP_STA_BLOCKING_TIMEOUT, then SDK reconnects
+#endif
+#ifndef ESP_STA_BLOCKING_TIMEOUT
+	#define ESP_STA_BLOCKING_TIMEOUT			5000		// ms, wait of wifi_STA_init with ESP_STA_ASYNC 0
+#endif
+#ifndef ESP_STA_CONNECT_TIMEOUT
+	#define ESP_STA_CONNECT_TIMEOUT				10000		// ms, one connection attempt
+#endif
+#ifndef ESP_STA_BACKOFF_MIN
+	#define ESP_STA_BACKOFF_MIN					1000		// ms, doubled on every failed attempt
+#endif
+#ifndef ESP_STA_BACKOFF_MAX
+	#define ESP_STA_BACKOFF_MAX					60000		// ms
+#endif
+#ifndef ESP_STA_MAX_ATTEMPTS
+	#define ESP_STA_MAX_ATTEMPTS				5			// failed attempts before FAILED state
+#endif
+#ifndef ESP_STA_AP_FALLBACK
+	#define ESP_STA_AP_FALLBACK					0			// 1 - start AP (AP+STA) at FAILED state
+#endif
+#ifndef ESP_STA_NETWORKS
+	#define ESP_STA_NETWORKS					4			// STA credentials (sta_ssid + ESP_STA_NETWORKS - 1 in sta_extra), min 2
+#endif
+#ifndef ESP_STA_SCAN_MAX_AGE
+	#define ESP_STA_SCAN_MAX_AGE				30000		// ms, older scan results are refreshed before network selection
+#endif
+#ifndef ESP_STA_SUCCESS_BONUS
+	#define ESP_STA_SUCCESS_BONUS				3			// dB added to RSSI per successful connection (minus per failed)
+#endif
+#ifndef ESP_STA_SCORE_MAX
+	#define ESP_STA_SCORE_MAX					5
+#endif
+#ifndef ESP_STA_ROAM_RSSI
+	#define ESP_STA_ROAM_RSSI					-75			// dBm, weaker signal starts roaming scan (0 - no roaming)
+#endif
+#ifndef ESP_STA_ROAM_HYSTERESIS
+	#define ESP_STA_ROAM_HYSTERESIS				8			// dB, new AP must be stronger by this value
+#endif
+#ifndef ESP_STA_ROAM_CHECK_INTERVAL
+	#define ESP_STA_ROAM_CHECK_INTERVAL			10000		// ms
+#endif
+#ifndef ESP_STA_ROAM_INTERVAL
+	#define ESP_STA_ROAM_INTERVAL				60000		// ms, min time between roaming scans
+#endif
+#ifndef ESP_WIFI_SCAN_MAX
+	#define ESP_WIFI_SCAN_MAX					16			// cached scan results, strongest are kept
+#endif
+
+#ifndef ESP_WEB_PATH_MAX_LEN
+	#define ESP_WEB_PATH_MAX_LEN				64
+#endif
+#ifndef ESP_WEB_CACHE_SIZE
+	#define ESP_WEB_CACHE_SIZE					0			// static files RAM cache budget in bytes (0 - disabled)
+#endif
+#ifndef ESP_WEB_CACHE_SLOTS
+	#define ESP_WEB_CACHE_SLOTS					8
+#endif
+#define ESP_DOWNLOAD_PART_SUFFIX				".part"
+#define ESP_DOWNLOAD_VALIDATOR_SUFFIX			".tag"		// ETag or Last-Modified of <file>.part
+#define ESP_DOWNLOAD_VALIDATOR_MAX_LEN			64
+#ifndef ESP_DOWNLOAD_RETRIES
+	#define ESP_DOWNLOAD_RETRIES				3
+#endif
+#ifndef ESP_DOWNLOAD_BUFFER_SIZE
+	#define ESP_DOWNLOAD_BUFFER_SIZE			4096		// flash sector size
+#endif
+#ifndef ESP_DOWNLOAD_TIMEOUT
+	#define ESP_DOWNLOAD_TIMEOUT				10000		// ms without data
+#endif
+#ifndef ESP_DOWNLOAD_PROGRESS_INTERVAL
+	#define ESP_DOWNLOAD_PROGRESS_INTERVAL		250			// ms
+#endif
+#ifndef ESP_DOWNLOAD_BACKOFF
+	#define ESP_DOWNLOAD_BACKOFF				1000		// ms after failed download, doubled after every next one
+#endif
+#ifndef ESP_DOWNLOAD_BACKOFF_MAX
+	#define ESP_DOWNLOAD_BACKOFF_MAX			60000		// ms
+#endif
+#ifndef ESP_UPDATE_MANIFEST_MAX_LEN
+	#define ESP_UPDATE_MANIFEST_MAX_LEN			320
+#endif
+// #define ESP_UPDATE_PUBLIC_KEY				"<64 hex chars>"	// Ed25519 key, manifest signature is required if defined (ESP32 only)
+#ifndef ESP_JSON_CHUNK_SIZE
+	#define ESP_JSON_CHUNK_SIZE					256
+#endif
+
+#define PROMISCUOUS_MODE_CHANNEL				7
+#ifndef ESP_PROMISC_SLOTS
+	#define ESP_PROMISC_SLOTS					16			// frames in ring, must be power of 2
+#endif
+#ifndef ESP_PROMISC_SLOT_SIZE
+	#define ESP_PROMISC_SLOT_SIZE				128			// bytes per frame, longer frames are truncated
+#endif
+// frame types, same bits as WIFI_PROMIS_FILTER_MASK_* of ESP32
+#define ESP_PROMISC_FILTER_MGMT					0x01
+#define ESP_PROMISC_FILTER_CTRL					0x02
+#define ESP_PROMISC_FILTER_DATA					0x04
+#define ESP_PROMISC_FILTER_MISC					0x08
+#ifndef ESP_PROMISC_FILTER
+	#define ESP_PROMISC_FILTER					( ESP_PROMISC_FILTER_MGMT | ESP_PROMISC_FILTER_DATA )
+#endif
+#define ESP_HOP_CHANNELS_MAX					14
+#ifndef ESP_HOP_CHANNELS
+	#define ESP_HOP_CHANNELS					0x3FFE		// bit per channel, 1-13
+#endif
+#ifndef ESP_HOP_DWELL_MIN
+	#define ESP_HOP_DWELL_MIN					100			// ms, quiet channel
+#endif
+#ifndef ESP_HOP_DWELL_MAX
+	#define ESP_HOP_DWELL_MAX					1000		// ms, busiest channel of set
+#endif
+#define ESP_FRAME_TYPE_MGMT						0
+#define ESP_FRAME_TYPE_CTRL						1
+#define ESP_FRAME_TYPE_DATA						2
+#define ESP_FRAME_SUBTYPE_PROBE_REQ				4
+#define ESP_FRAME_SUBTYPE_BEACON				8
+#define ESP_FRAME_SUBTYPE_ACTION				13
+#ifndef ESP_MAC_TABLE_SIZE
+	#define ESP_MAC_TABLE_SIZE					64			// per-MAC stats, must be power of 2
+#endif
+#ifndef ESP_MAC_MAX_AGE
+	#define ESP_MAC_MAX_AGE						300000		// ms without frames to remove MAC
+#endif
+#ifndef ESP_MAC_AGE_INTERVAL
+	#define ESP_MAC_AGE_INTERVAL				10000		// ms
+#endif
+#ifndef ESP_MAC_PROBE_SSIDS
+	#define ESP_MAC_PROBE_SSIDS					4			// distinct probed SSIDs kept per MAC
+#endif
+#define ESP_MAC_EXPORT_RECORD_SIZE				21
+/**
+ * Raw-packet provisioning in configuration window after reset (see esp::init), enabled by ESP_PROVISION_KEY.
+ * Window is opened by external reset at ESP8266, by double EN reset (ESP_DOUBLE_RESET_TIMEOUT) at ESP32.
+ * Payload is in vendor action frame (category 127) or vendor element (221) of beacon / probe request,
+ * both start with ESP_PROV_OUI (3 bytes) and ESP_PROV_TYPE, then:
+ * session (uint32 LE), index, count (<= 16), total length, chunk length, chunk (ESP_PROV_CHUNK_SIZE, last may be shorter)
+ * Message: flags (0), counter (uint32 LE), chip id (uint32 LE, 0 - any device), ssid length, ssid,
+ * key length, key XOR HMAC-SHA256( encKey, counter + chip id ),
+ * first ESP_PROV_MAC_LEN bytes of HMAC-SHA256( macKey, message before HMAC )
+ * encKey = HMAC-SHA256( ESP_PROVISION_KEY, "enc" ), macKey = HMAC-SHA256( ESP_PROVISION_KEY, "mac" ).
+ * Counter must be above last accepted one (kept in KV store as ESP_PROV_COUNTER_KEY), so sender
+ * increments it for every message and captured message can not be replayed
+ */
+// #define ESP_PROVISION_KEY					"<pre-shared key>"
+#define ESP_PROV_OUI							0x18FE34	// Espressif
+#define ESP_PROV_TYPE							0x50
+#define ESP_PROV_CHUNK_SIZE						32
+#define ESP_PROV_MAX_LEN						128
+#define ESP_PROV_MAC_LEN						16
+#define ESP_PROV_COUNTER_KEY					"prov_counter"
+#ifndef ESP_PROV_TIMEOUT
+	#define ESP_PROV_TIMEOUT					5000		// ms without chunks to drop message
+#endif
+#ifndef ESP_CAN_RX_SLOTS
+	#define ESP_CAN_RX_SLOTS					64			// must be power of 2
+#endif
+#ifndef ESP_CAN_TX_SLOTS
+	#define ESP_CAN_TX_SLOTS					32			// must be power of 2
+#endif
+#ifndef ESP_CAN_DRIVER_QUEUE_LEN
+	#define ESP_CAN_DRIVER_QUEUE_LEN			16
+#endif
+#ifndef ESP_CAN_CLOCK
+	#define ESP_CAN_CLOCK						80000000	// APB clock, Hz
+#endif
+#ifndef ESP_CAN_BRP_MAX
+	#define ESP_CAN_BRP_MAX						128
+#endif
+#ifndef ESP_CAN_SAMPLE_POINT
+	#define ESP_CAN_SAMPLE_POINT				800			// 0.1%, for rates without predefined timing
+#endif
+#ifndef ESP_CAN_BITRATE_TOLERANCE
+	#define ESP_CAN_BITRATE_TOLERANCE			5			// 0.1%
+#endif
+#ifndef ESP_CAN_AUTOBAUD_TIMEOUT
+	#define ESP_CAN_AUTOBAUD_TIMEOUT			500			// ms, listen time for each rate
+#endif
+#ifndef ESP_CAN_AUTOBAUD_FRAMES
+	#define ESP_CAN_AUTOBAUD_FRAMES				2			// error free frames to accept rate
+#endif
+#ifndef ESP_CAN_FILTERS_MAX
+	#define ESP_CAN_FILTERS_MAX					12			// every split to dual filter is checked, 2^n
+#endif
+#ifndef ESP_CAN_TASK_PERIOD
+	#define ESP_CAN_TASK_PERIOD					100			// ms, max wait for driver alerts, delay of esp::CAN_Init / CAN_setFilters
+#endif
+#ifndef ESP_CAN_TASK_STACK
+	#define ESP_CAN_TASK_STACK					3072
+#endif
+#ifndef ESP_CAN_TASK_PRIORITY
+	#define ESP_CAN_TASK_PRIORITY				10
+#endif
+#ifndef ESP_CAN_TASK_CORE
+	#define ESP_CAN_TASK_CORE					1
+#endif
+#ifndef ESP_DOUBLE_RESET_TIMEOUT
+	#define ESP_DOUBLE_RESET_TIMEOUT			3000		// ms, second EN reset opens raw configuration window (ESP32)
+#endif
+#ifndef READ_RAW_PACKETS_BEFORE_START
+	#define READ_RAW_PACKETS_BEFORE_START		100
+#endif
+
+#ifndef WDT_TIMEOUT
+	#if defined(ARDUINO_ARCH_ESP8266)
+		#define WDT_TIMEOUT						WDTO_8S
+	#elif defined(ARDUINO_ARCH_ESP32)
+		#define WDT_TIMEOUT						8
+	#endif
+#endif
+
+//-------------------------------------------------------------------------------
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+	#include <ESP8266WebServer.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+	#include <WebServer.h>
+	#include <esp_wifi.h>
+	#include <driver/can.h>
+	#include <time.h>
+#endif
+
+//-------------------------------------------------------------------------------
+#ifdef DEBUG_ESP
+	#ifdef DEBUG_ESP_PORT
+		#define ESP_DEBUG(fmt, ...) DEBUG_ESP_PORT.printf_P( (PGM_P)PSTR(fmt), ##__VA_ARGS__ )
+	#endif
+#else
+	#define ESP_DEBUG(...) asm("nop")
+#endif
+
+//-------------------------------------------------------------------------------
+namespace esp {
+	struct Mode{
+		//NOTE: If you change this enum, you must be change options in wifi page! Find ": Wifi mode options" in .cpp file
+		enum{
+			UNKNOWN,
+			STA,
+			AP,
+			NO_WIFI,
+			PROMISCUOUS,
+		};
+	};
+	struct StaState{
+		enum{
+			IDLE,
+			CONNECTING,
+			CONNECTED,
+			BACKOFF,
+			FAILED,
+			SCANNING,
+		};
+	};
+	typedef struct {
+		unsigned char captivePortal: 1;
+		unsigned char captivePortalAccess: 1;
+		unsigned char autoUpdate: 1;
+		unsigned char useFS: 1;
+		unsigned char updateError: 1;
+		unsigned char updateFirmware: 1;
+		unsigned char updateFile: 1;
+		unsigned char rtc_overflow: 1;
+	} Flags;
+	typedef struct {
+		char ssid[ ESP_CONFIG_SSID_MAX_LEN ];
+		char key[ ESP_CONFIG_KEY_MAX_LEN ];
+	} StaNetwork;
+	typedef struct {
+		uint8_t mode;
+		char ap_ssid[ ESP_CONFIG_SSID_MAX_LEN ];
+		char ap_key[ ESP_CONFIG_KEY_MAX_LEN ];
+		char sta_ssid[ ESP_CONFIG_SSID_MAX_LEN ];
+		char sta_key[ ESP_CONFIG_KEY_MAX_LEN ];
+		// last successful STA connection for fast reconnect (sta_channel = 0 - unknown)
+		uint8_t sta_bssid[ 6 ];
+		uint8_t sta_channel;
+		uint32_t sta_ip;						// DHCP lease reused as static IP (ESP32 only)
+		uint32_t sta_gateway;
+		uint32_t sta_mask;
+		uint32_t sta_dns;
+		StaNetwork sta_extra[ ESP_STA_NETWORKS - 1 ];	// additional networks, selected by RSSI (empty ssid - not used)
+		uint8_t sta_net;						// network of cached BSSID/channel, 0 - sta_ssid, 1.. - sta_extra
+	} Data;
+	typedef struct {
+		uint32_t accepted;
+		uint32_t rejected;
+		uint32_t throttled;
+		uint32_t sessionHits;
+	} AuthStats;
+	typedef struct {
+		uint8_t state;							// StaState
+		uint8_t attempts;						// failed attempts since last connection
+		uint32_t stateTime;						// millis() of last state change
+		uint32_t connectStart;					// millis() of first attempt
+		uint32_t connectTime;					// ms, last time-to-connect (with retries)
+		uint32_t assocTime;						// ms, last successful attempt from WiFi.begin()
+		uint8_t fastConnect;					// last attempt used cached BSSID/channel
+		uint8_t network;						// current network, 0 - sta_ssid, 1.. - sta_extra
+		uint32_t roams;
+		uint32_t bootConnectTime;				// millis() of first connection after boot
+		uint32_t connects;
+		uint32_t disconnects;
+	} StaStatus;
+	typedef struct {
+		char ssid[ ESP_CONFIG_SSID_MAX_LEN + 1 ];
+		int8_t rssi;
+		uint8_t channel;
+		uint8_t auth;							// encryptionType() of platform
+		uint8_t bssid[ 6 ];
+	} ScanResult;
+	typedef struct {
+		uint16_t len;							// received length
+		uint16_t size;							// stored length (<= ESP_PROMISC_SLOT_SIZE)
+		uint32_t time;							// millis()
+		uint8_t data[ ESP_PROMISC_SLOT_SIZE ];	// buffer as passed to promiscuous callback (ESP8266 - RxControl + frame, ESP32 - rx_ctrl + frame)
+	} PromiscFrame;
+	typedef struct {
+		uint32_t captured;						// frames stored to ring
+		uint32_t dropped;						// frames lost, ring is full
+		uint32_t overrun;						// frames longer than slot, stored truncated
+		uint32_t filtered;						// frames skipped by type filter (ESP8266, ESP32 filters by hardware)
+	} PromiscStats;
+	typedef struct {
+		uint32_t frames;
+		uint32_t visits;
+		uint32_t time;							// ms spent on channel
+		uint32_t rate;							// frames/sec, average of last visits
+		uint32_t dwell;							// ms, dwell of last visit
+	} HopChannelStats;
+	typedef struct {
+		uint8_t channel;						// current promiscuous channel
+		uint16_t channels;						// hopping set, 0 - hopping is off
+		uint32_t hops;
+		uint32_t latency;						// us, last channel switch
+		uint32_t latencyMax;					// us
+	} HopStatus;
+	/**
+	 * Parsed 802.11 frame, pointers are to PromiscFrame data (nullptr if frame is too short)
+	 */
+	typedef struct {
+		uint16_t frameControl;
+		uint8_t type;							// ESP_FRAME_TYPE_*
+		uint8_t subtype;
+		int8_t rssi;
+		uint8_t channel;
+		uint16_t sequence;
+		const uint8_t* addr1;					// receiver
+		const uint8_t* addr2;					// transmitter
+		const uint8_t* addr3;
+		const uint8_t* body;					// after header, may be truncated
+		uint16_t bodyLen;
+	} WifiFrame;
+	typedef struct {
+		uint8_t mac[ 6 ];
+		uint8_t channel;						// last frame
+		uint8_t probeCount;						// distinct probed SSIDs
+		uint16_t sequence;						// last frame
+		uint32_t firstSeen;						// millis()
+		uint32_t lastSeen;						// millis()
+		uint32_t packets;
+		int32_t rssiSum;						// mean = rssiSum / packets
+		uint32_t probes[ ESP_MAC_PROBE_SSIDS ];	// crc32 of probed SSIDs
+		char ssid[ 33 ];						// last probed SSID
+	} MacStats;
+	typedef struct {
+		uint32_t frames;
+		uint16_t entries;
+		uint32_t evictions;						// removed to free slot
+		uint32_t expired;						// removed by ESP_MAC_MAX_AGE
+	} MacTableStats;
+	typedef struct {
+		uint32_t chunks;
+		uint32_t rejected;						// bad chunks and messages
+		uint32_t replayed;						// authentic messages with old counter (also rejected)
+		uint32_t done;
+	} ProvisionStats;
+	typedef struct {
+		uint32_t rx;							// frames stored to rx ring
+		uint32_t tx;							// frames sent
+		uint32_t txFailed;						// incl. frames dropped by bus-off recovery
+		uint32_t busErrors;
+		uint32_t arbLost;
+		uint32_t busOff;
+		uint32_t rxOverrun;						// frames lost, rx ring is full
+		uint32_t driverOverrun;					// frames lost, driver rx queue was full
+		uint32_t txOverrun;						// frames not accepted by CAN_write, tx ring is full
+		uint32_t hwRejected;					// counted only in measure mode of esp::CAN_setFilters
+		uint32_t swRejected;					// passed by hardware filter, not by any of filters
+	} CanStats;
+	typedef struct {
+		uint32_t id;
+		uint32_t mask;							// bit 1 - must match id
+		bool extd;								// 29 bit ID
+	} CanFilter;
+	/**
+	 * Promiscuous frame callback for esp::promiscDrain
+	 * @param {PromiscFrame} frame, valid only while callback runs
+	 */
+	typedef void (*PromiscFrameCallback)(const PromiscFrame &frame);
+	typedef struct {
+		uint32_t puts;
+		uint32_t bytesWritten;
+		uint32_t compactions;
+		uint32_t dropped;						// records not indexed by last kvInit (index is full)
+	} KvStats;
+	typedef struct {
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t evictions;
+		uint32_t used;
+	} WebCacheStats;
+	/**
+	 * Update manifest (/version file at repository), lines "key=value":
+	 * version=<number>
+	 * size=<image bytes>			(optional)
+	 * sha256=<64 hex chars>			(optional, required with ESP_UPDATE_PUBLIC_KEY)
+	 * base=<version for delta update>	(optional)
+	 * sig=<128 hex chars>			Ed25519 of all bytes before this line (last line, required with ESP_UPDATE_PUBLIC_KEY)
+	 * Legacy file with only version number is accepted without ESP_UPDATE_PUBLIC_KEY
+	 */
+	typedef struct {
+		uint32_t version;
+		uint32_t size;
+		uint32_t base;
+		uint8_t sha256[ 32 ];
+		uint8_t valid: 1;
+		uint8_t hasSha256: 1;
+		uint8_t hasBase: 1;
+	} UpdateManifest;
+	/**
+	 * Download progress callback
+	 * @param {uint32_t} downloaded bytes
+	 * @param {int32_t} total bytes (-1 if unknown)
+	 * @param {uint32_t} speed bytes/sec
+	 */
+	typedef void (*DownloadProgressCallback)(uint32_t done, int32_t total, uint32_t speed);
+	extern Flags flags;
+	extern AuthStats authStats;
+	extern WebCacheStats webCacheStats;
+	extern UpdateManifest updateManifest;					// last manifest read by checkingUpdate
+	extern KvStats kvStats;
+	extern StaStatus staStatus;
+	extern PromiscStats promiscStats;
+	extern HopStatus hopStatus;
+	extern HopChannelStats hopChannelStats[ ESP_HOP_CHANNELS_MAX ];	// index - channel - 1
+	extern MacTableStats macTableStats;
+	extern ProvisionStats provisionStats;
+#if defined(ARDUINO_ARCH_ESP32)
+	extern CanStats canStats;
+#endif
+	extern int8_t countNetworks;				// networks found by last scan
+	extern ScanResult scanResults[ ESP_WIFI_SCAN_MAX ];
+	extern uint8_t scanCount;
+	extern uint32_t scanTime;				// millis() of last scan result, 0 - no results
+	extern const char* pageTop;
+	extern const char* pageEndTop;
+	extern const char* pageBottom;
+	extern char* pageBuff;
+	extern char tmpVal[ 11 ];
+	extern uint8_t firstVersion;
+	extern uint8_t secondVersion;
+	extern uint16_t thridVersion;
+	extern int rtc_offset;									//offest gmt offset in seconds
+
+	/**
+	 * Bounded append-only response writer
+	 * Without WebServer writes to buffer only and sets overflow flag if it is full.
+	 * With WebServer the buffer is sent as chunks (chunked transfer-encoding) when full,
+	 * small responses are sent at once with Content-Length.
+	 */
+	class ResponseWriter{
+		public:
+			/**
+			 * @param {char*} buff (default: nullptr - internal ESP_JSON_CHUNK_SIZE buffer)
+			 * @param {size_t} buff size
+			 */
+			ResponseWriter(char* buff, size_t size);
+			/**
+			 * @param {WebServer*} pointer
+			 * @param {char*} buff (default: nullptr - internal ESP_JSON_CHUNK_SIZE buffer)
+			 * @param {size_t} buff size (default: 0)
+			 */
+#if defined(ARDUINO_ARCH_ESP8266)
+			ResponseWriter(ESP8266WebServer *webServer, char* buff = nullptr, size_t size = 0);
+#elif defined(ARDUINO_ARCH_ESP32)
+			ResponseWriter(WebServer *webServer, char* buff = nullptr, size_t size = 0);
+#endif
+			/**
+			 * Set response code and content type (only with WebServer)
+			 * @param {uint16_t} code (default: 200)
+			 * @param {char*} contentType (default: text/html)
+			 * @return none
+			 */
+			void begin(const uint16_t code = 200, const char* contentType = "text/html");
+			/**
+			 * Finish response and send rest of data (only with WebServer)
+			 * @return {bool} false if overflow
+			 */
+			bool end(void);
+			/**
+			 * Append text as is
+			 */
+			ResponseWriter& raw(const char* text);
+			/**
+			 * Append text with HTML escaping
+			 */
+			ResponseWriter& html(const char* text);
+			bool isOverflow(void) const { return overflow; }
+			size_t length(void) const { return pos; }
+			const char* c_str(void) const { return buff; }
+		protected:
+			void put(const char c);
+			void write(const char* data, size_t len);
+			void flush(void);
+#if defined(ARDUINO_ARCH_ESP8266)
+			ESP8266WebServer *webServer;
+#elif defined(ARDUINO_ARCH_ESP32)
+			WebServer *webServer;
+#endif
+			char chunk[ ESP_JSON_CHUNK_SIZE ];
+			char* buff;
+			size_t size;
+			size_t pos;
+			uint16_t code;
+			const char* contentType;
+			bool overflow;
+			bool chunked;
+	};
+
+	/**
+	 * JSON over ResponseWriter, content type is application/json
+	 */
+	class JsonWriter : public ResponseWriter{
+		public:
+			/**
+			 * @param {char*} buff (default: nullptr - internal ESP_JSON_CHUNK_SIZE buffer)
+			 * @param {size_t} buff size
+			 */
+			JsonWriter(char* buff, size_t size);
+			/**
+			 * @param {WebServer*} pointer
+			 * @param {char*} buff (default: nullptr - internal ESP_JSON_CHUNK_SIZE buffer)
+			 * @param {size_t} buff size (default: 0)
+			 */
+#if defined(ARDUINO_ARCH_ESP8266)
+			JsonWriter(ESP8266WebServer *webServer, char* buff = nullptr, size_t size = 0);
+#elif defined(ARDUINO_ARCH_ESP32)
+			JsonWriter(WebServer *webServer, char* buff = nullptr, size_t size = 0);
+#endif
+			/**
+			 * Set response code and content type (only with WebServer)
+			 * @param {uint16_t} code (default: 200)
+			 * @param {char*} contentType (default: application/json)
+			 * @return none
+			 */
+			void begin(const uint16_t code = 200, const char* contentType = "application/json");
+			JsonWriter& beginObject(const char* name = nullptr);
+			JsonWriter& endObject(void);
+			JsonWriter& beginArray(const char* name = nullptr);
+			JsonWriter& endArray(void);
+			JsonWriter& key(const char* name);
+			JsonWriter& str(const char* value);
+			JsonWriter& num(const int32_t value);
+			JsonWriter& unum(const uint32_t value);
+			JsonWriter& boolean(const bool value);
+			JsonWriter& null(void);
+			/**
+			 * Append text as is (pre-formatted JSON value)
+			 */
+			JsonWriter& raw(const char* text);
+		private:
+			void separator(void);
+			uint32_t first;							// bit per nesting level, set if no items at level yet
+			uint8_t depth;
+			bool afterKey;
+	};
+	
+	/**
+	 * checking acces from web
+	 * Successful digest auth opens a session cookie, next requests are checked by it.
+	 * Clients with repeated wrong credentials are throttled (429) without blocking the loop.
+	 * @param {WebServer*} user
+	 * @param {char*} user
+	 * @param {char*} password
+	 * @param {char*} realm
+	 * @param {char*} failMess
+	 * @return {uint8_t} result ( 1 - success, 0 - error )
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	uint8_t checkWebAuth(ESP8266WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess);
+#elif defined(ARDUINO_ARCH_ESP32)
+	uint8_t checkWebAuth(WebServer *webServer, const char *user, const char *password, const char *realm, const char *failMess);
+#endif
+	/**
+	 * remove from spi fs
+	 * @param {char*} filepath
+	 * @return none
+	 */
+	void removeFile(const char* file);
+	/**
+	 * set redirect to / from web
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void setWebRedirect(ESP8266WebServer *webServer, const String &target = "");
+#elif defined(ARDUINO_ARCH_ESP32)
+	void setWebRedirect(WebServer *webServer, const String &target = "");
+#endif
+	/**
+	 * checking Connections for AP from STA mode
+	 * @return none
+	 */
+	uint8_t isWiFiConnection(void);
+	/**
+	 * get esp chip ID
+	 * @return {uint32_t} ID or 0 if unknown device
+	 */
+	uint32_t getMyID(void);
+	/**
+	 * initialize wifi subsystem AP or STA
+	 * @param {IPAddress} ip
+	 * @param {IPAddress} gateway
+	 * @param {IPAddress} mask
+	 * @return {bool} true if correct
+	 */
+	bool wifi_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask);
+	/**
+	 * initialize wifi AP
+	 * @param {IPAddress} ip
+	 * @param {IPAddress} gateway
+	 * @param {IPAddress} mask
+	 * @return {bool} true if correct
+	 */
+	bool wifi_AP_init(const IPAddress &ip, const IPAddress &gateway, const IPAddress &mask);
+	/**
+	 * start async network scan, results are collected by esp::handle(), esp::getCountNetworks()
+	 * or /wifi?cmd=scan to esp::scanResults and served by /wifi?cmd=scan (add "refresh" to start new scan)
+	 * @return {bool} true if scan is running
+	 */
+	bool startWiFiScan(void);
+	/**
+	 * collect finished async scan without esp::handle()
+	 * @return {int8_t} networks found by last scan, esp::scanResults holds strongest of them
+	 */
+	int8_t getCountNetworks(void);
+	/**
+	 * initialize wifi STA, does not wait: connection, reconnection with backoff and AP fallback
+	 * are done by esp::handle(), see esp::staStatus.
+	 * With ESP_STA_ASYNC 0 waits up to ESP_STA_BLOCKING_TIMEOUT, then reconnects are left
+	 * to SDK auto reconnect and esp::handle() only follows the state
+	 * @return {bool} true if connection started (ESP_STA_ASYNC 0: true if connected)
+	 */
+	bool wifi_STA_init(void);
+	/**
+	 * checking acces from web
+	 * @param {WebServer*} pointer
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void setNoCacheContent(ESP8266WebServer *webServer);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void setNoCacheContent(WebServer *webServer);
+#endif
+	/**
+	 * add web server default pages callback
+	 * @param {WebServer*} pointer
+	 * @param {bool} wifi config page (default: true)
+	 * @param {bool} not found page (default: true)
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void addWebServerPages(ESP8266WebServer *webServer, bool wifiConfig = true, bool notFound = true);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void addWebServerPages(WebServer *webServer, bool wifiConfig = true, bool notFound = true);
+#endif
+	/**
+	 * add web server update logic
+	 * @param {WebServer*} pointer
+	 * @param {const char*} key (default: #define DEFAULT_UPDATE_KEY)
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void addWebUpdate(ESP8266WebServer *webServer, const char* key = DEFAULT_UPDATE_KEY);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void addWebUpdate(WebServer *webServer, const char* key = DEFAULT_UPDATE_KEY);
+#endif
+	/**
+	 * Activate web server Captive Portal logic
+	 * @param {WebServer*} pointer
+	 * @param {char*} url redirect to Captive portal page (default: nullptr)
+	 * @param {HandlerFunction} hanler function to Captive portal page (default: nullptr)
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void activateCaptivePortal(ESP8266WebServer *webServer, const char* captiveRedirectTarget = ESP_CAPTIVE_PORTAL_URL, ESP8266WebServer::THandlerFunction cp_handler = nullptr);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void activateCaptivePortal(WebServer *webServer, const char* captiveRedirectTarget = ESP_CAPTIVE_PORTAL_URL, WebServer::THandlerFunction cp_handler = nullptr);
+#endif
+	/**
+	 * web config page
+	 * @param {WebServer*} pointer
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void handleWebConfigPage(ESP8266WebServer *webServer);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void handleWebConfigPage(WebServer *webServer);
+#endif
+	/**
+	 * web not found page
+	 * @param {WebServer*} pointer
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void handleWeb404Page(ESP8266WebServer *webServer);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void handleWeb404Page(WebServer *webServer);
+#endif
+	/**
+	 * web send file to client or generate 404 error if file not found
+	 * Sends <fileName>.gz if exists and client accepts gzip, answers 304 by ETag / Last-Modified,
+	 * request with "v" argument (versioned asset) gets long-lived Cache-Control.
+	 * If ESP_WEB_CACHE_SIZE > 0 file content is kept at RAM (PSRAM on ESP32) LRU cache
+	 * @param {WebServer*} pointer
+	 * @param {char*} fileName
+	 * @param {char*} mimeType
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	uint8_t webSendFile(ESP8266WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code = 200);
+#elif defined(ARDUINO_ARCH_ESP32)
+	uint8_t webSendFile(WebServer *webServer, const char* fileName, const char* mimeType, const uint16_t code = 200);
+#endif
+	/**
+	 * Drop static files from RAM cache
+	 * @param {char*} filepath (default: nullptr - drop all)
+	 * @return none
+	 */
+	void webCacheInvalidate(const char* filepath = nullptr);
+	/**
+	 * Checking for updates 
+	 * Reads and verifies update manifest to esp::updateManifest, then downloadUpdate,
+	 * downloadAndFlash and updateFromFS reject firmware with other size or SHA-256.
+	 * Manifest is kept in ESP_FIRMWARE_MANIFEST_FILEPATH for updateFromFS after reboot.
+	 * With ESP_UPDATE_PUBLIC_KEY firmware is never flashed without valid signed manifest
+	 * @param {char*} repository url (http://example.com/folder)
+	 * @param {uint16_t} number of version
+	 * @return {uint32_t} available version number
+	 */
+	uint32_t checkingUpdate(const char *repoURL, const uint16_t version);
+	/**
+	 * Parse and verify update manifest (text is changed)
+	 * @param {char*} manifest text
+	 * @param {UpdateManifest&} result
+	 * @return {bool} true if manifest is valid
+	 */
+	bool parseUpdateManifest(char* text, UpdateManifest &manifest);
+	/**
+	 * Download new files
+	 * Data is written to <file>.part and renamed to <file> after length check.
+	 * Interrupted download is continued with Range request (also on next call),
+	 * If-Range with ETag or Last-Modified stored in <file>.part.tag restarts it if file was changed.
+	 * After failed call next calls return 0 without request for ESP_DOWNLOAD_BACKOFF (doubled up to ESP_DOWNLOAD_BACKOFF_MAX)
+	 * @param {char*} repository url (http://example.com/folder)
+	 * @param {char*} file (/firmware.bin)
+	 * @return {uint8_t} 0 if error, 1 if success
+	 */
+	uint8_t downloadUpdate(const char *repoURL, const char *file);
+	/**
+	 * Download firmware and write it directly to flash (without FS copy)
+	 * Image MD5 is checked if <repository>/firmware.md5 is published (404 - not published, other error aborts update)
+	 * @param {char*} repository url (http://example.com/folder)
+	 * @return {uint8_t} 0 if error, 1 if success (reboot to apply)
+	 */
+	uint8_t downloadAndFlash(const char *repoURL);
+	/**
+	 * Delta update: download patch and build new firmware from running one directly to flash
+	 * Needs manifest (checkingUpdate) with base equal to current version.
+	 * Patch format (little endian): "ESPDIFF1", u32 new size, then records
+	 * u32 diff length, u32 extra length, i32 old seek, diff bytes (added to old), extra bytes (as is)
+	 * @param {char*} repository url (http://example.com/folder)
+	 * @param {uint32_t} current firmware version
+	 * @return {uint8_t} 0 if error, 1 if success (reboot to apply)
+	 */
+	uint8_t downloadAndPatch(const char *repoURL, const uint32_t currentVersion);
+	/**
+	 * Set download progress callback
+	 * @param {DownloadProgressCallback} func (nullptr - disable)
+	 * @return none
+	 */
+	void setDownloadProgressCallback(DownloadProgressCallback func);
+	/**
+	 * Update firmware from FS, manifest is loaded from ESP_FIRMWARE_MANIFEST_FILEPATH if checkingUpdate was not called
+	 * @return {uint8_t} 0 if error, 1 if success
+	 */
+	uint8_t updateFromFS(void);
+	/**
+	 * Checking file in memory 
+	 * @param {char*} file path
+	 * @return {bool} available version number
+	 */
+	bool isFileExists(const char *filepath);
+	/**
+	 * Printing all files in memory
+	 * @param {HardwareSerial} Serial object
+	 * @return {none}
+	 */
+	void printAllFiles(HardwareSerial &SerialPort);
+	/**
+	 * Initialize for library methods
+	 * @param {char*} name - Device Name
+	 * @param {boolean} useFS (default: true)
+	 * @return {none}
+	 */
+	void init(const char* deviceName = DEFAULT_DEVICE_NAME, bool useFS = true);
+	/**
+	 * Change MAC (!!! use after Connection initialize)
+	 * @return {none}
+	 */
+	void changeMAC(const uint8_t *mac);
+	/**
+	 * HTTP Put request
+	 * @param {String &} URL
+	 * @param {String &} playload
+	 * @param {String &} response
+	 * @return {int} http response code
+	 */
+	int http_put(const String &url, const String &playload, String &response);
+	/**
+	 * CRC32 (IEEE 802.3)
+	 * @param {const uint8_t*} data
+	 * @param {size_t} length
+	 * @param {uint32_t} previous crc to continue (default: 0)
+	 * @return {uint32_t} crc
+	 */
+	uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+	/**
+	 * Save settings at file from SPI FS
+	 * Stored as one KV record (kvPut) with file name as key, previous copy stays valid if power is lost while writing.
+	 * Max 65535 bytes, file name max ESP_KV_KEY_MAX_LEN chars
+	 * @param {const uint8_t*} data buffer (default: nullptr)
+	 * @param {uint32_t} length data (default: 0)
+	 * @param {const char*} settingsFile - filepath (default: USER_SETTINGS_FILE)
+	 * @return {none}
+	 */
+	void saveSettings(const uint8_t* data = nullptr, uint32_t length = 0, const char* settingsFile = USER_SETTINGS_FILE);
+	/**
+	 * Read settings at file from SPI FS
+	 * KV record is used, then files of previous library versions (<file> and <file>.1 record slots or headerless <file>),
+	 * 0 if there is no valid record
+	 * @param {uint8_t*} data buffer (default: nullptr)
+	 * @param {uint32_t} length data (default: 0)
+	 * @param {const char*} settingsFile - filepath (default: USER_SETTINGS_FILE)
+	 * @return {uint32_t} reading length
+	 */
+	uint32_t loadSettings(uint8_t* data = nullptr, uint32_t size = 0, const char* settingsFile = USER_SETTINGS_FILE);
+	/**
+	 * Remove settings record and files of previous library versions
+	 * @param {const char*} settingsFile - filepath (default: USER_SETTINGS_FILE)
+	 * @return {none}
+	 */
+	void removeSettings(const char* settingsFile = USER_SETTINGS_FILE);
+	/**
+	 * Key/value settings storage: append-only log at ESP_KV_FILE with CRC per record,
+	 * RAM hash index is built at esp::init, log is compacted when it grows over ESP_KV_COMPACT_SIZE.
+	 * Unlike saveSettings only changed value is written.
+	 * Build index from log (called by esp::init)
+	 * @return {none}
+	 */
+	void kvInit(void);
+	/**
+	 * Write value
+	 * @param {const char*} key (max ESP_KV_KEY_MAX_LEN chars)
+	 * @param {const void*} value
+	 * @param {uint16_t} length
+	 * @return {bool} true if success
+	 */
+	bool kvPut(const char* key, const void* value, const uint16_t length);
+	/**
+	 * Read value
+	 * @param {const char*} key
+	 * @param {void*} value buffer
+	 * @param {uint16_t} buffer size
+	 * @return {int32_t} value length (may be more than size) or -1 if not found
+	 */
+	int32_t kvGet(const char* key, void* value, const uint16_t size);
+	/**
+	 * Remove value
+	 * @param {const char*} key
+	 * @return {bool} true if key was found
+	 */
+	bool kvRemove(const char* key);
+	/**
+	 * Rewrite log with live values only
+	 * Refused if kvInit could not index all keys (kvStats.dropped), log is not changed on error
+	 * @return {bool} true if success
+	 */
+	bool kvCompact(void);
+	/**
+	 * Set system user and password
+	 * @param {const char*} login (default: nullptr)
+	 * @param {const char*} password (default: nullptr)
+	 * @return {none}
+	 */
+	void changeSystemUserPassword(const char* login = nullptr, const char* password = nullptr);
+	/**
+	 * Update process function
+	 * @return {none}
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void updateProcess(ESP8266WebServer *webServer);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void updateProcess(WebServer *webServer);
+#endif
+	/**
+	 * Set application version
+	 * @param {const uint8_t} first version <FIRST>.1.256
+	 * @param {const uint8_t} second version 0.<SECOND>.256
+	 * @param {const uint16_t} thrid version 0.1.<THRID>
+	 * @return {none}
+	 */
+	void setVersion(const uint8_t first = 0, const uint8_t second = 1, const uint16_t thrid = 0);
+	/**
+	 * Get mode value
+	 * @return {uint8_t} esp::Mode enum
+	 */
+	uint8_t getMode(void);
+	/**
+	 * Set mode value
+	 * @param {const uint8_t} value must be lower at esp::Mode enum
+	 * @return none
+	 */
+	void setMode(const uint8_t value);
+	/**
+	 * Save system settings (internal method don`t use this method!!!)
+	 * Unchanged settings are not written, with ESP_SETTINGS_FLUSH_DELAY write is deferred
+	 * @return {none}
+	 */
+	void saveSystemSettings(void);
+	/**
+	 * Write pending system settings now (call before restart)
+	 * @return {none}
+	 */
+	void flushSystemSettings(void);
+	/**
+	 * Library background tasks, call from loop()
+	 * @return {none}
+	 */
+	void handle(void);
+	/**
+	 * Get reset reason
+	 * @return {uint32_t}
+	 */
+	uint32_t getResetReason(void);
+	/**
+	 * Enable Promisc mode method
+	 * @param {Callback function} (default: nullptr)
+	 * @return none
+	*/
+	void enablePromiscMode(wifi_promiscuous_cb_t func = nullptr);
+	/**
+	 * Disable Promisc mode method
+	 * @return none
+	*/
+	void disablePromiscMode(void);
+	/**
+	 * Hop over channels in promiscuous mode (call after enablePromiscMode), switched by esp::handle().
+	 * Dwell is from ESP_HOP_DWELL_MIN to ESP_HOP_DWELL_MAX by traffic of channel, see esp::hopChannelStats
+	 * @param {uint16_t} channels, bit per channel (bit 1 - channel 1)
+	 * @return none
+	 */
+	void startChannelHopping(const uint16_t channels = ESP_HOP_CHANNELS);
+	/**
+	 * Stay on current channel
+	 * @return none
+	 */
+	void stopChannelHopping(void);
+	/**
+	 * Set frame types passed to promiscuous callback (ESP32 - hardware filter, ESP8266 - checked before copy)
+	 * @param {uint32_t} ESP_PROMISC_FILTER_* mask
+	 * @return none
+	 */
+	void setPromiscFilter(const uint32_t mask);
+	/**
+	 * Frames waiting in promiscuous ring
+	 * @return {uint16_t}
+	 */
+	uint16_t promiscAvailable(void);
+	/**
+	 * Process frames from promiscuous ring, call from loop()
+	 * @param {PromiscFrameCallback} callback (nullptr - only drop frames)
+	 * @param {uint16_t} max frames (0 - all)
+	 * @return {uint16_t} processed frames
+	 */
+	uint16_t promiscDrain(PromiscFrameCallback cb, const uint16_t max = 0);
+	/**
+	 * Parse 802.11 header and rx metadata of captured frame
+	 * @param {PromiscFrame} raw frame
+	 * @param {WifiFrame} result
+	 * @return {bool} false if frame is too short
+	 */
+	bool parseFrame(const PromiscFrame &raw, WifiFrame &frame);
+	/**
+	 * Add frame to per-MAC table (by transmitter), old entries are aged and evicted
+	 * @param {WifiFrame} frame
+	 * @param {uint32_t} millis() of frame
+	 * @return none
+	 */
+	void macTableAdd(const WifiFrame &frame, const uint32_t time);
+	/**
+	 * Parse and aggregate frame, usage: esp::promiscDrain( esp::aggregateFrame )
+	 * @param {PromiscFrame} raw frame
+	 * @return none
+	 */
+	void aggregateFrame(const PromiscFrame &raw);
+	/**
+	 * Write per-MAC table as JSON array
+	 * @param {JsonWriter} writer
+	 * @param {uint32_t} current millis() for ages
+	 * @return none
+	 */
+	void macTableJson(JsonWriter &json, const uint32_t now);
+	/**
+	 * Write per-MAC table as binary: uint16 count, then ESP_MAC_EXPORT_RECORD_SIZE records (little endian):
+	 * mac[6], channel, mean rssi, packets (uint32), first seen age (uint32 sec), last seen age (uint32 sec), probed SSIDs
+	 * @param {uint8_t*} buffer
+	 * @param {size_t} buffer size
+	 * @param {uint32_t} current millis() for ages
+	 * @return {size_t} written bytes
+	 */
+	size_t macTableExport(uint8_t* buff, const size_t size, const uint32_t now);
+	/**
+	 * Remove all entries of per-MAC table
+	 * @return none
+	 */
+	void macTableClear(void);
+	/**
+	 * Callback to recieve RAW data, frames are stored to ring for esp::promiscDrain.
+	 * Device is restarted after READ_RAW_PACKETS_BEFORE_START frames only in raw configuration window after reset
+	 * @return none
+	 */
+#if defined(ARDUINO_ARCH_ESP8266)
+	void promisc_rx_cb(uint8_t *buf, uint16_t len);
+#elif defined(ARDUINO_ARCH_ESP32)
+	void promisc_rx_cb(void *buf, wifi_promiscuous_pkt_type_t type);
+#endif
+	
+#if defined(ARDUINO_ARCH_ESP8266)
+
+#elif defined(ARDUINO_ARCH_ESP32)
+	/**
+	 * Initialize CAN module, frames are moved between driver and rings by CAN task (started once)
+	 * @param {uint16_t} CAN Speed, kbit/s (timing is computed for speeds without predefined config)
+	 * @param {gpio_num_t} tx pin
+	 * @param {gpio_num_t} rx pin
+	 * @param {can_mode_t} mode (default: CAN_MODE_NORMAL)
+	 * @return none
+	 */
+	void CAN_Init(const uint16_t speed, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode = CAN_MODE_NORMAL);
+	/**
+	 * Initialize CAN module with custom bit timing
+	 * @param {can_timing_config_t} timing, see esp::CAN_timing
+	 * @param {gpio_num_t} tx pin
+	 * @param {gpio_num_t} rx pin
+	 * @param {can_mode_t} mode (default: CAN_MODE_NORMAL)
+	 * @return none
+	 */
+	void CAN_Init(const can_timing_config_t &timing, const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode = CAN_MODE_NORMAL);
+	/**
+	 * Compute bit timing for ESP_CAN_CLOCK
+	 * @param {uint32_t} bitrate, bit/s
+	 * @param {uint16_t} sample point, 0.1% (800 - 80%)
+	 * @param {can_timing_config_t} result
+	 * @return {bool} false if bitrate can not be reached within ESP_CAN_BITRATE_TOLERANCE
+	 * Gives the same registers as CAN_TIMING_CONFIG_25KBITS..1MBITS at their sample points (80%, 68% for 25K and 800K).
+	 * Below 25 kbit/s BRP would exceed 128 and false is returned.
+	 */
+	bool CAN_timing(const uint32_t bitrate, const uint16_t samplePoint, can_timing_config_t &timing);
+	/**
+	 * Detect bus rate, candidates are tried in listen only mode until error free frames are received.
+	 * Blocks up to ESP_CAN_AUTOBAUD_TIMEOUT for each rate, CAN is initialized at detected rate
+	 * @param {gpio_num_t} tx pin
+	 * @param {gpio_num_t} rx pin
+	 * @param {can_mode_t} mode after detection (default: CAN_MODE_NORMAL)
+	 * @param {uint32_t*} candidate rates, bit/s (default: common rates 25k - 1M)
+	 * @param {uint8_t} count of candidates
+	 * @return {uint32_t} detected rate, 0 - not detected, driver is uninstalled
+	 */
+	uint32_t CAN_autobaud(const gpio_num_t tx_pin, const gpio_num_t rx_pin, const can_mode_t mode = CAN_MODE_NORMAL, const uint32_t* rates = nullptr, uint8_t count = 0);
+	/**
+	 * Read received frame, non-blocking
+	 * @param {can_message_t} frame
+	 * @return {bool} false if nothing received
+	 */
+	bool CAN_read(can_message_t &msg);
+	/**
+	 * Frames waiting in rx ring
+	 * @return {uint16_t}
+	 */
+	uint16_t CAN_available(void);
+	/**
+	 * Queue frames for transmit, non-blocking, batch is passed to driver at once as driver queue allows,
+	 * the rest is passed by CAN task when driver reports sent frames
+	 * @param {can_message_t*} frames
+	 * @param {uint16_t} count
+	 * @return {uint16_t} queued frames (less than count if tx ring is full)
+	 */
+	uint16_t CAN_write(const can_message_t* msgs, const uint16_t count);
+	/**
+	 * Queue frame for transmit, non-blocking
+	 * @param {can_message_t} frame
+	 * @return {bool} false if tx ring is full
+	 */
+	bool CAN_write(const can_message_t &msg);
+	/**
+	 * Set receive filters, hardware filter (single or dual) is computed to pass all of them,
+	 * the rest is rejected by software. Running driver is reinstalled with new hardware filter
+	 * (configuration of last esp::CAN_Init, frames waiting in rx ring are dropped)
+	 * @param {CanFilter*} filters, nullptr with count 0 - receive all
+	 * @param {uint8_t} count, max ESP_CAN_FILTERS_MAX
+	 * @param {bool} measure - receive all, emulate hardware filter in software to count its rejects
+	 * @return {bool} false if too many filters
+	 */
+	bool CAN_setFilters(const CanFilter* filters, const uint8_t count, const bool measure = false);
+	/**
+	 * Getter for CAN speed value
+	 * @return {uint16_t} speed value
+	 */
+	uint16_t get_CAN_speed(void);
+#endif
+	/**
+	 * Print data at HEX format
+	 * @return {const uint8_t*} data pointer
+	 * @return {size_t} data length
+	 * @return none
+	*/
+	void printHexData(const uint8_t* data, size_t len);
+	/**
+	 * Initialize WDT
+	 * @return none
+	*/
+	void wdt_init(void);
+	/**
+	 * Reset WDT
+	 * @return none
+	*/
+	void wdt_reset(void);
+#if defined(ARDUINO_ARCH_ESP32)
+	/**
+	 * @brief Set RTC Date Time
+	 * @param  sc
+            second (0-59)
+    	@param  mn
+            minute (0-59)
+    	@param  hr
+            hour of day (0-23)
+    	@param  dy
+            day of month (1-31)
+	    @param  mt
+            month (1-12)
+    	@param  yr
+            year ie 2021
+    	@param  ms
+            microseconds (optional)
+	 * @return none
+	*/
+	void rtc_setDateTime(int sc, int mn, int hr, int dy, int mt, int yr, int ms = 0);
+	/**
+    	@brief  set the internal RTC time
+    	@param  epoch
+            epoch time in seconds
+    	@param  ms
+            microseconds (optional)
+	**/
+	void rtc_set(unsigned long epoch = 1609459200, int ms = 0);	// default (1609459200) = 1st Jan 2021
+	/**
+		@brief  get the internal RTC time as a tm struct
+		@return none
+	**/
+	struct tm* rtc_getDateTime(void);
+#endif
+}
+/*!
+    @brief  set the internal RTC time
+    
+*/
+//-------------------------------------------------------------------------------
+
+#endif /* __ESP_FUNCTIONS_H__ */
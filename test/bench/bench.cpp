@@ -0,0 +1,263 @@
+//-------------------------------------------------------------------------------
+// Host benchmarks of web pages, file serving, uploads, downloads, settings, KV store, update manifest
+// and aggregation of promiscuous frames
+//   esp_bench [--quick] [--pcap capture.pcap] [name...]
+// Prints requests/s, bytes/s and peak heap over baseline for every case,
+// --quick runs few iterations and fails on wrong responses (ctest)
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+#include <chrono>
+#include <filesystem>
+#include <unistd.h>
+#include <vector>
+
+static bool quick = false;
+static const char* pcap = nullptr;
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+// Runs op count times, op returns bytes moved
+static void bench(const char* name, uint32_t count, const std::function<size_t(uint32_t)> &op)
+{
+	if( quick ) count = std::max( 1u, count / 100 );
+	host::heapResetPeak();
+	size_t base = host::heapUsed();
+	uint64_t bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	for( uint32_t i = 0; i < count; i++ ) bytes += op( i );
+	double sec = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	if( sec <= 0 ) sec = 1e-9;
+	printf( "%-22s %8u ops %12.0f ops/s %10.2f MB/s %8lu heap peak\n", name, count, count / sec, bytes / sec / 1e6, (unsigned long)( host::heapPeak() - base ) );
+}
+
+//-------------------------------------------------------------------------------
+static void writeFile(const char* path, const std::string &data)
+{
+	File f = SPIFFS.open( path, "w" );
+	f.write( (const uint8_t*)data.data(), data.size() );
+	f.close();
+}
+
+//-------------------------------------------------------------------------------
+static std::string pattern(const size_t size, const uint32_t seed)
+{
+	std::string res( size, '\0' );
+	uint32_t x = seed * 2654435761u + 1;
+	for( size_t i = 0; i < size; i++ ){
+		x = x * 1103515245 + 12345;
+		res[ i ] = x >> 16;
+	}
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static bool selected(const std::vector<const char*> &names, const char* name)
+{
+	if( names.empty() ) return true;
+	for( const char* n : names ){
+		if( strcmp( n, name ) == 0 ) return true;
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	std::vector<const char*> names;
+	for( int i = 1; i < argc; i++ ){
+		if( strcmp( argv[ i ], "--quick" ) == 0 ){
+			quick = true;
+		}else if( strcmp( argv[ i ], "--pcap" ) == 0 && i + 1 < argc ){
+			pcap = argv[ ++i ];
+		}else{
+			names.push_back( argv[ i ] );
+		}
+	}
+
+	host::fsClear();
+	host::wifiNetworks( {
+		{ "home", "secret", { 0x10, 0, 0, 0, 0, 1 }, 6, -55, WIFI_AUTH_WPA2_PSK },
+		{ "office", "secret2", { 0x10, 0, 0, 0, 0, 2 }, 11, -70, WIFI_AUTH_WPA2_PSK },
+		{ "guest", "", { 0x10, 0, 0, 0, 0, 3 }, 1, -80, WIFI_AUTH_OPEN },
+	} );
+	esp::init( "bench" );
+	WebServer server;
+	esp::addWebServerPages( &server );
+	esp::addWebUpdate( &server, "key" );
+	esp::startWiFiScan();
+	esp::handle();
+
+	const HostParams auth = { { "Authorization", "admin:admin" } };
+
+	if( selected( names, "sysinfo" ) ){
+		bench( "web /sysinfo", 20000, [ & ](uint32_t i){
+			HostResponse res = server.request( "/sysinfo" );
+			CHECK( res.code == 200 && res.body.find( "\"cpu_freq\"" ) != std::string::npos );
+			return res.body.size();
+		} );
+	}
+
+	if( selected( names, "scan" ) ){
+		bench( "web /wifi?cmd=scan", 20000, [ & ](uint32_t i){
+			HostResponse res = server.request( "/wifi", HTTP_GET, { { "cmd", "scan" } }, auth );
+			CHECK( res.code == 200 && res.body.find( "\"office\"" ) != std::string::npos );
+			return res.body.size();
+		} );
+	}
+
+	if( selected( names, "404" ) ){
+		bench( "web 404", 20000, [ & ](uint32_t i){
+			HostResponse res = server.request( "/missing/page" );
+			// page of library is sent with 200 like /404.html and /index.html fallbacks
+			CHECK( res.code == 200 && res.body.find( "404 Not found" ) != std::string::npos );
+			return res.body.size();
+		} );
+	}
+
+	if( selected( names, "sendfile" ) ){
+		const std::string js = pattern( 24 * 1024, 1 );
+		writeFile( "/index.js", js );
+		bench( "webSendFile 24k", 5000, [ & ](uint32_t i){
+			HostResponse res = server.request( "/index.js" );
+			CHECK( res.code == 200 && res.body == js );
+			return res.body.size();
+		} );
+		bench( "webSendFile 304", 20000, [ & ](uint32_t i){
+			static String etag;
+			if( i == 0 ) etag = server.request( "/index.js" ).header( "ETag" );
+			HostResponse res = server.request( "/index.js", HTTP_GET, HostParams(), { { "If-None-Match", etag } } );
+			CHECK( res.code == 304 );
+			return res.body.size();
+		} );
+	}
+
+	if( selected( names, "upload" ) ){
+		const std::string data = pattern( 256 * 1024, 2 );
+		bench( "updateProcess 256k", 200, [ & ](uint32_t i){
+			HostResponse res = server.uploadFile( "/update", { { "sdf", "key" } }, "file", "upload.bin", (const uint8_t*)data.data(), data.size() );
+			CHECK( res.code == 200 && SPIFFS.open( "/upload.bin", "r" ).size() == data.size() );
+			return data.size();
+		} );
+		SPIFFS.remove( "/upload.bin" );
+	}
+
+	if( selected( names, "download" ) ){
+		host::HttpResource resource;
+		resource.body = pattern( 512 * 1024, 3 );
+		resource.etag = "\"bench\"";
+		host::httpServe( "http://repo/data.bin", resource );
+		bench( "downloadUpdate 512k", 100, [ & ](uint32_t i){
+			SPIFFS.remove( "/data.bin" );
+			CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 1 );
+			return resource.body.size();
+		} );
+		SPIFFS.remove( "/data.bin" );
+	}
+
+	if( selected( names, "settings" ) ){
+		uint8_t data[ 256 ];
+		memcpy( data, pattern( sizeof( data ), 4 ).data(), sizeof( data ) );
+		uint32_t saves = 0;
+		host::fsResetStats();
+		bench( "saveSettings 256", 20000, [ & ](uint32_t i){
+			data[ 0 ] = i;
+			saves++;
+			esp::saveSettings( data, sizeof( data ), "/bench.dat" );
+			return sizeof( data );
+		} );
+		printf( "%-22s %8.1f bytes written per save\n", "", (double)host::fsStats().bytesWritten / saves );
+		bench( "loadSettings 256", 20000, [ & ](uint32_t i){
+			uint8_t buff[ sizeof( data ) ];
+			CHECK( esp::loadSettings( buff, sizeof( buff ), "/bench.dat" ) == sizeof( buff ) && memcmp( buff, data, sizeof( data ) ) == 0 );
+			return sizeof( buff );
+		} );
+	}
+
+	if( selected( names, "kv" ) ){
+		// one counter of 32 parameters: per-key put against rewrite of all of them as blob
+		uint32_t params[ 32 ];
+		for( uint32_t i = 0; i < 32; i++ ){
+			char key[ 8 ];
+			snprintf( key, sizeof( key ), "p%lu", (unsigned long)i );
+			params[ i ] = i;
+			esp::kvPut( key, &params[ i ], sizeof( params[ i ] ) );
+		}
+		host::fsResetStats();
+		bench( "kvPut 4", 20000, [ & ](uint32_t i){
+			CHECK( esp::kvPut( "p0", &i, sizeof( i ) ) );
+			return sizeof( i );
+		} );
+		printf( "%-22s %8.1f bytes written per put\n", "", (double)host::fsStats().bytesWritten / ( quick ? 200 : 20000 ) );
+		host::fsResetStats();
+		bench( "saveSettings 32x4", 20000, [ & ](uint32_t i){
+			params[ 0 ] = i;
+			esp::saveSettings( (const uint8_t*)params, sizeof( params ), "/params.dat" );
+			return sizeof( params[ 0 ] );
+		} );
+		printf( "%-22s %8.1f bytes written per save\n", "", (double)host::fsStats().bytesWritten / ( quick ? 200 : 20000 ) );
+	}
+
+	if( selected( names, "manifest" ) ){
+		std::string text = "version=42\nsize=1048576\nsha256=" + std::string( 64, 'a' ) + "\nbase=41\n";
+#ifdef ESP_UPDATE_PUBLIC_KEY
+		// test key of CMakeLists.txt, signature is verified on every parse
+		uint8_t seed[ 32 ];
+		for( int i = 0; i < 32; i++ ) seed[ i ] = i + 1;
+		text += "sig=" + host::ed25519Sign( seed, text ) + "\n";
+		const char* name = "parseUpdateManifest sig";
+#else
+		const char* name = "parseUpdateManifest";
+#endif
+		bench( name, 20000, [ & ](uint32_t i){
+			char buff[ ESP_UPDATE_MANIFEST_MAX_LEN ];
+			memcpy( buff, text.c_str(), text.size() + 1 );
+			esp::UpdateManifest manifest;
+			CHECK( esp::parseUpdateManifest( buff, manifest ) && manifest.version == 42 );
+			return text.size();
+		} );
+	}
+
+	if( selected( names, "aggregate" ) ){
+		// replay of capture file, without --pcap synthetic one: 500 stations probing and sending data to 20 APs
+		std::vector<host::PcapFrame> frames;
+		if( pcap != nullptr ){
+			CHECK( host::pcapRead( pcap, frames ) && !frames.empty() );
+		}else{
+			std::string path = ( std::filesystem::temp_directory_path() / ( "esp_bench_" + std::to_string( getpid() ) + ".pcap" ) ).string();
+			for( uint32_t i = 0; i < 20000; i++ ){
+				uint32_t x = i * 2654435761u;
+				std::string frame( 24, '\0' );
+				bool probe = ( x >> 28 ) < 3;
+				frame[ 0 ] = ( probe ) ? 0x40 : 0x88;
+				frame[ 1 ] = ( probe ) ? 0x00 : 0x01;
+				memset( &frame[ 4 ], 0xFF, 6 );
+				frame[ 10 ] = 0x02;
+				frame[ 14 ] = ( x >> 8 ) % 500 >> 8;
+				frame[ 15 ] = ( x >> 8 ) % 500;
+				frame[ 21 ] = ( x >> 20 ) % 20;
+				frame += ( probe ) ? std::string( "\x00\x04" "home", 6 ) : std::string( 34, '\x55' );
+				frames.push_back( { i, (int8_t)( -40 - ( x >> 24 ) % 50 ), frame } );
+			}
+			CHECK( host::pcapWrite( path, frames ) && host::pcapRead( path, frames ) && frames.size() == 20000 );
+			std::filesystem::remove( path );
+		}
+		esp::enablePromiscMode();
+		esp::macTableClear();
+		bench( "aggregateFrame", 1000000, [ & ](uint32_t i){
+			const host::PcapFrame &frame = frames[ i % frames.size() ];
+			uint8_t type = ( frame.data.empty() ) ? WIFI_PKT_MISC : ( frame.data[ 0 ] >> 2 ) & 0x03;
+			host::promiscFeed( (const uint8_t*)frame.data.data(), frame.data.size(), frame.rssi, (wifi_promiscuous_pkt_type_t)type );
+			esp::promiscDrain( esp::aggregateFrame );
+			return frame.data.size();
+		} );
+		CHECK( frames.empty() || esp::macTableStats.entries > 0 );
+		printf( "%-22s %8u MACs, %u evictions\n", "", esp::macTableStats.entries, esp::macTableStats.evictions );
+		esp::disablePromiscMode();
+	}
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
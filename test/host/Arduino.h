@@ -0,0 +1,178 @@
+#ifndef __HOST_ARDUINO_H__
+#define __HOST_ARDUINO_H__
+
+//-------------------------------------------------------------------------------
+// Host (Linux) stand-in of Arduino-ESP32 core, only what esp_functions.cpp uses
+//-------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef const char* PGM_P;
+#define PROGMEM
+#define PSTR(s)									(s)
+#define F(s)									(s)
+#define FPSTR(s)								(s)
+#define CONTENT_LENGTH_UNKNOWN					((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET					((size_t)-2)
+
+//-------------------------------------------------------------------------------
+// Time is real monotonic clock plus virtual offset: delay() does not sleep, it moves clock forward
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void yield(void);
+uint32_t esp_random(void);
+bool psramFound(void);
+void* ps_malloc(size_t size);
+
+char* itoa(int value, char* str, int base);
+char* utoa(unsigned int value, char* str, int base);
+char* ltoa(long value, char* str, int base);
+char* ultoa(unsigned long value, char* str, int base);
+
+//-------------------------------------------------------------------------------
+class String{
+	public:
+		String(void) {}
+		String(const char* str) : s( ( str != nullptr ) ? str : "" ) {}
+		String(const std::string &str) : s( str ) {}
+		String(const char c) : s( 1, c ) {}
+		String(const int value) : s( std::to_string( value ) ) {}
+		String(const unsigned int value) : s( std::to_string( value ) ) {}
+		String(const long value) : s( std::to_string( value ) ) {}
+		String(const unsigned long value) : s( std::to_string( value ) ) {}
+		const char* c_str(void) const { return s.c_str(); }
+		unsigned int length(void) const { return s.size(); }
+		bool isEmpty(void) const { return s.empty(); }
+		bool reserve(const unsigned int size) { s.reserve( size ); return true; }
+		int indexOf(const char c, const unsigned int from = 0) const { return find( s.find( c, from ) ); }
+		int indexOf(const char* str, const unsigned int from = 0) const { return find( s.find( str, from ) ); }
+		int indexOf(const String &str, const unsigned int from = 0) const { return find( s.find( str.s, from ) ); }
+		String substring(const unsigned int from) const { return ( from < s.size() ) ? String( s.substr( from ) ) : String(); }
+		String substring(const unsigned int from, const unsigned int to) const { return ( from < s.size() && to > from ) ? String( s.substr( from, to - from ) ) : String(); }
+		long toInt(void) const { return atol( s.c_str() ); }
+		void toLowerCase(void) { for( char &c : s ) c = tolower( (unsigned char)c ); }
+		bool startsWith(const char* str) const { return s.compare( 0, strlen( str ), str ) == 0; }
+		bool endsWith(const char* str) const { size_t n = strlen( str ); return s.size() >= n && s.compare( s.size() - n, n, str ) == 0; }
+		bool equals(const char* str) const { return s == str; }
+		char operator[](const unsigned int i) const { return ( i < s.size() ) ? s[ i ] : '\0'; }
+		bool operator==(const char* str) const { return s == str; }
+		bool operator==(const String &str) const { return s == str.s; }
+		bool operator!=(const char* str) const { return s != str; }
+		bool operator!=(const String &str) const { return s != str.s; }
+		bool operator<(const String &str) const { return s < str.s; }
+		String& operator+=(const char* str) { s += str; return *this; }
+		String& operator+=(const String &str) { s += str.s; return *this; }
+		String& operator+=(const char c) { s += c; return *this; }
+		friend String operator+(const String &a, const String &b) { return String( a.s + b.s ); }
+		friend String operator+(const char* a, const String &b) { return String( std::string( a ) + b.s ); }
+		friend String operator+(const String &a, const char* b) { return String( a.s + b ); }
+		const std::string& str(void) const { return s; }
+	private:
+		static int find(const size_t pos) { return ( pos == std::string::npos ) ? -1 : (int)pos; }
+		std::string s;
+};
+
+//-------------------------------------------------------------------------------
+class Print{
+	public:
+		virtual ~Print(void) {}
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t* data, size_t len)
+		{
+			size_t n = 0;
+			while( n < len && write( data[ n ] ) ) n++;
+			return n;
+		}
+		size_t write(const char* str) { return write( (const uint8_t*)str, strlen( str ) ); }
+		size_t print(const char* str) { return write( str ); }
+		size_t print(const String &str) { return write( str.c_str() ); }
+		size_t println(const char* str = "") { return write( str ) + write( "\r\n" ); }
+		size_t println(const String &str) { return println( str.c_str() ); }
+		size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+		{
+			char buff[ 256 ];
+			va_list args;
+			va_start( args, format );
+			int len = vsnprintf( buff, sizeof( buff ), format, args );
+			va_end( args );
+			return ( len > 0 ) ? write( (const uint8_t*)buff, std::min( (size_t)len, sizeof( buff ) - 1 ) ) : 0;
+		}
+		size_t printf_P(PGM_P format, ...);
+};
+
+//-------------------------------------------------------------------------------
+class Stream : public Print{
+	public:
+		virtual int available(void) = 0;
+		virtual int read(void) = 0;
+		virtual int peek(void) { return -1; }
+		virtual size_t readBytes(uint8_t* buff, size_t len)
+		{
+			size_t n = 0;
+			while( n < len ){
+				int c = read();
+				if( c < 0 ) break;
+				buff[ n++ ] = c;
+			}
+			return n;
+		}
+		size_t readBytes(char* buff, size_t len) { return readBytes( (uint8_t*)buff, len ); }
+		void setTimeout(unsigned long timeout) {}
+};
+
+//-------------------------------------------------------------------------------
+// stdout, used for debug output of library (DEBUG_ESP) and printAllFiles
+class HardwareSerial : public Stream{
+	public:
+		void begin(unsigned long baud) {}
+		size_t write(uint8_t c) override { return fwrite( &c, 1, 1, stdout ); }
+		size_t write(const uint8_t* data, size_t len) override { return fwrite( data, 1, len, stdout ); }
+		int available(void) override { return 0; }
+		int read(void) override { return -1; }
+};
+extern HardwareSerial Serial;
+
+//-------------------------------------------------------------------------------
+class IPAddress{
+	public:
+		IPAddress(void) : addr( 0 ) {}
+		IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr( a | ( b << 8 ) | ( c << 16 ) | ( (uint32_t)d << 24 ) ) {}
+		IPAddress(uint32_t value) : addr( value ) {}
+		operator uint32_t(void) const { return addr; }
+		uint8_t operator[](const int i) const { return addr >> ( i * 8 ); }
+		bool operator==(const IPAddress &ip) const { return addr == ip.addr; }
+		String toString(void) const
+		{
+			char buff[ 16 ];
+			snprintf( buff, sizeof( buff ), "%u.%u.%u.%u", (*this)[ 0 ], (*this)[ 1 ], (*this)[ 2 ], (*this)[ 3 ] );
+			return String( buff );
+		}
+	private:
+		uint32_t addr;
+};
+
+//-------------------------------------------------------------------------------
+class EspClass{
+	public:
+		uint32_t getCpuFreqMHz(void) { return 240; }
+		uint64_t getEfuseMac(void) { return 0x0000A1B2C3D4E5F6ULL; }
+		uint32_t getFreeHeap(void);
+		uint32_t getFreeSketchSpace(void) { return 0x1E0000; }
+		void restart(void);
+};
+extern EspClass ESP;
+
+#endif /* __HOST_ARDUINO_H__ */
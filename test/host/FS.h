@@ -0,0 +1,75 @@
+#ifndef __HOST_FS_H__
+#define __HOST_FS_H__
+
+//-------------------------------------------------------------------------------
+// Host stand-in of Arduino FS: files of a directory (see host::fsRoot)
+//-------------------------------------------------------------------------------
+#include "Arduino.h"
+#include <memory>
+
+namespace fs {
+	enum SeekMode{
+		SeekSet,
+		SeekCur,
+		SeekEnd,
+	};
+
+	struct FileImpl;
+
+	//-------------------------------------------------------------------------------
+	// Copies share one open file like Arduino File
+	class File : public Stream{
+		public:
+			File(void) {}
+			explicit File(std::shared_ptr<FileImpl> impl) : impl( impl ) {}
+			size_t write(uint8_t c) override { return write( &c, 1 ); }
+			size_t write(const uint8_t* data, size_t len) override;
+			int available(void) override;
+			int read(void) override;
+			int peek(void) override;
+			size_t read(uint8_t* buff, size_t len);
+			size_t readBytes(uint8_t* buff, size_t len) override { return read( buff, len ); }
+			void flush(void);
+			bool seek(uint32_t pos, SeekMode mode = SeekSet);
+			size_t position(void) const;
+			size_t size(void) const;
+			void close(void);
+			time_t getLastWrite(void);
+			const char* path(void) const;
+			const char* name(void) const;
+			bool isDirectory(void) const;
+			File openNextFile(const char* mode = "r");
+			operator bool(void) const;
+		private:
+			std::shared_ptr<FileImpl> impl;
+	};
+
+	//-------------------------------------------------------------------------------
+	class FS{
+		public:
+			bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char* partitionLabel = nullptr);
+			void end(void) {}
+			bool format(void);
+			size_t totalBytes(void);
+			size_t usedBytes(void);
+			File open(const char* path, const char* mode = "r", const bool create = false);
+			File open(const String &path, const char* mode = "r", const bool create = false) { return open( path.c_str(), mode, create ); }
+			bool exists(const char* path);
+			bool exists(const String &path) { return exists( path.c_str() ); }
+			bool remove(const char* path);
+			bool remove(const String &path) { return remove( path.c_str() ); }
+			bool rename(const char* from, const char* to);
+			bool rename(const String &from, const String &to) { return rename( from.c_str(), to.c_str() ); }
+			bool mkdir(const char* path);
+			bool rmdir(const char* path);
+	};
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif /* __HOST_FS_H__ */
@@ -0,0 +1,79 @@
+#ifndef __HOST_HTTPCLIENT_H__
+#define __HOST_HTTPCLIENT_H__
+
+//-------------------------------------------------------------------------------
+// HTTPClient served by in-process resources (host::httpServe) instead of network
+//-------------------------------------------------------------------------------
+#include "WiFi.h"
+#include <memory>
+#include <vector>
+#include <utility>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED			(-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED			(-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED			(-3)
+#define HTTPC_ERROR_NOT_CONNECTED				(-4)
+#define HTTPC_ERROR_CONNECTION_LOST				(-5)
+#define HTTPC_ERROR_NO_STREAM					(-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER				(-7)
+#define HTTPC_ERROR_TOO_LESS_RAM				(-8)
+#define HTTPC_ERROR_ENCODING					(-9)
+#define HTTPC_ERROR_STREAM_WRITE				(-10)
+#define HTTPC_ERROR_READ_TIMEOUT				(-11)
+
+#define HTTP_CODE_OK							200
+#define HTTP_CODE_PARTIAL_CONTENT				206
+#define HTTP_CODE_NOT_MODIFIED					304
+#define HTTP_CODE_NOT_FOUND						404
+#define HTTP_CODE_RANGE_NOT_SATISFIABLE			416
+#define HTTP_CODE_INTERNAL_SERVER_ERROR			500
+
+//-------------------------------------------------------------------------------
+// Response body (part of shared resource from start), may be cut after some bytes to simulate dropped connection
+class HostHttpStream : public WiFiClient{
+	public:
+		HostHttpStream(std::shared_ptr<const std::string> body, const size_t start, const size_t dropAt) : body( body ), dropAt( start + dropAt ), pos( start ) {}
+		int available(void) override;
+		int read(void) override;
+		int read(uint8_t* buff, size_t len) override;
+		uint8_t connected(void) override { return pos < end(); }
+		void stop(void) override { pos = body->size(); }
+	private:
+		size_t end(void) const { return std::min( body->size(), dropAt ); }
+		std::shared_ptr<const std::string> body;
+		size_t dropAt;
+		size_t pos;
+};
+
+//-------------------------------------------------------------------------------
+class HTTPClient{
+	public:
+		bool begin(const String &url) { this->url = url; return true; }
+		bool begin(WiFiClient &client, const String &url) { return begin( url ); }
+		void end(void);
+		void setTimeout(uint16_t timeout) {}
+		void setReuse(bool reuse) {}
+		void addHeader(const String &name, const String &value) { requestHeaders.push_back( { name, value } ); }
+		void collectHeaders(const char* headerKeys[], const size_t count);
+		String header(const char* name);
+		bool hasHeader(const char* name);
+		int GET(void) { return sendRequest( "GET", String() ); }
+		int PUT(const String &payload) { return sendRequest( "PUT", payload ); }
+		int getSize(void) { return size; }
+		WiFiClient* getStreamPtr(void) { return stream.get(); }
+		WiFiClient& getStream(void) { return *stream; }
+		String getString(void);
+		bool connected(void) { return stream && stream->connected(); }
+		static String errorToString(int error);
+	private:
+		int sendRequest(const char* method, const String &payload);
+
+		String url;
+		std::vector<std::pair<String, String>> requestHeaders;
+		std::vector<std::pair<String, String>> responseHeaders;
+		std::vector<String> collected;
+		std::unique_ptr<HostHttpStream> stream;
+		int size = -1;
+};
+
+#endif /* __HOST_HTTPCLIENT_H__ */
@@ -0,0 +1,13 @@
+#ifndef __HOST_SPIFFS_H__
+#define __HOST_SPIFFS_H__
+
+#include "FS.h"
+
+namespace fs {
+	class SPIFFSFS : public FS{
+	};
+}
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif /* __HOST_SPIFFS_H__ */
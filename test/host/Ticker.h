@@ -0,0 +1,22 @@
+#ifndef __HOST_TICKER_H__
+#define __HOST_TICKER_H__
+
+#include "Arduino.h"
+
+//-------------------------------------------------------------------------------
+// Callback runs from host::advance() when its time has come
+class Ticker{
+	public:
+		typedef std::function<void(void)> callback_function_t;
+		~Ticker(void) { detach(); }
+		void once_ms(uint32_t ms, callback_function_t callback);
+		void detach(void);
+		bool active(void) const { return armed; }
+		void fire(const uint32_t now);
+	private:
+		callback_function_t callback;
+		uint32_t due = 0;
+		bool armed = false;
+};
+
+#endif /* __HOST_TICKER_H__ */
@@ -0,0 +1,60 @@
+#ifndef __HOST_UPDATE_H__
+#define __HOST_UPDATE_H__
+
+//-------------------------------------------------------------------------------
+// Update into memory, result is checked by host::updateImage() / host::updateState()
+//-------------------------------------------------------------------------------
+#include "Arduino.h"
+#include <vector>
+
+#define U_FLASH									0
+#define U_SPIFFS								100
+#define U_AUTH									200
+
+#define UPDATE_ERROR_OK							(0)
+#define UPDATE_ERROR_WRITE						(1)
+#define UPDATE_ERROR_ERASE						(2)
+#define UPDATE_ERROR_READ						(3)
+#define UPDATE_ERROR_SPACE						(4)
+#define UPDATE_ERROR_SIZE						(5)
+#define UPDATE_ERROR_STREAM						(6)
+#define UPDATE_ERROR_MD5						(7)
+#define UPDATE_ERROR_MAGIC_BYTE					(8)
+#define UPDATE_ERROR_ACTIVATE					(9)
+#define UPDATE_ERROR_NO_PARTITION				(10)
+#define UPDATE_ERROR_BAD_ARGUMENT				(11)
+#define UPDATE_ERROR_ABORT						(12)
+
+#define UPDATE_SIZE_UNKNOWN						0xFFFFFFFF
+
+class UpdateClass{
+	public:
+		bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH);
+		size_t write(uint8_t* data, size_t len);
+		size_t writeStream(Stream &data);
+		bool end(bool evenIfRemaining = false);
+		void abort(void);
+		bool setMD5(const char* expectedMD5);
+		void printError(Print &out) { out.printf( "Update error %u\n", error ); }
+		bool hasError(void) { return error != UPDATE_ERROR_OK; }
+		uint8_t getError(void) { return error; }
+		bool isRunning(void) { return running; }
+		bool isFinished(void) { return total > 0 && image.size() == total; }
+		size_t size(void) { return total; }
+		size_t progress(void) { return image.size(); }
+		size_t remaining(void) { return total - image.size(); }
+
+		// host side
+		std::vector<uint8_t> image;
+		int command = U_FLASH;
+		bool committed = false;
+		bool aborted = false;
+	private:
+		size_t total = 0;
+		uint8_t error = UPDATE_ERROR_OK;
+		bool running = false;
+		char md5[ 33 ] = { 0 };
+};
+extern UpdateClass Update;
+
+#endif /* __HOST_UPDATE_H__ */
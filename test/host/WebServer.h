@@ -0,0 +1,124 @@
+#ifndef __HOST_WEBSERVER_H__
+#define __HOST_WEBSERVER_H__
+
+//-------------------------------------------------------------------------------
+// WebServer without sockets: host::request() runs handlers and returns whole response
+//-------------------------------------------------------------------------------
+#include "WiFi.h"
+#include "FS.h"
+#include <map>
+#include <vector>
+#include <utility>
+
+enum HTTPMethod{
+	HTTP_ANY,
+	HTTP_GET,
+	HTTP_HEAD,
+	HTTP_POST,
+	HTTP_PUT,
+	HTTP_PATCH,
+	HTTP_DELETE,
+	HTTP_OPTIONS,
+};
+enum HTTPAuthMethod{
+	BASIC_AUTH,
+	DIGEST_AUTH,
+};
+enum HTTPUploadStatus{
+	UPLOAD_FILE_START,
+	UPLOAD_FILE_WRITE,
+	UPLOAD_FILE_END,
+	UPLOAD_FILE_ABORTED,
+};
+
+#define HTTP_UPLOAD_BUFLEN						1436
+
+typedef struct {
+	HTTPUploadStatus status;
+	String filename;
+	String name;
+	String type;
+	size_t totalSize;
+	size_t currentSize;
+	uint8_t buf[ HTTP_UPLOAD_BUFLEN ];
+} HTTPUpload;
+
+typedef std::vector<std::pair<String, String>> HostParams;
+
+//-------------------------------------------------------------------------------
+struct HostResponse{
+	int code = 0;
+	String contentType;
+	HostParams headers;
+	std::string body;
+	bool chunked = false;
+	const char* header(const char* name) const;
+};
+
+//-------------------------------------------------------------------------------
+class WebServer{
+	public:
+		typedef std::function<void(void)> THandlerFunction;
+
+		WebServer(int port = 80) {}
+		void begin(void) {}
+		void handleClient(void) {}
+		void on(const String &uri, THandlerFunction handler) { on( uri, HTTP_ANY, handler ); }
+		void on(const String &uri, HTTPMethod method, THandlerFunction handler) { on( uri, method, handler, nullptr ); }
+		void on(const String &uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler);
+		void onNotFound(THandlerFunction handler) { notFound = handler; }
+
+		void send(int code, const char* contentType = nullptr, const String &content = String());
+		void send(int code, const String &contentType, const String &content) { send( code, contentType.c_str(), content ); }
+		void send_P(int code, PGM_P contentType, PGM_P content) { send( code, contentType, String( content ) ); }
+		void send_P(int code, PGM_P contentType, PGM_P content, size_t len) { send( code, contentType, String( std::string( content, len ) ) ); }
+		void sendHeader(const String &name, const String &value, bool first = false);
+		void setContentLength(const size_t len) { contentLength = len; }
+		void sendContent(const char* content, size_t len);
+		void sendContent(const String &content) { sendContent( content.c_str(), content.length() ); }
+		void sendContent_P(PGM_P content, size_t len) { sendContent( content, len ); }
+		size_t streamFile(File &file, const String &contentType, const int code = 200);
+
+		bool authenticate(const char* user, const char* password);
+		void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char* realm = nullptr, const String &failMess = String());
+
+		String uri(void) { return currentUri; }
+		HTTPMethod method(void) { return currentMethod; }
+		bool hasArg(const String &name);
+		String arg(const String &name);
+		int args(void) { return currentArgs.size(); }
+		void collectHeaders(const char* headerKeys[], const size_t count);
+		bool hasHeader(const String &name);
+		String header(const String &name);
+		WiFiClient& client(void) { return currentClient; }
+		HTTPUpload& upload(void) { return currentUpload; }
+
+		// host side: one request through routes, upload body is split to HTTP_UPLOAD_BUFLEN parts
+		HostResponse request(const char* uri, HTTPMethod method = HTTP_GET, const HostParams &args = HostParams(), const HostParams &headers = HostParams());
+		HostResponse uploadFile(const char* uri, const HostParams &args, const char* name, const char* filename, const uint8_t* data, size_t len, bool abort = false);
+	private:
+		struct Route{
+			String uri;
+			HTTPMethod method;
+			THandlerFunction handler;
+			THandlerFunction uploadHandler;
+		};
+		Route* findRoute(void);
+		void start(const char* uri, HTTPMethod method, const HostParams &args, const HostParams &headers);
+
+		std::vector<Route> routes;
+		THandlerFunction notFound;
+		std::vector<String> collected;
+		String currentUri;
+		HTTPMethod currentMethod = HTTP_GET;
+		HostParams currentArgs;
+		HostParams currentHeaders;
+		HostParams pendingHeaders;
+		WiFiClient currentClient;
+		HTTPUpload currentUpload;
+		HostResponse response;
+		size_t contentLength = CONTENT_LENGTH_NOT_SET;
+		bool headersSent = false;
+};
+
+#endif /* __HOST_WEBSERVER_H__ */
@@ -0,0 +1,97 @@
+#ifndef __HOST_WIFI_H__
+#define __HOST_WIFI_H__
+
+//-------------------------------------------------------------------------------
+// Simulated radio: networks in range, scan and connect times are set by host::wifi*
+//-------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "esp_wifi.h"
+
+typedef enum {
+	WL_NO_SHIELD = 255,
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL,
+	WL_SCAN_COMPLETED,
+	WL_CONNECTED,
+	WL_CONNECT_FAILED,
+	WL_CONNECTION_LOST,
+	WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum {
+	WIFI_OFF = 0,
+	WIFI_STA,
+	WIFI_AP,
+	WIFI_AP_STA
+} WiFiMode_t;
+
+#define WIFI_SCAN_RUNNING						(-1)
+#define WIFI_SCAN_FAILED						(-2)
+
+//-------------------------------------------------------------------------------
+// Connection of HTTPClient or WebServer, byte stream of response body
+class WiFiClient : public Stream{
+	public:
+		size_t write(uint8_t c) override { return 1; }
+		size_t write(const uint8_t* data, size_t len) override { return len; }
+		int available(void) override { return 0; }
+		int read(void) override { return -1; }
+		virtual int read(uint8_t* buff, size_t len) { return (int)readBytes( buff, len ); }
+		virtual uint8_t connected(void) { return 0; }
+		virtual void stop(void) {}
+		IPAddress remoteIP(void) { return remoteAddr; }
+		IPAddress localIP(void) { return IPAddress( 192, 168, 4, 1 ); }
+		void setNoDelay(bool noDelay) {}
+		IPAddress remoteAddr = IPAddress( 192, 168, 4, 2 );
+};
+
+//-------------------------------------------------------------------------------
+class WiFiClass{
+	public:
+		wl_status_t status(void);
+		bool isConnected(void) { return status() == WL_CONNECTED; }
+		wl_status_t begin(const char* ssid, const char* key = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr, bool connect = true);
+		bool disconnect(bool wifiOff = false, bool eraseAp = false);
+		bool config(IPAddress ip, IPAddress gateway, IPAddress mask, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+		bool mode(WiFiMode_t mode) { wifiMode = mode; return true; }
+		WiFiMode_t getMode(void) { return wifiMode; }
+		void persistent(bool persistent) {}
+		bool setAutoReconnect(bool autoReconnect) { this->autoReconnect = autoReconnect; return true; }
+		bool getAutoReconnect(void) { return autoReconnect; }
+		bool setAutoConnect(bool autoConnect) { return true; }
+		bool hostname(const char* name) { return true; }
+		bool setHostname(const char* name) { return true; }
+
+		int16_t scanNetworks(bool async = false, bool showHidden = false);
+		int16_t scanComplete(void);
+		void scanDelete(void);
+		String SSID(uint8_t i);
+		int32_t RSSI(uint8_t i);
+		int32_t channel(uint8_t i);
+		uint8_t* BSSID(uint8_t i);
+		wifi_auth_mode_t encryptionType(uint8_t i);
+
+		String SSID(void);
+		int32_t RSSI(void);
+		int32_t channel(void);
+		uint8_t* BSSID(void);
+		IPAddress localIP(void);
+		IPAddress gatewayIP(void);
+		IPAddress subnetMask(void);
+		IPAddress dnsIP(uint8_t i = 0);
+		String macAddress(void);
+
+		bool softAP(const char* ssid, const char* key = nullptr, int channel = 1, int hidden = 0, int maxConnection = 4) { apSsid = ssid; return true; }
+		bool softAPConfig(IPAddress ip, IPAddress gateway, IPAddress mask) { apIp = ip; return true; }
+		bool softAPdisconnect(bool wifiOff = false) { apSsid = ""; return true; }
+		IPAddress softAPIP(void) { return apIp; }
+		String softAPSSID(void) { return apSsid; }
+	private:
+		WiFiMode_t wifiMode = WIFI_OFF;
+		bool autoReconnect = true;
+		String apSsid;
+		IPAddress apIp = IPAddress( 192, 168, 4, 1 );
+};
+extern WiFiClass WiFi;
+
+#endif /* __HOST_WIFI_H__ */
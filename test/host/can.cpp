@@ -0,0 +1,182 @@
+//-------------------------------------------------------------------------------
+// CAN driver with in-memory bus
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include <deque>
+#include <mutex>
+
+namespace host {
+	static std::mutex canMutex;
+	static bool installed = false;
+	static bool started = false;
+	static can_general_config_t general;
+	static can_timing_config_t timing;
+	static can_filter_config_t filter;
+	static std::deque<can_message_t> rx;
+	static std::vector<can_message_t> sent;
+	static uint32_t alerts = 0;
+	static uint32_t installs = 0;
+	static can_status_info_t status;
+
+	//-------------------------------------------------------------------------------
+	void canInject(const can_message_t &msg)
+	{
+		std::lock_guard<std::mutex> lock( host::canMutex );
+		if( !host::started ) return;
+		if( host::rx.size() >= host::general.rx_queue_len ){
+			host::status.rx_missed_count++;
+			host::alerts |= CAN_ALERT_RX_QUEUE_FULL;
+			return;
+		}
+		host::rx.push_back( msg );
+		host::status.msgs_to_rx = host::rx.size();
+		host::alerts |= CAN_ALERT_RX_DATA;
+	}
+
+	//-------------------------------------------------------------------------------
+	std::vector<can_message_t> canSent(void)
+	{
+		std::lock_guard<std::mutex> lock( host::canMutex );
+		return host::sent;
+	}
+
+	//-------------------------------------------------------------------------------
+	void canAlerts(const uint32_t alerts)
+	{
+		std::lock_guard<std::mutex> lock( host::canMutex );
+		host::alerts |= alerts;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool canInstalled(void)
+	{
+		return host::installed;
+	}
+
+	//-------------------------------------------------------------------------------
+	can_filter_config_t canFilter(void)
+	{
+		return host::filter;
+	}
+
+	//-------------------------------------------------------------------------------
+	can_timing_config_t canTiming(void)
+	{
+		return host::timing;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t canInstalls(void)
+	{
+		return host::installs;
+	}
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_driver_install(const can_general_config_t* g_config, const can_timing_config_t* t_config, const can_filter_config_t* f_config)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( host::installed ) return ESP_ERR_INVALID_STATE;
+	host::general = *g_config;
+	host::timing = *t_config;
+	host::filter = *f_config;
+	host::installed = true;
+	host::installs++;
+	host::rx.clear();
+	host::alerts = 0;
+	memset( &host::status, 0, sizeof( host::status ) );
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_driver_uninstall(void)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed || host::started ) return ESP_ERR_INVALID_STATE;
+	host::installed = false;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_start(void)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed || host::started ) return ESP_ERR_INVALID_STATE;
+	host::started = true;
+	host::status.state = CAN_STATE_RUNNING;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_stop(void)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::started ) return ESP_ERR_INVALID_STATE;
+	host::started = false;
+	host::status.state = CAN_STATE_STOPPED;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+// Frames go out at once, bus is always free
+esp_err_t can_transmit(const can_message_t* message, TickType_t ticks_to_wait)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::started ) return ESP_ERR_INVALID_STATE;
+	if( host::general.mode == CAN_MODE_LISTEN_ONLY ) return ESP_ERR_INVALID_STATE;
+	host::sent.push_back( *message );
+	host::alerts |= CAN_ALERT_TX_SUCCESS | CAN_ALERT_TX_IDLE;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_receive(can_message_t* message, TickType_t ticks_to_wait)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed ) return ESP_ERR_INVALID_STATE;
+	if( host::rx.empty() ) return ESP_ERR_TIMEOUT;
+	*message = host::rx.front();
+	host::rx.pop_front();
+	host::status.msgs_to_rx = host::rx.size();
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+// Does not wait, task of library is not started on host
+esp_err_t can_read_alerts(uint32_t* alerts, TickType_t ticks_to_wait)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed ) return ESP_ERR_INVALID_STATE;
+	*alerts = host::alerts & host::general.alerts_enabled;
+	host::alerts = 0;
+	return ( *alerts ) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_reconfigure_alerts(uint32_t alerts_enabled, uint32_t* current_alerts)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed ) return ESP_ERR_INVALID_STATE;
+	host::general.alerts_enabled = alerts_enabled;
+	if( current_alerts != nullptr ) *current_alerts = host::alerts;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_initiate_recovery(void)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( host::status.state != CAN_STATE_BUS_OFF ) return ESP_ERR_INVALID_STATE;
+	host::status.state = CAN_STATE_RECOVERING;
+	host::alerts |= CAN_ALERT_BUS_RECOVERED;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t can_get_status_info(can_status_info_t* status_info)
+{
+	std::lock_guard<std::mutex> lock( host::canMutex );
+	if( !host::installed ) return ESP_ERR_INVALID_STATE;
+	*status_info = host::status;
+	return ESP_OK;
+}
@@ -0,0 +1,132 @@
+#ifndef __HOST_DRIVER_CAN_H__
+#define __HOST_DRIVER_CAN_H__
+
+//-------------------------------------------------------------------------------
+// ESP-IDF 4.x CAN driver API, frames are queued in memory (host::canInject / host::canSent)
+//-------------------------------------------------------------------------------
+#include <stdint.h>
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int gpio_num_t;
+#define GPIO_NUM_NC								(-1)
+#define ESP_INTR_FLAG_LEVEL1					(1<<1)
+
+typedef enum {
+	CAN_MODE_NORMAL,
+	CAN_MODE_NO_ACK,
+	CAN_MODE_LISTEN_ONLY,
+} can_mode_t;
+
+typedef enum {
+	CAN_STATE_STOPPED,
+	CAN_STATE_RUNNING,
+	CAN_STATE_BUS_OFF,
+	CAN_STATE_RECOVERING,
+} can_state_t;
+
+typedef struct {
+	can_mode_t mode;
+	gpio_num_t tx_io;
+	gpio_num_t rx_io;
+	gpio_num_t clkout_io;
+	gpio_num_t bus_off_io;
+	uint32_t tx_queue_len;
+	uint32_t rx_queue_len;
+	uint32_t alerts_enabled;
+	uint32_t clkout_divider;
+	int intr_flags;
+} can_general_config_t;
+
+typedef struct {
+	uint32_t brp;
+	uint8_t tseg_1;
+	uint8_t tseg_2;
+	uint8_t sjw;
+	bool triple_sampling;
+} can_timing_config_t;
+
+typedef struct {
+	uint32_t acceptance_code;
+	uint32_t acceptance_mask;
+	bool single_filter;
+} can_filter_config_t;
+
+typedef struct {
+	union {
+		struct {
+			uint32_t extd: 1;
+			uint32_t rtr: 1;
+			uint32_t ss: 1;
+			uint32_t self: 1;
+			uint32_t dlc_non_comp: 1;
+			uint32_t reserved: 27;
+		};
+		uint32_t flags;
+	};
+	uint32_t identifier;
+	uint8_t data_length_code;
+	uint8_t data[ 8 ];
+} can_message_t;
+
+typedef struct {
+	can_state_t state;
+	uint32_t msgs_to_tx;
+	uint32_t msgs_to_rx;
+	uint32_t tx_error_counter;
+	uint32_t rx_error_counter;
+	uint32_t tx_failed_count;
+	uint32_t rx_missed_count;
+	uint32_t arb_lost_count;
+	uint32_t bus_error_count;
+} can_status_info_t;
+
+#define CAN_EXTD_ID_MASK						0x1FFFFFFF
+#define CAN_STD_ID_MASK							0x7FF
+#define CAN_MSG_FLAG_EXTD						0x01
+#define CAN_MSG_FLAG_RTR						0x02
+
+#define CAN_ALERT_TX_IDLE						0x00000001
+#define CAN_ALERT_TX_SUCCESS					0x00000002
+#define CAN_ALERT_RX_DATA						0x00000004
+#define CAN_ALERT_BELOW_ERR_WARN				0x00000008
+#define CAN_ALERT_ERR_ACTIVE					0x00000010
+#define CAN_ALERT_RECOVERY_IN_PROGRESS			0x00000020
+#define CAN_ALERT_BUS_RECOVERED					0x00000040
+#define CAN_ALERT_ARB_LOST						0x00000080
+#define CAN_ALERT_ABOVE_ERR_WARN				0x00000100
+#define CAN_ALERT_BUS_ERROR						0x00000200
+#define CAN_ALERT_TX_FAILED						0x00000400
+#define CAN_ALERT_RX_QUEUE_FULL					0x00000800
+#define CAN_ALERT_ERR_PASS						0x00001000
+#define CAN_ALERT_BUS_OFF						0x00002000
+#define CAN_ALERT_ALL							0x00003FFF
+#define CAN_ALERT_NONE							0x00000000
+
+#define CAN_GENERAL_CONFIG_DEFAULT(tx_io_num, rx_io_num, op_mode) { .mode = op_mode, .tx_io = tx_io_num, .rx_io = rx_io_num, \
+	.clkout_io = GPIO_NUM_NC, .bus_off_io = GPIO_NUM_NC, .tx_queue_len = 5, .rx_queue_len = 5, \
+	.alerts_enabled = CAN_ALERT_NONE, .clkout_divider = 0, .intr_flags = ESP_INTR_FLAG_LEVEL1 }
+
+#define CAN_TIMING_CONFIG_25KBITS()				{ .brp = 128, .tseg_1 = 16, .tseg_2 = 8, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_50KBITS()				{ .brp = 80, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_100KBITS()			{ .brp = 40, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_125KBITS()			{ .brp = 32, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_250KBITS()			{ .brp = 16, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_500KBITS()			{ .brp = 8, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_800KBITS()			{ .brp = 4, .tseg_1 = 16, .tseg_2 = 8, .sjw = 3, .triple_sampling = false }
+#define CAN_TIMING_CONFIG_1MBITS()				{ .brp = 4, .tseg_1 = 15, .tseg_2 = 4, .sjw = 3, .triple_sampling = false }
+
+#define CAN_FILTER_CONFIG_ACCEPT_ALL()			{ .acceptance_code = 0, .acceptance_mask = 0xFFFFFFFF, .single_filter = true }
+
+esp_err_t can_driver_install(const can_general_config_t* g_config, const can_timing_config_t* t_config, const can_filter_config_t* f_config);
+esp_err_t can_driver_uninstall(void);
+esp_err_t can_start(void);
+esp_err_t can_stop(void);
+esp_err_t can_transmit(const can_message_t* message, TickType_t ticks_to_wait);
+esp_err_t can_receive(can_message_t* message, TickType_t ticks_to_wait);
+esp_err_t can_read_alerts(uint32_t* alerts, TickType_t ticks_to_wait);
+esp_err_t can_reconfigure_alerts(uint32_t alerts_enabled, uint32_t* current_alerts);
+esp_err_t can_initiate_recovery(void);
+esp_err_t can_get_status_info(can_status_info_t* status_info);
+
+#endif /* __HOST_DRIVER_CAN_H__ */
@@ -0,0 +1,9 @@
+#ifndef __HOST_ESP_OTA_OPS_H__
+#define __HOST_ESP_OTA_OPS_H__
+
+#include "esp_partition.h"
+
+// image of running firmware is set by host::setRunningImage
+const esp_partition_t* esp_ota_get_running_partition(void);
+
+#endif /* __HOST_ESP_OTA_OPS_H__ */
@@ -0,0 +1,14 @@
+#ifndef __HOST_ESP_PARTITION_H__
+#define __HOST_ESP_PARTITION_H__
+
+#include "esp_wifi.h"
+
+typedef struct {
+	uint32_t address;
+	uint32_t size;
+	char label[ 17 ];
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size);
+
+#endif /* __HOST_ESP_PARTITION_H__ */
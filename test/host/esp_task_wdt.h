@@ -0,0 +1,10 @@
+#ifndef __HOST_ESP_TASK_WDT_H__
+#define __HOST_ESP_TASK_WDT_H__
+
+#include "esp_wifi.h"
+
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic);
+esp_err_t esp_task_wdt_add(TaskHandle_t task);
+esp_err_t esp_task_wdt_reset(void);
+
+#endif /* __HOST_ESP_TASK_WDT_H__ */
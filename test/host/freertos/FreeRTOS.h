@@ -0,0 +1,21 @@
+#ifndef __HOST_FREERTOS_H__
+#define __HOST_FREERTOS_H__
+
+//-------------------------------------------------------------------------------
+// Host stand-in of FreeRTOS types used by esp_functions.cpp, tick is 1 ms
+//-------------------------------------------------------------------------------
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE									1
+#define pdFALSE									0
+#define pdPASS									1
+#define portMAX_DELAY							0xFFFFFFFF
+#define pdMS_TO_TICKS(ms)						((TickType_t)(ms))
+
+#endif /* __HOST_FREERTOS_H__ */
@@ -0,0 +1,364 @@
+//-------------------------------------------------------------------------------
+// Directory-backed FS with power loss injection
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include "SPIFFS.h"
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mutex>
+
+fs::SPIFFSFS SPIFFS;
+
+namespace fs {
+	struct FileImpl{
+		FILE* fp = nullptr;
+		std::string path;
+		std::string name;
+		bool dir = false;
+		std::vector<std::string> entries;
+		size_t next = 0;
+		~FileImpl(void) { if( fp != nullptr ) fclose( fp ); }
+	};
+}
+
+namespace host {
+	static std::recursive_mutex fsMutex;
+	static std::string root;
+	static int64_t fsBudget = -1;						// bytes left before power loss, -1 - off
+	static bool fsLost = false;
+	static size_t fsLimit = 0;							// 0 - capacity is not enforced
+	static FsStats stats = { 0, 0, 0 };
+
+	//-------------------------------------------------------------------------------
+	static int removeEntry(const char* path, const struct stat* st, int flag, struct FTW* ftw)
+	{
+		return ::remove( path );
+	}
+
+	//-------------------------------------------------------------------------------
+	static void removeRoot(void)
+	{
+		if( !host::root.empty() ) nftw( host::root.c_str(), host::removeEntry, 16, FTW_DEPTH | FTW_PHYS );
+	}
+
+	//-------------------------------------------------------------------------------
+	const char* fsRoot(void)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		if( host::root.empty() ){
+			char buff[ 64 ];
+			snprintf( buff, sizeof( buff ), "/tmp/esp_host_fs_%d", (int)getpid() );
+			host::root = buff;
+			host::removeRoot();
+			::mkdir( buff, 0755 );
+			atexit( host::removeRoot );
+		}
+		return host::root.c_str();
+	}
+
+	//-------------------------------------------------------------------------------
+	static std::string hostPath(const char* path)
+	{
+		std::string res = host::fsRoot();
+		if( path[ 0 ] != '/' ) res += '/';
+		return res + path;
+	}
+
+	//-------------------------------------------------------------------------------
+	void fsClear(void)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		host::removeRoot();
+		::mkdir( host::fsRoot(), 0755 );
+	}
+
+	//-------------------------------------------------------------------------------
+	void fsFailAfter(const int64_t bytes)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		host::fsBudget = bytes;
+		host::fsLost = false;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool fsFailed(void)
+	{
+		return host::fsLost;
+	}
+
+	//-------------------------------------------------------------------------------
+	void fsCapacity(const size_t bytes)
+	{
+		host::fsLimit = bytes;
+	}
+
+	//-------------------------------------------------------------------------------
+	FsStats fsStats(void)
+	{
+		return host::stats;
+	}
+
+	//-------------------------------------------------------------------------------
+	void fsResetStats(void)
+	{
+		host::stats = { 0, 0, 0 };
+	}
+
+	//-------------------------------------------------------------------------------
+	static size_t fsUsed(void)
+	{
+		size_t used = 0;
+		DIR* dir = opendir( host::fsRoot() );
+		if( dir == nullptr ) return 0;
+		while( struct dirent* entry = readdir( dir ) ){
+			struct stat st;
+			if( stat( ( host::root + "/" + entry->d_name ).c_str(), &st ) == 0 && S_ISREG( st.st_mode ) ) used += st.st_size;
+		}
+		closedir( dir );
+		return used;
+	}
+}
+
+namespace fs {
+	//-------------------------------------------------------------------------------
+	size_t File::write(const uint8_t* data, size_t len)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		if( !impl || impl->fp == nullptr || host::fsLost ) return 0;
+
+		size_t size = len;
+		if( host::fsLimit ){
+			size_t used = host::fsUsed();
+			size = ( used >= host::fsLimit ) ? 0 : std::min( size, host::fsLimit - used );
+		}
+		if( host::fsBudget >= 0 && (int64_t)size >= host::fsBudget ){
+			size = host::fsBudget;
+			host::fsLost = true;
+		}
+		if( host::fsBudget >= 0 ) host::fsBudget -= size;
+		size = fwrite( data, 1, size, impl->fp );
+		fflush( impl->fp );
+		host::stats.bytesWritten += size;
+		host::stats.writes++;
+		return size;
+	}
+
+	//-------------------------------------------------------------------------------
+	int File::available(void)
+	{
+		return ( impl && impl->fp != nullptr ) ? size() - position() : 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	int File::read(void)
+	{
+		uint8_t c;
+		return ( read( &c, 1 ) == 1 ) ? c : -1;
+	}
+
+	//-------------------------------------------------------------------------------
+	int File::peek(void)
+	{
+		if( !impl || impl->fp == nullptr ) return -1;
+		int c = fgetc( impl->fp );
+		if( c != EOF ) ungetc( c, impl->fp );
+		return ( c == EOF ) ? -1 : c;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t File::read(uint8_t* buff, size_t len)
+	{
+		if( !impl || impl->fp == nullptr ) return 0;
+		return fread( buff, 1, len, impl->fp );
+	}
+
+	//-------------------------------------------------------------------------------
+	void File::flush(void)
+	{
+		if( impl && impl->fp != nullptr ) fflush( impl->fp );
+	}
+
+	//-------------------------------------------------------------------------------
+	bool File::seek(uint32_t pos, SeekMode mode)
+	{
+		if( !impl || impl->fp == nullptr ) return false;
+		int whence = ( mode == SeekSet ) ? SEEK_SET : ( mode == SeekCur ) ? SEEK_CUR : SEEK_END;
+		if( mode == SeekSet && pos > size() ) return false;
+		return fseek( impl->fp, pos, whence ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t File::position(void) const
+	{
+		return ( impl && impl->fp != nullptr ) ? ftell( impl->fp ) : 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t File::size(void) const
+	{
+		if( !impl || impl->fp == nullptr ) return 0;
+		struct stat st;
+		return ( fstat( fileno( impl->fp ), &st ) == 0 ) ? st.st_size : 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	void File::close(void)
+	{
+		if( !impl ) return;
+		if( impl->fp != nullptr ) fclose( impl->fp );
+		impl->fp = nullptr;
+		impl->dir = false;
+		impl.reset();
+	}
+
+	//-------------------------------------------------------------------------------
+	time_t File::getLastWrite(void)
+	{
+		if( !impl || impl->fp == nullptr ) return 0;
+		struct stat st;
+		return ( fstat( fileno( impl->fp ), &st ) == 0 ) ? st.st_mtime : 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	const char* File::path(void) const
+	{
+		return ( impl ) ? impl->path.c_str() : nullptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	const char* File::name(void) const
+	{
+		return ( impl ) ? impl->name.c_str() : nullptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool File::isDirectory(void) const
+	{
+		return impl && impl->dir;
+	}
+
+	//-------------------------------------------------------------------------------
+	File File::openNextFile(const char* mode)
+	{
+		if( !impl || !impl->dir ) return File();
+		while( impl->next < impl->entries.size() ){
+			std::string path = impl->path;
+			if( path.back() != '/' ) path += '/';
+			path += impl->entries[ impl->next++ ];
+			File f = SPIFFS.open( path.c_str(), mode );
+			if( f ) return f;
+		}
+		return File();
+	}
+
+	//-------------------------------------------------------------------------------
+	File::operator bool(void) const
+	{
+		return impl && ( impl->fp != nullptr || impl->dir );
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel)
+	{
+		host::fsRoot();
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::format(void)
+	{
+		if( host::fsLost ) return false;
+		host::fsClear();
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t FS::totalBytes(void)
+	{
+		return ( host::fsLimit ) ? host::fsLimit : 1441792;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t FS::usedBytes(void)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		return host::fsUsed();
+	}
+
+	//-------------------------------------------------------------------------------
+	File FS::open(const char* path, const char* mode, const bool create)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		std::string full = host::hostPath( path );
+		bool writing = strchr( mode, 'w' ) != nullptr || strchr( mode, 'a' ) != nullptr || strchr( mode, '+' ) != nullptr;
+		if( writing && host::fsLost ) return File();
+
+		auto impl = std::make_shared<FileImpl>();
+		impl->path = path;
+		const char* slash = strrchr( path, '/' );
+		impl->name = ( slash != nullptr ) ? slash + 1 : path;
+
+		struct stat st;
+		if( stat( full.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) ){
+			if( writing ) return File();
+			impl->dir = true;
+			DIR* dir = opendir( full.c_str() );
+			while( dir != nullptr ){
+				struct dirent* entry = readdir( dir );
+				if( entry == nullptr ) break;
+				if( strcmp( entry->d_name, "." ) != 0 && strcmp( entry->d_name, ".." ) != 0 ) impl->entries.push_back( entry->d_name );
+			}
+			if( dir != nullptr ) closedir( dir );
+			std::sort( impl->entries.begin(), impl->entries.end() );
+			return File( impl );
+		}
+
+		// "a" of C stdio writes at end regardless of seek, SPIFFS too
+		const char* hostMode = ( mode[ 0 ] == 'w' ) ? ( strchr( mode, '+' ) ? "w+b" : "wb" )
+			: ( mode[ 0 ] == 'a' ) ? ( strchr( mode, '+' ) ? "a+b" : "ab" )
+			: ( strchr( mode, '+' ) ? "r+b" : "rb" );
+		impl->fp = fopen( full.c_str(), hostMode );
+		if( impl->fp == nullptr ) return File();
+		if( mode[ 0 ] == 'a' ) fseek( impl->fp, 0, SEEK_END );
+		host::stats.opens++;
+		return File( impl );
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::exists(const char* path)
+	{
+		struct stat st;
+		return stat( host::hostPath( path ).c_str(), &st ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::remove(const char* path)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		if( host::fsLost ) return false;
+		return ::unlink( host::hostPath( path ).c_str() ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Fails if target exists, like SPIFFS
+	bool FS::rename(const char* from, const char* to)
+	{
+		std::lock_guard<std::recursive_mutex> lock( host::fsMutex );
+		if( host::fsLost || exists( to ) || !exists( from ) ) return false;
+		return ::rename( host::hostPath( from ).c_str(), host::hostPath( to ).c_str() ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::mkdir(const char* path)
+	{
+		return ::mkdir( host::hostPath( path ).c_str(), 0755 ) == 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool FS::rmdir(const char* path)
+	{
+		return ::rmdir( host::hostPath( path ).c_str() ) == 0;
+	}
+}
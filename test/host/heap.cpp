@@ -0,0 +1,87 @@
+//-------------------------------------------------------------------------------
+// Heap use of whole process for ESP.getFreeHeap() and host::heapPeak() (glibc)
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include <malloc.h>
+#include <atomic>
+
+extern "C" {
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+	void* __libc_memalign(size_t align, size_t size);
+	void __libc_free(void* ptr);
+}
+
+#define HOST_HEAP_SIZE							( 320 * 1024 )		// ESP32 DRAM heap at boot
+
+namespace host {
+	static std::atomic<size_t> used( 0 );
+	static std::atomic<size_t> peak( 0 );
+
+	//-------------------------------------------------------------------------------
+	static inline void* track(void* ptr)
+	{
+		if( ptr == nullptr ) return ptr;
+		size_t now = host::used += malloc_usable_size( ptr );
+		size_t max = host::peak;
+		while( now > max && !host::peak.compare_exchange_weak( max, now ) );
+		return ptr;
+	}
+
+	//-------------------------------------------------------------------------------
+	static inline void untrack(void* ptr)
+	{
+		if( ptr != nullptr ) host::used -= malloc_usable_size( ptr );
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t heapUsed(void)
+	{
+		return host::used;
+	}
+
+	//-------------------------------------------------------------------------------
+	size_t heapPeak(void)
+	{
+		return host::peak;
+	}
+
+	//-------------------------------------------------------------------------------
+	void heapResetPeak(void)
+	{
+		host::peak = host::used.load();
+	}
+}
+
+//-------------------------------------------------------------------------------
+uint32_t EspClass::getFreeHeap(void)
+{
+	size_t used = host::heapUsed();
+	return ( used < HOST_HEAP_SIZE ) ? HOST_HEAP_SIZE - used : 0;
+}
+
+extern "C" {
+	void* malloc(size_t size) { return host::track( __libc_malloc( size ) ); }
+	void* calloc(size_t count, size_t size) { return host::track( __libc_calloc( count, size ) ); }
+	void free(void* ptr) { host::untrack( ptr ); __libc_free( ptr ); }
+	void* memalign(size_t align, size_t size) { return host::track( __libc_memalign( align, size ) ); }
+	void* aligned_alloc(size_t align, size_t size) { return host::track( __libc_memalign( align, size ) ); }
+
+	//-------------------------------------------------------------------------------
+	void* realloc(void* ptr, size_t size)
+	{
+		size_t old = ( ptr != nullptr ) ? malloc_usable_size( ptr ) : 0;
+		void* res = __libc_realloc( ptr, size );
+		if( res == nullptr && size > 0 ) return res;
+		host::used -= old;
+		return host::track( res );
+	}
+
+	//-------------------------------------------------------------------------------
+	int posix_memalign(void** res, size_t align, size_t size)
+	{
+		*res = host::track( __libc_memalign( align, size ) );
+		return ( *res != nullptr || size == 0 ) ? 0 : 12;
+	}
+}
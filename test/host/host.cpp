@@ -0,0 +1,217 @@
+//-------------------------------------------------------------------------------
+// Arduino core, time and device of host build
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include "Ticker.h"
+#include "esp_task_wdt.h"
+#include "esp_ota_ops.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace host {
+	static std::atomic<uint64_t> timeOffset( 0 );		// us added by delay() and host::advance()
+	static std::atomic<uint32_t> restartCount( 0 );
+	static RESET_REASON reason = POWERON_RESET;
+	static std::vector<uint8_t> runningImage;
+	static esp_partition_t runningPartition = { 0x10000, 0, "app0" };
+	static std::mutex tickerMutex;
+	static std::vector<Ticker*> tickers;
+
+	//-------------------------------------------------------------------------------
+	static uint64_t nowUs(void)
+	{
+		static const auto start = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count() + host::timeOffset.load();
+	}
+
+	//-------------------------------------------------------------------------------
+	// Tickers are fired by virtual clock moves only, like callbacks of timer task between loop() calls
+	static void runTickers(void)
+	{
+		std::vector<Ticker*> due;
+		{
+			std::lock_guard<std::mutex> lock( host::tickerMutex );
+			due = host::tickers;
+		}
+		uint32_t now = millis();
+		for( Ticker* ticker : due ) ticker->fire( now );
+	}
+
+	//-------------------------------------------------------------------------------
+	void advance(const uint32_t ms)
+	{
+		host::timeOffset += (uint64_t)ms * 1000;
+		host::runTickers();
+	}
+
+	//-------------------------------------------------------------------------------
+	void resetReason(const RESET_REASON reason)
+	{
+		host::reason = reason;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t restarts(void)
+	{
+		return host::restartCount;
+	}
+
+	//-------------------------------------------------------------------------------
+	void setRunningImage(const std::vector<uint8_t> &image)
+	{
+		host::runningImage = image;
+		host::runningPartition.size = image.size();
+	}
+}
+
+//-------------------------------------------------------------------------------
+uint32_t millis(void)
+{
+	return host::nowUs() / 1000;
+}
+
+//-------------------------------------------------------------------------------
+uint32_t micros(void)
+{
+	return host::nowUs();
+}
+
+//-------------------------------------------------------------------------------
+void delay(uint32_t ms)
+{
+	host::advance( ms );
+}
+
+//-------------------------------------------------------------------------------
+void yield(void)
+{
+}
+
+//-------------------------------------------------------------------------------
+uint32_t esp_random(void)
+{
+	static thread_local std::mt19937 gen( 12345 );
+	return gen();
+}
+
+//-------------------------------------------------------------------------------
+bool psramFound(void)
+{
+	return false;
+}
+
+//-------------------------------------------------------------------------------
+void* ps_malloc(size_t size)
+{
+	return malloc( size );
+}
+
+//-------------------------------------------------------------------------------
+static char* formatNumber(char* str, unsigned long value, const bool negative, const int base)
+{
+	char buff[ 34 ];
+	int pos = 0;
+	do{
+		int digit = value % base;
+		buff[ pos++ ] = ( digit < 10 ) ? '0' + digit : 'a' + digit - 10;
+		value /= base;
+	}while( value );
+
+	char* out = str;
+	if( negative ) *out++ = '-';
+	while( pos ) *out++ = buff[ --pos ];
+	*out = '\0';
+	return str;
+}
+
+char* itoa(int value, char* str, int base) { return formatNumber( str, ( value < 0 && base == 10 ) ? -(long)value : (unsigned int)value, value < 0 && base == 10, base ); }
+char* utoa(unsigned int value, char* str, int base) { return formatNumber( str, value, false, base ); }
+char* ltoa(long value, char* str, int base) { return formatNumber( str, ( value < 0 && base == 10 ) ? -(unsigned long)value : (unsigned long)value, value < 0 && base == 10, base ); }
+char* ultoa(unsigned long value, char* str, int base) { return formatNumber( str, value, false, base ); }
+
+//-------------------------------------------------------------------------------
+size_t Print::printf_P(PGM_P format, ...)
+{
+	char buff[ 256 ];
+	va_list args;
+	va_start( args, format );
+	int len = vsnprintf( buff, sizeof( buff ), format, args );
+	va_end( args );
+	return ( len > 0 ) ? write( (const uint8_t*)buff, std::min( (size_t)len, sizeof( buff ) - 1 ) ) : 0;
+}
+
+//-------------------------------------------------------------------------------
+void EspClass::restart(void)
+{
+	host::restartCount++;
+}
+
+//-------------------------------------------------------------------------------
+void Ticker::once_ms(uint32_t ms, callback_function_t callback)
+{
+	detach();
+	this->callback = callback;
+	due = millis() + ms;
+	armed = true;
+	std::lock_guard<std::mutex> lock( host::tickerMutex );
+	host::tickers.push_back( this );
+}
+
+//-------------------------------------------------------------------------------
+void Ticker::detach(void)
+{
+	armed = false;
+	std::lock_guard<std::mutex> lock( host::tickerMutex );
+	host::tickers.erase( std::remove( host::tickers.begin(), host::tickers.end(), this ), host::tickers.end() );
+}
+
+//-------------------------------------------------------------------------------
+void Ticker::fire(const uint32_t now)
+{
+	if( !armed || (int32_t)( now - due ) < 0 ) return;
+	detach();
+	if( callback ) callback();
+}
+
+//-------------------------------------------------------------------------------
+RESET_REASON rtc_get_reset_reason(int cpu)
+{
+	return host::reason;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic) { return ESP_OK; }
+esp_err_t esp_task_wdt_add(TaskHandle_t task) { return ESP_OK; }
+esp_err_t esp_task_wdt_reset(void) { return ESP_OK; }
+
+//-------------------------------------------------------------------------------
+const esp_partition_t* esp_ota_get_running_partition(void)
+{
+	return &host::runningPartition;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size)
+{
+	if( partition != &host::runningPartition || offset + size > host::runningImage.size() ) return ESP_ERR_INVALID_ARG;
+	memcpy( dst, host::runningImage.data() + offset, size );
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char* name, uint32_t stack, void* param, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core)
+{
+	static int task = 0;
+	if( handle != nullptr ) *handle = &task;
+	return pdPASS;
+}
+
+//-------------------------------------------------------------------------------
+void vTaskDelete(TaskHandle_t task)
+{
+}
@@ -0,0 +1,119 @@
+#ifndef __HOST_HOST_H__
+#define __HOST_HOST_H__
+
+//-------------------------------------------------------------------------------
+// Control of simulated device for tests and benchmarks
+//-------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "SPIFFS.h"
+#include "WebServer.h"
+#include "HTTPClient.h"
+#include "Update.h"
+#include "esp_wifi.h"
+#include "driver/can.h"
+#include "rom/rtc.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace host {
+	//-------------------------------------------------------------------------------
+	// Time
+	void advance(const uint32_t ms);				// moves virtual clock, runs due Tickers
+
+	//-------------------------------------------------------------------------------
+	// Device
+	void resetReason(const RESET_REASON reason);
+	uint32_t restarts(void);						// ESP.restart() calls, device keeps running
+	void setRunningImage(const std::vector<uint8_t> &image);
+
+	//-------------------------------------------------------------------------------
+	// Heap, all allocations of process
+	size_t heapUsed(void);
+	size_t heapPeak(void);
+	void heapResetPeak(void);
+
+	//-------------------------------------------------------------------------------
+	// Filesystem, directory of host::fsRoot() is removed at first use and at exit
+	const char* fsRoot(void);
+	void fsClear(void);
+	void fsFailAfter(const int64_t bytes);			// writes stop after bytes (power loss), -1 - off
+	bool fsFailed(void);
+	void fsCapacity(const size_t bytes);			// writes stop when FS is full, 0 - off
+	struct FsStats{
+		uint64_t bytesWritten;
+		uint32_t writes;
+		uint32_t opens;
+	};
+	FsStats fsStats(void);
+	void fsResetStats(void);
+
+	//-------------------------------------------------------------------------------
+	// HTTP resources served to HTTPClient
+	struct HttpResource{
+		int code = 200;								// 200 - Range requests are served too
+		std::string body;
+		String etag;
+		String lastModified;
+		bool ranges = true;							// Accept-Ranges
+		uint32_t dropMax = 0;						// >0 - connection is cut after random 1..dropMax bytes
+	};
+	void httpServe(const String &url, const HttpResource &resource);
+	void httpRemove(const String &url);
+	void httpClear(void);
+	void httpFailNext(const int error, const uint32_t count = 1);	// transport error (HTTPC_ERROR_*) for next requests
+	struct HttpRequest{
+		String method;
+		String url;
+		HostParams headers;
+		int code;
+	};
+	const std::vector<HttpRequest>& httpLog(void);
+	void httpClearLog(void);
+
+	//-------------------------------------------------------------------------------
+	// Update manifest signing (sodium.cpp, targets with ESP_UPDATE_PUBLIC_KEY only), returns hex signature
+	std::string ed25519Sign(const uint8_t* seed, const std::string &message);
+
+	//-------------------------------------------------------------------------------
+	// Wi-Fi
+	struct Network{
+		String ssid;
+		String key;
+		uint8_t bssid[ 6 ];
+		int32_t channel;
+		int32_t rssi;
+		wifi_auth_mode_t auth;
+	};
+	void wifiNetworks(const std::vector<Network> &networks);
+	void wifiTimes(const uint32_t scanMs, const uint32_t connectMs);
+	void wifiDrop(void);							// connected STA loses AP
+	uint32_t wifiBegins(void);
+	uint8_t wifiChannel(void);
+	bool promiscEnabled(void);
+	uint32_t promiscFilter(void);
+	void promiscFeed(const uint8_t* frame, const size_t len, const int8_t rssi, const wifi_promiscuous_pkt_type_t type);
+
+	//-------------------------------------------------------------------------------
+	// pcap captures (LINKTYPE_IEEE802_11 and radiotap with dBm antenna signal)
+	struct PcapFrame{
+		uint32_t time;								// ms from first frame
+		int8_t rssi;
+		std::string data;							// 802.11 frame without FCS
+	};
+	bool pcapWrite(const std::string &path, const std::vector<PcapFrame> &frames);
+	bool pcapRead(const std::string &path, std::vector<PcapFrame> &frames);
+	void pcapReplay(const std::vector<PcapFrame> &frames, const std::function<void(void)> &each);	// promiscFeed() on virtual clock, each - after every frame
+
+	//-------------------------------------------------------------------------------
+	// CAN bus
+	void canInject(const can_message_t &msg);
+	std::vector<can_message_t> canSent(void);
+	void canAlerts(const uint32_t alerts);
+	bool canInstalled(void);
+	can_filter_config_t canFilter(void);
+	can_timing_config_t canTiming(void);
+	uint32_t canInstalls(void);
+}
+
+#endif /* __HOST_HOST_H__ */
@@ -0,0 +1,220 @@
+//-------------------------------------------------------------------------------
+// Local HTTP stand-in: resources are served from memory with Range / If-Range support
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace host {
+	static std::mutex httpMutex;
+	struct Served{
+		HttpResource resource;
+		std::shared_ptr<const std::string> shared;		// body, streams keep it while resource is replaced
+	};
+	static std::map<std::string, Served> resources;
+	static std::vector<HttpRequest> requests;
+	static int failError = 0;
+	static uint32_t failCount = 0;
+	static std::mt19937 dropRandom( 1 );
+
+	//-------------------------------------------------------------------------------
+	void httpServe(const String &url, const HttpResource &resource)
+	{
+		std::lock_guard<std::mutex> lock( host::httpMutex );
+		Served &served = host::resources[ url.str() ];
+		served.resource = resource;
+		served.shared = std::make_shared<const std::string>( std::move( served.resource.body ) );
+	}
+
+	//-------------------------------------------------------------------------------
+	void httpRemove(const String &url)
+	{
+		std::lock_guard<std::mutex> lock( host::httpMutex );
+		host::resources.erase( url.str() );
+	}
+
+	//-------------------------------------------------------------------------------
+	void httpClear(void)
+	{
+		std::lock_guard<std::mutex> lock( host::httpMutex );
+		host::resources.clear();
+		host::failCount = 0;
+	}
+
+	//-------------------------------------------------------------------------------
+	void httpFailNext(const int error, const uint32_t count)
+	{
+		std::lock_guard<std::mutex> lock( host::httpMutex );
+		host::failError = error;
+		host::failCount = count;
+	}
+
+	//-------------------------------------------------------------------------------
+	const std::vector<HttpRequest>& httpLog(void)
+	{
+		return host::requests;
+	}
+
+	//-------------------------------------------------------------------------------
+	void httpClearLog(void)
+	{
+		std::lock_guard<std::mutex> lock( host::httpMutex );
+		host::requests.clear();
+	}
+}
+
+//-------------------------------------------------------------------------------
+int HostHttpStream::available(void)
+{
+	// network delivers body by TCP segments
+	return ( pos < end() ) ? std::min( end() - pos, (size_t)1460 ) : 0;
+}
+
+//-------------------------------------------------------------------------------
+int HostHttpStream::read(void)
+{
+	return ( pos < end() ) ? (uint8_t)(*body)[ pos++ ] : -1;
+}
+
+//-------------------------------------------------------------------------------
+int HostHttpStream::read(uint8_t* buff, size_t len)
+{
+	size_t size = std::min( len, (size_t)available() );
+	memcpy( buff, body->data() + pos, size );
+	pos += size;
+	return size;
+}
+
+//-------------------------------------------------------------------------------
+void HTTPClient::end(void)
+{
+	stream.reset();
+	requestHeaders.clear();
+	responseHeaders.clear();
+	size = -1;
+}
+
+//-------------------------------------------------------------------------------
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t count)
+{
+	collected.clear();
+	for( size_t i = 0; i < count; i++ ) collected.push_back( headerKeys[ i ] );
+}
+
+//-------------------------------------------------------------------------------
+// Only collected headers are kept by client
+String HTTPClient::header(const char* name)
+{
+	for( const String &key : collected ){
+		if( strcasecmp( key.c_str(), name ) != 0 ) continue;
+		for( const auto &header : responseHeaders ){
+			if( strcasecmp( header.first.c_str(), name ) == 0 ) return header.second;
+		}
+	}
+	return String();
+}
+
+//-------------------------------------------------------------------------------
+bool HTTPClient::hasHeader(const char* name)
+{
+	return header( name ).length() > 0;
+}
+
+//-------------------------------------------------------------------------------
+String HTTPClient::getString(void)
+{
+	std::string res;
+	if( stream ){
+		int c;
+		while( ( c = stream->read() ) >= 0 ) res += (char)c;
+	}
+	return String( res );
+}
+
+//-------------------------------------------------------------------------------
+String HTTPClient::errorToString(int error)
+{
+	switch( error ){
+		case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+		case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+		case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+		case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+		case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+		case HTTPC_ERROR_NO_STREAM: return "no stream";
+		case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+		case HTTPC_ERROR_TOO_LESS_RAM: return "too less ram";
+		case HTTPC_ERROR_ENCODING: return "Transfer-Encoding not supported";
+		case HTTPC_ERROR_STREAM_WRITE: return "Stream write error";
+		case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+		default: return String();
+	}
+}
+
+//-------------------------------------------------------------------------------
+static const String* requestHeader(const std::vector<std::pair<String, String>> &headers, const char* name)
+{
+	for( const auto &header : headers ){
+		if( strcasecmp( header.first.c_str(), name ) == 0 ) return &header.second;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------
+int HTTPClient::sendRequest(const char* method, const String &payload)
+{
+	std::lock_guard<std::mutex> lock( host::httpMutex );
+	stream.reset();
+	responseHeaders.clear();
+	size = -1;
+
+	int code;
+	std::shared_ptr<const std::string> body;
+	size_t start = 0;
+	uint32_t dropMax = 0;
+	auto it = host::resources.find( url.str() );
+	if( host::failCount > 0 ){
+		host::failCount--;
+		code = host::failError;
+	}else if( it == host::resources.end() ){
+		code = HTTP_CODE_NOT_FOUND;
+		body = std::make_shared<const std::string>( "Not Found" );
+	}else{
+		const host::HttpResource &res = it->second.resource;
+		code = res.code;
+		body = it->second.shared;
+		dropMax = res.dropMax;
+		if( res.etag.length() ) responseHeaders.push_back( { "ETag", res.etag } );
+		if( res.lastModified.length() ) responseHeaders.push_back( { "Last-Modified", res.lastModified } );
+
+		const String* range = requestHeader( requestHeaders, "Range" );
+		const String* ifRange = requestHeader( requestHeaders, "If-Range" );
+		// If-Range with other validator - whole new file
+		bool useRange = code == HTTP_CODE_OK && res.ranges && range != nullptr && range->startsWith( "bytes=" )
+			&& ( ifRange == nullptr || *ifRange == res.etag || *ifRange == res.lastModified );
+		if( res.ranges ) responseHeaders.push_back( { "Accept-Ranges", "bytes" } );
+		if( useRange ){
+			size_t from = strtoul( range->c_str() + 6, nullptr, 10 );
+			char contentRange[ 48 ];
+			if( from >= body->size() ){
+				snprintf( contentRange, sizeof( contentRange ), "bytes */%lu", (unsigned long)body->size() );
+				code = HTTP_CODE_RANGE_NOT_SATISFIABLE;
+				body = std::make_shared<const std::string>();
+			}else{
+				snprintf( contentRange, sizeof( contentRange ), "bytes %lu-%lu/%lu", (unsigned long)from, (unsigned long)body->size() - 1, (unsigned long)body->size() );
+				code = HTTP_CODE_PARTIAL_CONTENT;
+				start = from;
+			}
+			responseHeaders.push_back( { "Content-Range", contentRange } );
+		}
+	}
+	host::requests.push_back( { method, url, requestHeaders, code } );
+	if( code < 0 ) return code;
+
+	size = body->size() - start;
+	size_t dropAt = size;
+	if( dropMax > 0 ) dropAt = std::uniform_int_distribution<uint32_t>( 1, dropMax )( host::dropRandom );
+	stream.reset( new HostHttpStream( body, start, dropAt ) );
+
+	return code;
+}
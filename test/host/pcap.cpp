@@ -0,0 +1,142 @@
+//-------------------------------------------------------------------------------
+// pcap files of 802.11 captures, replayed through promiscuous callback
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include <stdio.h>
+
+#define PCAP_MAGIC_US						0xA1B2C3D4
+#define PCAP_MAGIC_NS						0xA1B23C4D
+#define PCAP_LINKTYPE_IEEE802_11			105
+#define PCAP_LINKTYPE_RADIOTAP				127
+#define RADIOTAP_FLAGS_FCS					0x10
+
+namespace host {
+	//-------------------------------------------------------------------------------
+	static uint32_t swap32(const uint32_t x)
+	{
+		return ( x >> 24 ) | ( ( x >> 8 ) & 0xFF00 ) | ( ( x << 8 ) & 0xFF0000 ) | ( x << 24 );
+	}
+
+	//-------------------------------------------------------------------------------
+	static void put32(std::string &out, const uint32_t x)
+	{
+		out.append( (const char*)&x, sizeof( x ) );
+	}
+
+	//-------------------------------------------------------------------------------
+	// Radiotap header: present fields up to dBm antenna signal (bit 5), alignment is relative to header start
+	static bool radiotapParse(const uint8_t* data, const size_t len, size_t &header, int8_t &rssi, bool &fcs)
+	{
+		static const uint8_t sizes[ 6 ] = { 8, 1, 1, 4, 2, 1 };
+		static const uint8_t aligns[ 6 ] = { 8, 1, 1, 2, 1, 1 };
+		if( len < 8 || data[ 0 ] != 0 ) return false;
+		header = data[ 2 ] | ( data[ 3 ] << 8 );
+		if( header > len ) return false;
+
+		uint32_t present = data[ 4 ] | ( data[ 5 ] << 8 ) | ( data[ 6 ] << 16 ) | ( (uint32_t)data[ 7 ] << 24 );
+		size_t pos = 8;
+		// extended present words
+		for( uint32_t p = present; ( p & 0x80000000 ) && pos + 4 <= header; pos += 4 ){
+			p = data[ pos ] | ( data[ pos + 1 ] << 8 ) | ( data[ pos + 2 ] << 16 ) | ( (uint32_t)data[ pos + 3 ] << 24 );
+		}
+		rssi = 0;
+		fcs = false;
+		for( uint8_t bit = 0; bit < 6; bit++ ){
+			if( !( present & ( 1UL << bit ) ) ) continue;
+			pos = ( pos + aligns[ bit ] - 1 ) & ~(size_t)( aligns[ bit ] - 1 );
+			if( pos + sizes[ bit ] > header ) return false;
+			if( bit == 1 ) fcs = ( data[ pos ] & RADIOTAP_FLAGS_FCS ) != 0;
+			if( bit == 5 ) rssi = (int8_t)data[ pos ];
+			pos += sizes[ bit ];
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool pcapWrite(const std::string &path, const std::vector<PcapFrame> &frames)
+	{
+		std::string out;
+		put32( out, PCAP_MAGIC_US );
+		put32( out, 2 | ( 4 << 16 ) );						// version 2.4
+		put32( out, 0 );									// thiszone
+		put32( out, 0 );									// sigfigs
+		put32( out, 65535 );								// snaplen
+		put32( out, PCAP_LINKTYPE_RADIOTAP );
+		for( const PcapFrame &frame : frames ){
+			// radiotap: version, pad, length 9, present: dBm antenna signal
+			const uint8_t radiotap[ 9 ] = { 0, 0, 9, 0, 0x20, 0, 0, 0, (uint8_t)frame.rssi };
+			put32( out, frame.time / 1000 );
+			put32( out, ( frame.time % 1000 ) * 1000 );
+			put32( out, sizeof( radiotap ) + frame.data.size() );
+			put32( out, sizeof( radiotap ) + frame.data.size() );
+			out.append( (const char*)radiotap, sizeof( radiotap ) );
+			out += frame.data;
+		}
+
+		FILE* f = fopen( path.c_str(), "wb" );
+		if( f == nullptr ) return false;
+		bool res = fwrite( out.data(), 1, out.size(), f ) == out.size();
+		return ( fclose( f ) == 0 ) && res;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool pcapRead(const std::string &path, std::vector<PcapFrame> &frames)
+	{
+		frames.clear();
+		FILE* f = fopen( path.c_str(), "rb" );
+		if( f == nullptr ) return false;
+
+		uint32_t header[ 6 ];
+		bool res = fread( header, sizeof( header ), 1, f ) == 1;
+		bool swapped = res && ( host::swap32( header[ 0 ] ) == PCAP_MAGIC_US || host::swap32( header[ 0 ] ) == PCAP_MAGIC_NS );
+		if( swapped ){
+			for( uint32_t &h : header ) h = host::swap32( h );
+		}
+		bool nano = header[ 0 ] == PCAP_MAGIC_NS;
+		uint32_t linkType = header[ 5 ] & 0x0FFFFFFF;
+		res = res && ( header[ 0 ] == PCAP_MAGIC_US || nano ) && ( linkType == PCAP_LINKTYPE_IEEE802_11 || linkType == PCAP_LINKTYPE_RADIOTAP );
+
+		uint64_t start = 0;
+		std::string data;
+		while( res ){
+			uint32_t record[ 4 ];
+			if( fread( record, sizeof( record ), 1, f ) != 1 ) break;
+			if( swapped ){
+				for( uint32_t &r : record ) r = host::swap32( r );
+			}
+			data.resize( record[ 2 ] );
+			if( record[ 2 ] > 0x40000 || fread( &data[ 0 ], 1, data.size(), f ) != data.size() ){
+				res = false;
+				break;
+			}
+
+			PcapFrame frame;
+			uint64_t us = (uint64_t)record[ 0 ] * 1000000 + ( ( nano ) ? record[ 1 ] / 1000 : record[ 1 ] );
+			if( frames.empty() ) start = us;
+			frame.time = ( us - start ) / 1000;
+			frame.rssi = 0;
+			size_t skip = 0;
+			bool fcs = false;
+			if( linkType == PCAP_LINKTYPE_RADIOTAP && !host::radiotapParse( (const uint8_t*)data.data(), data.size(), skip, frame.rssi, fcs ) ) continue;
+			frame.data = data.substr( skip );
+			if( fcs && frame.data.size() >= 4 ) frame.data.resize( frame.data.size() - 4 );
+			frames.push_back( frame );
+		}
+		fclose( f );
+		return res;
+	}
+
+	//-------------------------------------------------------------------------------
+	void pcapReplay(const std::vector<PcapFrame> &frames, const std::function<void(void)> &each)
+	{
+		uint32_t start = millis();
+		for( const PcapFrame &frame : frames ){
+			// frames keep their spacing on virtual clock
+			int32_t wait = (int32_t)( start + frame.time - millis() );
+			if( wait > 0 ) host::advance( wait );
+			uint8_t type = ( frame.data.empty() ) ? WIFI_PKT_MISC : ( frame.data[ 0 ] >> 2 ) & 0x03;
+			host::promiscFeed( (const uint8_t*)frame.data.data(), frame.data.size(), frame.rssi, ( type > WIFI_PKT_DATA ) ? WIFI_PKT_MISC : (wifi_promiscuous_pkt_type_t)type );
+			if( each ) each();
+		}
+	}
+}
@@ -0,0 +1,49 @@
+//-------------------------------------------------------------------------------
+// Ed25519 verification of libsodium API by OpenSSL, signing of test manifests
+//-------------------------------------------------------------------------------
+#include "sodium.h"
+#include <openssl/evp.h>
+#include <stdio.h>
+#include <string>
+
+//-------------------------------------------------------------------------------
+int crypto_sign_ed25519_verify_detached(const unsigned char* sig, const unsigned char* m, unsigned long long mlen, const unsigned char* pk)
+{
+	EVP_PKEY* key = EVP_PKEY_new_raw_public_key( EVP_PKEY_ED25519, nullptr, pk, 32 );
+	if( key == nullptr ) return -1;
+
+	EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+	int res = -1;
+	if( ctx != nullptr && EVP_DigestVerifyInit( ctx, nullptr, nullptr, nullptr, key ) == 1 ){
+		res = ( EVP_DigestVerify( ctx, sig, 64, m, mlen ) == 1 ) ? 0 : -1;
+	}
+	EVP_MD_CTX_free( ctx );
+	EVP_PKEY_free( key );
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+namespace host {
+	//-------------------------------------------------------------------------------
+	std::string ed25519Sign(const uint8_t* seed, const std::string &message)
+	{
+		EVP_PKEY* key = EVP_PKEY_new_raw_private_key( EVP_PKEY_ED25519, nullptr, seed, 32 );
+		if( key == nullptr ) return std::string();
+
+		EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+		unsigned char sig[ 64 ];
+		size_t sigLen = sizeof( sig );
+		std::string res;
+		if( ctx != nullptr && EVP_DigestSignInit( ctx, nullptr, nullptr, nullptr, key ) == 1
+			&& EVP_DigestSign( ctx, sig, &sigLen, (const unsigned char*)message.data(), message.size() ) == 1 ){
+			char hex[ 3 ];
+			for( size_t i = 0; i < sigLen; i++ ){
+				snprintf( hex, sizeof( hex ), "%02x", sig[ i ] );
+				res += hex;
+			}
+		}
+		EVP_MD_CTX_free( ctx );
+		EVP_PKEY_free( key );
+		return res;
+	}
+}
@@ -0,0 +1,8 @@
+#ifndef __HOST_SODIUM_H__
+#define __HOST_SODIUM_H__
+
+//-------------------------------------------------------------------------------
+// Ed25519 verification by OpenSSL, only targets with ESP_UPDATE_PUBLIC_KEY link it
+int crypto_sign_ed25519_verify_detached(const unsigned char* sig, const unsigned char* m, unsigned long long mlen, const unsigned char* pk);
+
+#endif /* __HOST_SODIUM_H__ */
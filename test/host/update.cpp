@@ -0,0 +1,141 @@
+//-------------------------------------------------------------------------------
+// Update to memory image, MD5 is checked at end() like ESP32 Update
+//-------------------------------------------------------------------------------
+#include "host.h"
+
+UpdateClass Update;
+
+//-------------------------------------------------------------------------------
+// RFC 1321
+static void md5(const uint8_t* data, const size_t len, uint8_t digest[ 16 ])
+{
+	static const uint32_t k[ 64 ] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+		0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+		0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+		0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+		0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+		0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+	};
+	static const uint8_t r[ 64 ] = {
+		7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+		5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+		4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+		6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+	};
+	uint32_t h[ 4 ] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+	std::vector<uint8_t> msg( data, data + len );
+	msg.push_back( 0x80 );
+	while( msg.size() % 64 != 56 ) msg.push_back( 0 );
+	uint64_t bits = (uint64_t)len * 8;
+	for( int i = 0; i < 8; i++ ) msg.push_back( bits >> ( i * 8 ) );
+
+	for( size_t block = 0; block < msg.size(); block += 64 ){
+		uint32_t w[ 16 ];
+		for( int i = 0; i < 16; i++ ) memcpy( &w[ i ], &msg[ block + i * 4 ], 4 );
+		uint32_t a = h[ 0 ], b = h[ 1 ], c = h[ 2 ], d = h[ 3 ];
+		for( int i = 0; i < 64; i++ ){
+			uint32_t f, g;
+			if( i < 16 ){ f = ( b & c ) | ( ~b & d ); g = i; }
+			else if( i < 32 ){ f = ( d & b ) | ( ~d & c ); g = ( 5 * i + 1 ) % 16; }
+			else if( i < 48 ){ f = b ^ c ^ d; g = ( 3 * i + 5 ) % 16; }
+			else{ f = c ^ ( b | ~d ); g = ( 7 * i ) % 16; }
+			uint32_t t = d;
+			d = c;
+			c = b;
+			uint32_t x = a + f + k[ i ] + w[ g ];
+			b = b + ( ( x << r[ i ] ) | ( x >> ( 32 - r[ i ] ) ) );
+			a = t;
+		}
+		h[ 0 ] += a; h[ 1 ] += b; h[ 2 ] += c; h[ 3 ] += d;
+	}
+	memcpy( digest, h, 16 );
+}
+
+//-------------------------------------------------------------------------------
+bool UpdateClass::begin(size_t size, int command)
+{
+	image.clear();
+	total = 0;
+	running = false;
+	committed = false;
+	aborted = false;
+	md5[ 0 ] = '\0';
+	error = UPDATE_ERROR_OK;
+	if( size == 0 || ( size != UPDATE_SIZE_UNKNOWN && size > ESP.getFreeSketchSpace() ) ){
+		error = ( size == 0 ) ? UPDATE_ERROR_SIZE : UPDATE_ERROR_SPACE;
+		return false;
+	}
+	this->command = command;
+	total = ( size == UPDATE_SIZE_UNKNOWN ) ? ESP.getFreeSketchSpace() : size;
+	running = true;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+size_t UpdateClass::write(uint8_t* data, size_t len)
+{
+	if( !running || hasError() ) return 0;
+	if( image.size() + len > total ){
+		error = UPDATE_ERROR_SPACE;
+		return 0;
+	}
+	image.insert( image.end(), data, data + len );
+	return len;
+}
+
+//-------------------------------------------------------------------------------
+size_t UpdateClass::writeStream(Stream &data)
+{
+	uint8_t buff[ 4096 ];
+	size_t written = 0;
+	while( size_t len = data.readBytes( buff, sizeof( buff ) ) ){
+		if( write( buff, len ) != len ) break;
+		written += len;
+	}
+	return written;
+}
+
+//-------------------------------------------------------------------------------
+bool UpdateClass::end(bool evenIfRemaining)
+{
+	if( !running || hasError() ) return false;
+	if( !isFinished() && !evenIfRemaining ){
+		error = UPDATE_ERROR_ABORT;
+		running = false;
+		return false;
+	}
+	if( md5[ 0 ] ){
+		uint8_t digest[ 16 ];
+		char hex[ 33 ];
+		::md5( image.data(), image.size(), digest );
+		for( int i = 0; i < 16; i++ ) sprintf( hex + i * 2, "%02x", digest[ i ] );
+		if( strcmp( hex, md5 ) != 0 ){
+			error = UPDATE_ERROR_MD5;
+			running = false;
+			return false;
+		}
+	}
+	running = false;
+	committed = true;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+void UpdateClass::abort(void)
+{
+	running = false;
+	aborted = true;
+	error = UPDATE_ERROR_ABORT;
+}
+
+//-------------------------------------------------------------------------------
+bool UpdateClass::setMD5(const char* expectedMD5)
+{
+	if( strlen( expectedMD5 ) != 32 ) return false;
+	for( int i = 0; i < 33; i++ ) md5[ i ] = tolower( (unsigned char)expectedMD5[ i ] );
+	return true;
+}
@@ -0,0 +1,209 @@
+//-------------------------------------------------------------------------------
+// WebServer: request is passed to routes directly, response is collected in memory
+//-------------------------------------------------------------------------------
+#include "host.h"
+
+//-------------------------------------------------------------------------------
+static const String* findParam(const HostParams &params, const String &name, const bool nocase)
+{
+	for( const auto &param : params ){
+		if( nocase ? strcasecmp( param.first.c_str(), name.c_str() ) == 0 : param.first == name ) return &param.second;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------
+const char* HostResponse::header(const char* name) const
+{
+	const String* value = findParam( headers, name, true );
+	return ( value != nullptr ) ? value->c_str() : nullptr;
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::on(const String &uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler)
+{
+	routes.push_back( { uri, method, handler, uploadHandler } );
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::send(int code, const char* contentType, const String &content)
+{
+	if( headersSent ) return;
+	headersSent = true;
+	response.code = code;
+	response.contentType = contentType;
+	response.headers = pendingHeaders;
+	pendingHeaders.clear();
+	response.chunked = ( contentLength == CONTENT_LENGTH_UNKNOWN );
+	if( !response.chunked ){
+		char len[ 16 ];
+		snprintf( len, sizeof( len ), "%lu", (unsigned long)( ( contentLength == CONTENT_LENGTH_NOT_SET ) ? content.length() : contentLength ) );
+		response.headers.push_back( { "Content-Length", len } );
+	}
+	response.body.append( content.c_str(), content.length() );
+	contentLength = CONTENT_LENGTH_NOT_SET;
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::sendHeader(const String &name, const String &value, bool first)
+{
+	if( first ){
+		pendingHeaders.insert( pendingHeaders.begin(), { name, value } );
+	}else{
+		pendingHeaders.push_back( { name, value } );
+	}
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::sendContent(const char* content, size_t len)
+{
+	response.body.append( content, len );
+}
+
+//-------------------------------------------------------------------------------
+size_t WebServer::streamFile(File &file, const String &contentType, const int code)
+{
+	if( String( file.path() ).endsWith( ".gz" ) && contentType != "application/x-gzip" && contentType != "application/octet-stream" ){
+		sendHeader( "Content-Encoding", "gzip" );
+	}
+	setContentLength( file.size() );
+	send( code, contentType.c_str(), "" );
+
+	uint8_t buff[ 1436 ];
+	size_t total = 0;
+	while( size_t len = file.read( buff, sizeof( buff ) ) ){
+		sendContent( (const char*)buff, len );
+		total += len;
+	}
+	return total;
+}
+
+//-------------------------------------------------------------------------------
+// Credentials are sent as "Authorization: <user>:<password>"
+bool WebServer::authenticate(const char* user, const char* password)
+{
+	const String* value = findParam( currentHeaders, "Authorization", true );
+	return value != nullptr && *value == String( user ) + ":" + password;
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::requestAuthentication(HTTPAuthMethod mode, const char* realm, const String &failMess)
+{
+	sendHeader( "WWW-Authenticate", String( ( mode == BASIC_AUTH ) ? "Basic" : "Digest" ) + " realm=\"" + ( ( realm != nullptr ) ? realm : "Login Required" ) + "\"" );
+	send( 401, "text/html", failMess );
+}
+
+//-------------------------------------------------------------------------------
+bool WebServer::hasArg(const String &name)
+{
+	return findParam( currentArgs, name, false ) != nullptr;
+}
+
+//-------------------------------------------------------------------------------
+String WebServer::arg(const String &name)
+{
+	const String* value = findParam( currentArgs, name, false );
+	return ( value != nullptr ) ? *value : String();
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::collectHeaders(const char* headerKeys[], const size_t count)
+{
+	collected.clear();
+	collected.push_back( "Authorization" );
+	for( size_t i = 0; i < count; i++ ) collected.push_back( headerKeys[ i ] );
+}
+
+//-------------------------------------------------------------------------------
+// Only collected headers are kept by server
+bool WebServer::hasHeader(const String &name)
+{
+	for( const String &key : collected ){
+		if( strcasecmp( key.c_str(), name.c_str() ) == 0 ) return findParam( currentHeaders, name, true ) != nullptr;
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------------
+String WebServer::header(const String &name)
+{
+	if( !hasHeader( name ) ) return String();
+	return *findParam( currentHeaders, name, true );
+}
+
+//-------------------------------------------------------------------------------
+WebServer::Route* WebServer::findRoute(void)
+{
+	for( Route &route : routes ){
+		if( route.uri == currentUri && ( route.method == HTTP_ANY || route.method == currentMethod ) ) return &route;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------
+void WebServer::start(const char* uri, HTTPMethod method, const HostParams &args, const HostParams &headers)
+{
+	currentUri = uri;
+	currentMethod = method;
+	currentArgs = args;
+	currentHeaders = headers;
+	pendingHeaders.clear();
+	response = HostResponse();
+	contentLength = CONTENT_LENGTH_NOT_SET;
+	headersSent = false;
+}
+
+//-------------------------------------------------------------------------------
+HostResponse WebServer::request(const char* uri, HTTPMethod method, const HostParams &args, const HostParams &headers)
+{
+	start( uri, method, args, headers );
+	Route* route = findRoute();
+	if( route != nullptr ){
+		route->handler();
+	}else if( notFound ){
+		notFound();
+	}else{
+		send( 404, "text/plain", String( "Not found: " ) + uri );
+	}
+	if( !headersSent ) send( 500, "text/plain", "" );
+	return response;
+}
+
+//-------------------------------------------------------------------------------
+// multipart/form-data upload of one file, sizes follow ESP32 WebServer (totalSize grows with parts)
+HostResponse WebServer::uploadFile(const char* uri, const HostParams &args, const char* name, const char* filename, const uint8_t* data, size_t len, bool abort)
+{
+	start( uri, HTTP_POST, args, HostParams() );
+	Route* route = findRoute();
+	if( route == nullptr || !route->uploadHandler ){
+		send( 404, "text/plain", "" );
+		return response;
+	}
+
+	currentUpload.name = name;
+	currentUpload.filename = filename;
+	currentUpload.type = "application/octet-stream";
+	currentUpload.totalSize = 0;
+	currentUpload.currentSize = 0;
+	currentUpload.status = UPLOAD_FILE_START;
+	route->uploadHandler();
+
+	size_t pos = 0;
+	while( pos < len ){
+		size_t part = std::min( len - pos, (size_t)HTTP_UPLOAD_BUFLEN );
+		memcpy( currentUpload.buf, data + pos, part );
+		currentUpload.currentSize = part;
+		currentUpload.totalSize += part;
+		currentUpload.status = UPLOAD_FILE_WRITE;
+		route->uploadHandler();
+		pos += part;
+		if( abort && pos >= len / 2 ) break;
+	}
+
+	currentUpload.currentSize = 0;
+	currentUpload.status = ( abort ) ? UPLOAD_FILE_ABORTED : UPLOAD_FILE_END;
+	route->uploadHandler();
+	if( !abort ) route->handler();
+	if( !headersSent ) send( 500, "text/plain", "" );
+	return response;
+}
@@ -0,0 +1,246 @@
+//-------------------------------------------------------------------------------
+// Simulated radio for WiFi and esp_wifi promiscuous API
+//-------------------------------------------------------------------------------
+#include "host.h"
+#include <atomic>
+
+WiFiClass WiFi;
+
+namespace host {
+	static std::vector<Network> networks;
+	static uint32_t scanTime = 0;						// ms from scan start to results
+	static uint32_t connectTime = 0;					// ms from begin() to connection
+	static bool scanning = false;
+	static uint32_t scanStart = 0;
+	static std::vector<Network> scanned;
+	static int connecting = -1;							// network being joined
+	static int connected = -1;
+	static wl_status_t failStatus = WL_DISCONNECTED;
+	static uint32_t connectStart = 0;
+	static uint32_t begins = 0;
+	static IPAddress staticIp;
+	static uint8_t channel = 1;
+	static std::atomic<bool> promiscuous( false );
+	static wifi_promiscuous_cb_t promiscCb = nullptr;
+	static uint32_t promiscMask = WIFI_PROMIS_FILTER_MASK_ALL;
+	static uint8_t mac[ 6 ] = { 0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01 };
+
+	//-------------------------------------------------------------------------------
+	void wifiNetworks(const std::vector<Network> &networks)
+	{
+		host::networks = networks;
+	}
+
+	//-------------------------------------------------------------------------------
+	void wifiTimes(const uint32_t scanMs, const uint32_t connectMs)
+	{
+		host::scanTime = scanMs;
+		host::connectTime = connectMs;
+	}
+
+	//-------------------------------------------------------------------------------
+	void wifiDrop(void)
+	{
+		host::connected = -1;
+		host::connecting = -1;
+		host::failStatus = WL_CONNECTION_LOST;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t wifiBegins(void)
+	{
+		return host::begins;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint8_t wifiChannel(void)
+	{
+		return host::channel;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool promiscEnabled(void)
+	{
+		return host::promiscuous;
+	}
+
+	//-------------------------------------------------------------------------------
+	uint32_t promiscFilter(void)
+	{
+		return host::promiscMask;
+	}
+
+	//-------------------------------------------------------------------------------
+	// Frame as Wi-Fi driver passes it: rx_ctrl header, then 802.11 frame with 4 bytes of FCS
+	void promiscFeed(const uint8_t* frame, const size_t len, const int8_t rssi, const wifi_promiscuous_pkt_type_t type)
+	{
+		if( !host::promiscuous || host::promiscCb == nullptr ) return;
+		if( !( host::promiscMask & ( 1 << type ) ) ) return;
+
+		uint8_t buff[ sizeof( wifi_pkt_rx_ctrl_t ) + 2500 ];
+		wifi_promiscuous_pkt_t* pkt = (wifi_promiscuous_pkt_t*)buff;
+		size_t size = std::min( len, sizeof( buff ) - sizeof( wifi_pkt_rx_ctrl_t ) - 4 );
+		memset( buff, 0, sizeof( wifi_pkt_rx_ctrl_t ) );
+		pkt->rx_ctrl.rssi = rssi;
+		pkt->rx_ctrl.channel = host::channel;
+		pkt->rx_ctrl.timestamp = micros();
+		pkt->rx_ctrl.sig_len = size + 4;
+		memcpy( pkt->payload, frame, size );
+		memset( pkt->payload + size, 0, 4 );
+		host::promiscCb( buff, type );
+	}
+
+	//-------------------------------------------------------------------------------
+	static int findNetwork(const char* ssid, const uint8_t* bssid)
+	{
+		for( size_t i = 0; i < host::networks.size(); i++ ){
+			if( host::networks[ i ].ssid != ssid ) continue;
+			if( bssid != nullptr && memcmp( bssid, host::networks[ i ].bssid, 6 ) != 0 ) continue;
+			return i;
+		}
+		return -1;
+	}
+}
+
+//-------------------------------------------------------------------------------
+wl_status_t WiFiClass::status(void)
+{
+	if( host::connected >= 0 ) return WL_CONNECTED;
+	if( host::connecting >= 0 && millis() - host::connectStart >= host::connectTime ){
+		host::connected = host::connecting;
+		host::connecting = -1;
+		host::channel = host::networks[ host::connected ].channel;
+		return WL_CONNECTED;
+	}
+	return ( host::connecting >= 0 ) ? WL_DISCONNECTED : host::failStatus;
+}
+
+//-------------------------------------------------------------------------------
+wl_status_t WiFiClass::begin(const char* ssid, const char* key, int32_t channel, const uint8_t* bssid, bool connect)
+{
+	host::begins++;
+	host::connected = -1;
+	host::connecting = -1;
+	host::connectStart = millis();
+	int i = host::findNetwork( ssid, bssid );
+	if( i < 0 ){
+		host::failStatus = WL_NO_SSID_AVAIL;
+	}else if( host::networks[ i ].key != ( ( key != nullptr ) ? key : "" ) ){
+		host::failStatus = WL_CONNECT_FAILED;
+	}else{
+		host::connecting = i;
+	}
+	return status();
+}
+
+//-------------------------------------------------------------------------------
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp)
+{
+	host::connected = -1;
+	host::connecting = -1;
+	host::failStatus = WL_DISCONNECTED;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+bool WiFiClass::config(IPAddress ip, IPAddress gateway, IPAddress mask, IPAddress dns1, IPAddress dns2)
+{
+	host::staticIp = ip;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden)
+{
+	host::scanning = true;
+	host::scanStart = millis();
+	if( !async ){
+		delay( host::scanTime );
+		return scanComplete();
+	}
+	return WIFI_SCAN_RUNNING;
+}
+
+//-------------------------------------------------------------------------------
+int16_t WiFiClass::scanComplete(void)
+{
+	if( host::scanning ){
+		if( millis() - host::scanStart < host::scanTime ) return WIFI_SCAN_RUNNING;
+		host::scanning = false;
+		host::scanned = host::networks;
+		return host::scanned.size();
+	}
+	return ( host::scanned.empty() ) ? WIFI_SCAN_FAILED : host::scanned.size();
+}
+
+//-------------------------------------------------------------------------------
+void WiFiClass::scanDelete(void)
+{
+	host::scanned.clear();
+}
+
+String WiFiClass::SSID(uint8_t i) { return ( i < host::scanned.size() ) ? host::scanned[ i ].ssid : String(); }
+int32_t WiFiClass::RSSI(uint8_t i) { return ( i < host::scanned.size() ) ? host::scanned[ i ].rssi : 0; }
+int32_t WiFiClass::channel(uint8_t i) { return ( i < host::scanned.size() ) ? host::scanned[ i ].channel : 0; }
+uint8_t* WiFiClass::BSSID(uint8_t i) { return ( i < host::scanned.size() ) ? host::scanned[ i ].bssid : nullptr; }
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) { return ( i < host::scanned.size() ) ? host::scanned[ i ].auth : WIFI_AUTH_OPEN; }
+
+String WiFiClass::SSID(void) { return ( status() == WL_CONNECTED ) ? host::networks[ host::connected ].ssid : String(); }
+int32_t WiFiClass::RSSI(void) { return ( status() == WL_CONNECTED ) ? host::networks[ host::connected ].rssi : 0; }
+int32_t WiFiClass::channel(void) { return host::channel; }
+uint8_t* WiFiClass::BSSID(void) { return ( status() == WL_CONNECTED ) ? host::networks[ host::connected ].bssid : nullptr; }
+
+//-------------------------------------------------------------------------------
+IPAddress WiFiClass::localIP(void)
+{
+	if( status() != WL_CONNECTED ) return IPAddress();
+	return ( (uint32_t)host::staticIp != 0 ) ? host::staticIp : IPAddress( 192, 168, 1, 100 + host::connected );
+}
+
+IPAddress WiFiClass::gatewayIP(void) { return ( status() == WL_CONNECTED ) ? IPAddress( 192, 168, 1, 1 ) : IPAddress(); }
+IPAddress WiFiClass::subnetMask(void) { return ( status() == WL_CONNECTED ) ? IPAddress( 255, 255, 255, 0 ) : IPAddress(); }
+IPAddress WiFiClass::dnsIP(uint8_t i) { return gatewayIP(); }
+
+//-------------------------------------------------------------------------------
+String WiFiClass::macAddress(void)
+{
+	char buff[ 18 ];
+	snprintf( buff, sizeof( buff ), "%02X:%02X:%02X:%02X:%02X:%02X", host::mac[ 0 ], host::mac[ 1 ], host::mac[ 2 ], host::mac[ 3 ], host::mac[ 4 ], host::mac[ 5 ] );
+	return String( buff );
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_wifi_set_mac(wifi_interface_t ifx, const uint8_t mac[ 6 ])
+{
+	memcpy( host::mac, mac, 6 );
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+	if( primary < 1 || primary > 14 ) return ESP_ERR_INVALID_ARG;
+	host::channel = primary;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_wifi_set_promiscuous(bool en)
+{
+	host::promiscuous = en;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb)
+{
+	host::promiscCb = cb;
+	return ESP_OK;
+}
+
+//-------------------------------------------------------------------------------
+esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t* filter)
+{
+	host::promiscMask = filter->filter_mask;
+	return ESP_OK;
+}
@@ -0,0 +1,196 @@
+//-------------------------------------------------------------------------------
+// Frame parsing and per-MAC aggregation, capture is replayed from pcap file
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+#include <filesystem>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+static const uint8_t BROADCAST[ 6 ] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+//-------------------------------------------------------------------------------
+static std::string mac(const uint32_t id)
+{
+	const uint8_t addr[ 6 ] = { 0x02, 0, 0, (uint8_t)( id >> 16 ), (uint8_t)( id >> 8 ), (uint8_t)id };
+	return std::string( (const char*)addr, 6 );
+}
+
+//-------------------------------------------------------------------------------
+static std::string macText(const uint32_t id)
+{
+	char buff[ 18 ];
+	snprintf( buff, sizeof( buff ), "02:00:00:%02x:%02x:%02x", ( id >> 16 ) & 0xFF, ( id >> 8 ) & 0xFF, id & 0xFF );
+	return buff;
+}
+
+//-------------------------------------------------------------------------------
+// 802.11 header: frame control, duration, addr1-3, sequence control
+static std::string header(const uint8_t fc0, const uint8_t fc1, const std::string &addr1, const std::string &addr2, const std::string &addr3, const uint16_t seq)
+{
+	std::string res = { (char)fc0, (char)fc1, 0, 0 };
+	res += addr1 + addr2 + addr3;
+	res += (char)( ( seq << 4 ) & 0xFF );
+	res += (char)( seq >> 4 );
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static std::string probeRequest(const uint32_t src, const char* ssid, const uint16_t seq)
+{
+	const std::string broadcast( (const char*)BROADCAST, 6 );
+	std::string res = header( 0x40, 0x00, broadcast, mac( src ), broadcast, seq );
+	res += (char)0;
+	res += (char)strlen( ssid );
+	res += ssid;
+	res += std::string( "\x01\x04\x02\x04\x0b\x16", 6 );
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static std::string beacon(const uint32_t bssid, const uint16_t seq, const size_t padding)
+{
+	const std::string broadcast( (const char*)BROADCAST, 6 );
+	std::string res = header( 0x80, 0x00, broadcast, mac( bssid ), mac( bssid ), seq );
+	res += std::string( 12, '\0' );
+	res += std::string( "\x00\x04" "home", 6 );
+	res += std::string( padding, '\xdd' );
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+// QoS data to AP (toDS)
+static std::string qosData(const uint32_t src, const uint32_t bssid, const uint16_t seq)
+{
+	std::string res = header( 0x88, 0x01, mac( bssid ), mac( src ), mac( 0xFFFFFF ), seq );
+	res += std::string( 2, '\0' );
+	res += std::string( 20, '\x55' );
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static std::string ack(const uint32_t dst)
+{
+	std::string res = { (char)0xD4, 0, 0, 0 };
+	return res + mac( dst );
+}
+
+//-------------------------------------------------------------------------------
+static void replay(const std::vector<host::PcapFrame> &frames)
+{
+	host::pcapReplay( frames, [](){ esp::promiscDrain( esp::aggregateFrame ); } );
+}
+
+//-------------------------------------------------------------------------------
+static std::string json(void)
+{
+	static char buff[ 16384 ];
+	esp::JsonWriter writer( buff, sizeof( buff ) );
+	esp::macTableJson( writer, millis() );
+	return writer.c_str();
+}
+
+//-------------------------------------------------------------------------------
+// Binary record of MAC, nullptr if not exported
+static const uint8_t* exported(const std::vector<uint8_t> &buff, const uint32_t id)
+{
+	uint16_t count = buff[ 0 ] | ( buff[ 1 ] << 8 );
+	for( uint16_t i = 0; i < count; i++ ){
+		const uint8_t* rec = buff.data() + 2 + i * ESP_MAC_EXPORT_RECORD_SIZE;
+		if( memcmp( rec, mac( id ).data(), 6 ) == 0 ) return rec;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------
+static void testCapture(const std::string &path)
+{
+	std::vector<host::PcapFrame> frames = {
+		{ 0, -40, probeRequest( 0x0a, "home", 1 ) },
+		{ 100, -50, probeRequest( 0x0a, "cafe", 2 ) },
+		{ 150, -75, ack( 0x0a ) },
+		{ 200, -60, probeRequest( 0x0a, "home", 3 ) },
+		{ 250, -80, qosData( 0x0c, 0x0b, 7 ) },
+		{ 260, -80, qosData( 0x0c, 0x0b, 8 ) },
+	};
+	for( uint16_t i = 0; i < 5; i++ ) frames.push_back( { (uint32_t)( 300 + i * 100 ), -70, beacon( 0x0b, 100 + i, ( i == 4 ) ? 200 : 0 ) } );
+	CHECK( host::pcapWrite( path, frames ) );
+
+	std::vector<host::PcapFrame> read;
+	CHECK( host::pcapRead( path, read ) && read.size() == frames.size() );
+	CHECK( read.back().time == 700 && read.back().rssi == -70 && read.back().data == frames.back().data );
+
+	esp::macTableClear();
+	const esp::MacTableStats stats = esp::macTableStats;
+	const uint32_t overrun = esp::promiscStats.overrun;
+	replay( read );
+
+	// ACK is dropped by hardware filter, long beacon is stored truncated and still counted
+	CHECK( esp::macTableStats.entries == 3 );
+	CHECK( esp::macTableStats.frames - stats.frames == 10 );
+	CHECK( esp::promiscStats.overrun - overrun == 1 );
+
+	std::string text = json();
+	CHECK( text.find( "\"mac\":\"" + macText( 0x0a ) + "\"" ) != std::string::npos );
+	CHECK( text.find( "\"rssi\":-50,\"packets\":3," ) != std::string::npos );
+	CHECK( text.find( "\"probes\":2,\"ssid\":\"home\"" ) != std::string::npos );
+	CHECK( text.find( "\"rssi\":-70,\"packets\":5," ) != std::string::npos );
+	CHECK( text.find( "\"rssi\":-80,\"packets\":2," ) != std::string::npos );
+
+	std::vector<uint8_t> buff( 2 + 3 * ESP_MAC_EXPORT_RECORD_SIZE );
+	CHECK( esp::macTableExport( buff.data(), buff.size(), millis() ) == buff.size() );
+	const uint8_t* rec = exported( buff, 0x0a );
+	CHECK( rec != nullptr && (int8_t)rec[ 7 ] == -50 && rec[ 8 ] == 3 && rec[ 9 ] == 0 && rec[ 20 ] == 2 );
+	rec = exported( buff, 0x0b );
+	CHECK( rec != nullptr && rec[ 6 ] == PROMISCUOUS_MODE_CHANNEL && rec[ 8 ] == 5 && rec[ 20 ] == 0 );
+	// too small buffer keeps whole records only
+	CHECK( esp::macTableExport( buff.data(), buff.size() - 1, millis() ) == 2 + 2 * ESP_MAC_EXPORT_RECORD_SIZE );
+}
+
+//-------------------------------------------------------------------------------
+static void testAging(void)
+{
+	const uint32_t expired = esp::macTableStats.expired;
+	host::advance( ESP_MAC_MAX_AGE + ESP_MAC_AGE_INTERVAL );
+	replay( { { 0, -30, probeRequest( 0x0d, "home", 1 ) } } );
+	CHECK( esp::macTableStats.expired - expired == 3 );
+	CHECK( esp::macTableStats.entries == 1 );
+	CHECK( json().find( macText( 0x0d ) ) != std::string::npos );
+}
+
+//-------------------------------------------------------------------------------
+static void testEviction(void)
+{
+	esp::macTableClear();
+	const uint32_t evictions = esp::macTableStats.evictions;
+	std::vector<host::PcapFrame> frames;
+	for( uint32_t i = 0; i < ESP_MAC_TABLE_SIZE + 10; i++ ) frames.push_back( { i, -50, qosData( 0x100 + i, 0x0b, i ) } );
+	replay( frames );
+
+	// one slot stays free for probing, least recently seen MACs are evicted
+	CHECK( esp::macTableStats.entries == ESP_MAC_TABLE_SIZE - 1 );
+	CHECK( esp::macTableStats.evictions - evictions == 11 );
+	std::string text = json();
+	CHECK( text.find( macText( 0x100 ) ) == std::string::npos && text.find( macText( 0x100 + 10 ) ) == std::string::npos );
+	CHECK( text.find( macText( 0x100 + 11 ) ) != std::string::npos && text.find( macText( 0x100 + ESP_MAC_TABLE_SIZE + 9 ) ) != std::string::npos );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+	esp::enablePromiscMode();
+
+	std::string path = ( std::filesystem::temp_directory_path() / ( "test_aggregate_" + std::to_string( getpid() ) + ".pcap" ) ).string();
+	testCapture( path );
+	testAging();
+	testEviction();
+	std::filesystem::remove( path );
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+//-------------------------------------------------------------------------------
+// CAN rings: CAN_write submits to driver without CAN task (not started on host), filter reinstall
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static can_message_t frame(const uint32_t id)
+{
+	can_message_t msg = {};
+	msg.identifier = id;
+	msg.data_length_code = 1;
+	msg.data[ 0 ] = id;
+	return msg;
+}
+
+//-------------------------------------------------------------------------------
+static void testWrite(void)
+{
+	// filters alone do not start driver
+	const esp::CanFilter filter = { 0x100, 0x700, false };
+	CHECK( esp::CAN_setFilters( &filter, 1 ) && host::canInstalls() == 0 );
+
+	// queued before init, passed to driver by CAN_Init
+	CHECK( esp::CAN_write( frame( 0x100 ) ) );
+	CHECK( host::canSent().empty() );
+	esp::CAN_Init( 500, 5, 4 );
+	CHECK( host::canSent().size() == 1 );
+
+	can_message_t batch[ 3 ] = { frame( 0x101 ), frame( 0x102 ), frame( 0x103 ) };
+	CHECK( esp::CAN_write( batch, 3 ) == 3 );
+	std::vector<can_message_t> sent = host::canSent();
+	CHECK( sent.size() == 4 );
+	for( uint32_t i = 0; i < sent.size() && i < 4; i++ ) CHECK( sent[ i ].identifier == 0x100 + i );
+}
+
+//-------------------------------------------------------------------------------
+// Driver does not accept frames: ring keeps them until it is full
+static void testRingFull(void)
+{
+	esp::CAN_Init( 500, 5, 4, CAN_MODE_LISTEN_ONLY );
+	const size_t sent = host::canSent().size();
+	const uint32_t overrun = esp::canStats.txOverrun;
+	for( uint32_t i = 0; i < ESP_CAN_TX_SLOTS; i++ ) CHECK( esp::CAN_write( frame( 0x200 + i ) ) );
+	CHECK( !esp::CAN_write( frame( 0x300 ) ) );
+	CHECK( esp::canStats.txOverrun - overrun == 1 );
+	CHECK( host::canSent().size() == sent );
+
+	// back to normal mode, waiting frames go out in order
+	esp::CAN_Init( 500, 5, 4 );
+	std::vector<can_message_t> all = host::canSent();
+	CHECK( all.size() == sent + ESP_CAN_TX_SLOTS && all[ sent ].identifier == 0x200 && all.back().identifier == 0x200 + ESP_CAN_TX_SLOTS - 1 );
+}
+
+//-------------------------------------------------------------------------------
+// Hardware filter of running driver is replaced at once, timing and mode are kept
+static void testFilters(void)
+{
+	const esp::CanFilter filter = { 0x123, 0x7FF, false };
+	CHECK( esp::CAN_setFilters( &filter, 1 ) );
+	esp::CAN_Init( 250, 5, 4, CAN_MODE_NO_ACK );
+	const uint32_t installs = host::canInstalls();
+	const can_timing_config_t timing = host::canTiming();
+	CHECK( host::canFilter().single_filter && host::canFilter().acceptance_code == 0x123UL << 21 );
+
+	const esp::CanFilter filters[ 2 ] = { { 0x456, 0x7FF, false }, { 0x1ABCDE, 0x1FFFFFFF, true } };
+	CHECK( esp::CAN_setFilters( filters, 2 ) );
+	CHECK( host::canInstalls() == installs + 1 && host::canInstalled() );
+	CHECK( host::canFilter().acceptance_code != 0x123UL << 21 && host::canFilter().acceptance_mask != 0xFFFFFFFF );
+	CHECK( host::canTiming().brp == timing.brp && host::canTiming().tseg_1 == timing.tseg_1 );
+	CHECK( esp::get_CAN_speed() == 250 );
+
+	// measure mode receives all in hardware
+	CHECK( esp::CAN_setFilters( filters, 2, true ) );
+	CHECK( host::canInstalls() == installs + 2 && host::canFilter().acceptance_mask == 0xFFFFFFFF );
+
+	CHECK( esp::CAN_setFilters( nullptr, 0 ) );
+	CHECK( host::canInstalls() == installs + 3 && host::canFilter().acceptance_mask == 0xFFFFFFFF );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	testWrite();
+	testRingFull();
+	testFilters();
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+//-------------------------------------------------------------------------------
+// CAN bit timing calculator against CAN_TIMING_CONFIG_* of ESP-IDF
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+struct Reference{
+	uint32_t bitrate;
+	uint16_t samplePoint;
+	uint32_t brp;
+	uint8_t tseg1;
+	uint8_t tseg2;
+	uint8_t sjw;
+};
+
+// registers of CAN_TIMING_CONFIG_25KBITS..1MBITS
+static const Reference references[] = {
+	{ 25000, 680, 128, 16, 8, 3 },
+	{ 50000, 800, 80, 15, 4, 3 },
+	{ 100000, 800, 40, 15, 4, 3 },
+	{ 125000, 800, 32, 15, 4, 3 },
+	{ 250000, 800, 16, 15, 4, 3 },
+	{ 500000, 800, 8, 15, 4, 3 },
+	{ 800000, 680, 4, 16, 8, 3 },
+	{ 1000000, 800, 4, 15, 4, 3 },
+};
+
+//-------------------------------------------------------------------------------
+static void testReferences(void)
+{
+	for( const Reference &ref : references ){
+		can_timing_config_t timing = {};
+		bool res = esp::CAN_timing( ref.bitrate, ref.samplePoint, timing );
+		if( !res || timing.brp != ref.brp || timing.tseg_1 != ref.tseg1 || timing.tseg_2 != ref.tseg2 || timing.sjw != ref.sjw || timing.triple_sampling ){
+			printf( "FAIL %lu bit/s: %u/%u/%u/%u\n", (unsigned long)ref.bitrate, (unsigned)timing.brp, (unsigned)timing.tseg_1, (unsigned)timing.tseg_2, (unsigned)timing.sjw );
+			failures++;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------
+static void testLimits(void)
+{
+	can_timing_config_t timing;
+	// BRP would exceed ESP_CAN_BRP_MAX
+	CHECK( !esp::CAN_timing( 24000, 800, timing ) );
+	CHECK( !esp::CAN_timing( 10000, 800, timing ) );
+	CHECK( !esp::CAN_timing( 0, 800, timing ) );
+
+	// rates without predefined config, within ESP_CAN_BITRATE_TOLERANCE
+	const uint32_t rates[] = { 33333, 83333, 95238, 666666 };
+	for( uint32_t rate : rates ){
+		CHECK( esp::CAN_timing( rate, 800, timing ) );
+		uint32_t real = ESP_CAN_CLOCK / ( timing.brp * ( 1 + timing.tseg_1 + timing.tseg_2 ) );
+		uint32_t error = ( real > rate ) ? real - rate : rate - real;
+		CHECK( (uint64_t)error * 1000 <= (uint64_t)rate * ESP_CAN_BITRATE_TOLERANCE );
+		CHECK( timing.brp % 2 == 0 && timing.tseg_1 >= 1 && timing.tseg_1 <= 16 && timing.tseg_2 >= 1 && timing.tseg_2 <= 8 );
+	}
+}
+
+//-------------------------------------------------------------------------------
+// CAN_Init by speed uses calculator for speeds without predefined config
+static void testInit(void)
+{
+	esp::CAN_Init( 83, 5, 4 );
+	CHECK( esp::get_CAN_speed() == 83 && host::canInstalled() );
+	esp::CAN_Init( 20, 5, 4 );
+	CHECK( esp::get_CAN_speed() == 125 && host::canTiming().brp == 32 );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	testReferences();
+	testLimits();
+	testInit();
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+//-------------------------------------------------------------------------------
+// downloadUpdate: resume after dropped connections, If-Range restart of changed file, backoff
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static std::string pattern(const size_t size, const uint32_t seed)
+{
+	std::string res( size, '\0' );
+	uint32_t x = seed * 2654435761u + 1;
+	for( size_t i = 0; i < size; i++ ){
+		x = x * 1103515245 + 12345;
+		res[ i ] = x >> 16;
+	}
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static std::string readFile(const char* path)
+{
+	File f = SPIFFS.open( path, "r" );
+	std::string res;
+	int c;
+	while( f && ( c = f.read() ) >= 0 ) res += (char)c;
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static const String* findHeader(const HostParams &headers, const char* name)
+{
+	for( const auto &header : headers ){
+		if( header.first == name ) return &header.second;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------
+// Calls downloadUpdate after every backoff until it succeeds
+static uint32_t downloadAll(const char* file)
+{
+	for( uint32_t calls = 1; calls <= 500; calls++ ){
+		if( esp::downloadUpdate( "http://repo", file ) == 1 ) return calls;
+		host::advance( ESP_DOWNLOAD_BACKOFF_MAX );
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------
+static void testResume(void)
+{
+	host::HttpResource resource;
+	resource.body = pattern( 64 * 1024, 1 );
+	resource.etag = "\"v1\"";
+	resource.dropMax = 4096;
+	host::httpServe( "http://repo/data.bin", resource );
+	host::httpClearLog();
+
+	CHECK( downloadAll( "/data.bin" ) > 0 );
+	CHECK( readFile( "/data.bin" ) == resource.body );
+	CHECK( !SPIFFS.exists( "/data.bin.part" ) && !SPIFFS.exists( "/data.bin.part.tag" ) );
+
+	uint32_t ranges = 0;
+	for( const host::HttpRequest &request : host::httpLog() ){
+		if( findHeader( request.headers, "Range" ) == nullptr ) continue;
+		ranges++;
+		const String* ifRange = findHeader( request.headers, "If-Range" );
+		CHECK( ifRange != nullptr && *ifRange == "\"v1\"" );
+		CHECK( request.code == HTTP_CODE_PARTIAL_CONTENT );
+	}
+	CHECK( ranges > 0 );
+	SPIFFS.remove( "/data.bin" );
+}
+
+//-------------------------------------------------------------------------------
+// File of same size is replaced between calls, data of old version must not be continued
+static void testChanged(void)
+{
+	host::HttpResource resource;
+	resource.body = pattern( 64 * 1024, 2 );
+	resource.lastModified = "Mon, 05 Oct 2026 10:00:00 GMT";
+	resource.dropMax = 1024;
+	host::httpServe( "http://repo/data.bin", resource );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( SPIFFS.exists( "/data.bin.part" ) && readFile( "/data.bin.part.tag" ) == resource.lastModified.str() );
+
+	resource.body = pattern( 64 * 1024, 3 );
+	resource.lastModified = "Tue, 06 Oct 2026 10:00:00 GMT";
+	resource.dropMax = 0;
+	host::httpServe( "http://repo/data.bin", resource );
+	host::httpClearLog();
+	host::advance( ESP_DOWNLOAD_BACKOFF_MAX );
+
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 1 );
+	CHECK( readFile( "/data.bin" ) == resource.body );
+	CHECK( host::httpLog().size() == 1 && host::httpLog()[ 0 ].code == HTTP_CODE_OK );
+	CHECK( findHeader( host::httpLog()[ 0 ].headers, "If-Range" ) != nullptr );
+	SPIFFS.remove( "/data.bin" );
+}
+
+//-------------------------------------------------------------------------------
+// Partial file without validator is downloaded again from start
+static void testNoValidator(void)
+{
+	host::HttpResource resource;
+	resource.body = pattern( 16 * 1024, 4 );
+	resource.dropMax = 1024;
+	host::httpServe( "http://repo/data.bin", resource );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( SPIFFS.exists( "/data.bin.part" ) && !SPIFFS.exists( "/data.bin.part.tag" ) );
+
+	host::httpClearLog();
+	host::advance( ESP_DOWNLOAD_BACKOFF_MAX );
+	esp::downloadUpdate( "http://repo", "/data.bin" );
+	CHECK( !host::httpLog().empty() && findHeader( host::httpLog()[ 0 ].headers, "Range" ) == nullptr );
+
+	resource.dropMax = 0;
+	host::httpServe( "http://repo/data.bin", resource );
+	CHECK( downloadAll( "/data.bin" ) > 0 );
+	CHECK( readFile( "/data.bin" ) == resource.body );
+	SPIFFS.remove( "/data.bin" );
+}
+
+//-------------------------------------------------------------------------------
+// Failed call blocks requests for ESP_DOWNLOAD_BACKOFF, then doubled time
+static void testBackoff(void)
+{
+	host::HttpResource resource;
+	resource.body = pattern( 1024, 5 );
+	resource.etag = "\"v5\"";
+	host::httpServe( "http://repo/data.bin", resource );
+	host::advance( ESP_DOWNLOAD_BACKOFF_MAX );
+
+	host::httpFailNext( HTTPC_ERROR_CONNECTION_REFUSED, 2 );
+	host::httpClearLog();
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( host::httpLog().size() == 1 );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( host::httpLog().size() == 1 );
+
+	host::advance( ESP_DOWNLOAD_BACKOFF );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( host::httpLog().size() == 2 );
+	host::advance( ESP_DOWNLOAD_BACKOFF );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 0 );
+	CHECK( host::httpLog().size() == 2 );
+	host::advance( ESP_DOWNLOAD_BACKOFF );
+	CHECK( esp::downloadUpdate( "http://repo", "/data.bin" ) == 1 );
+	CHECK( readFile( "/data.bin" ) == resource.body );
+	SPIFFS.remove( "/data.bin" );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	testResume();
+	testChanged();
+	testNoValidator();
+	testBackoff();
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
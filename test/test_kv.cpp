@@ -0,0 +1,178 @@
+//-------------------------------------------------------------------------------
+// KV store: persistence, power loss during put and compaction, full index
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static uint32_t get(const char* key)
+{
+	uint32_t value = 0;
+	return ( esp::kvGet( key, &value, sizeof( value ) ) == sizeof( value ) ) ? value : 0xFFFFFFFF;
+}
+
+//-------------------------------------------------------------------------------
+static bool put(const char* key, const uint32_t value)
+{
+	return esp::kvPut( key, &value, sizeof( value ) );
+}
+
+//-------------------------------------------------------------------------------
+static size_t logSize(void)
+{
+	File f = SPIFFS.open( ESP_KV_FILE, "r" );
+	return ( f ) ? f.size() : 0;
+}
+
+//-------------------------------------------------------------------------------
+static void reset(void)
+{
+	SPIFFS.remove( ESP_KV_FILE );
+	SPIFFS.remove( ESP_KV_FILE ESP_KV_COMPACT_SUFFIX );
+	esp::kvInit();
+}
+
+//-------------------------------------------------------------------------------
+static void testBasic(void)
+{
+	reset();
+	CHECK( put( "a", 1 ) && put( "b", 2 ) && put( "a", 3 ) );
+	CHECK( get( "a" ) == 3 && get( "b" ) == 2 && get( "c" ) == 0xFFFFFFFF );
+	CHECK( esp::kvRemove( "b" ) && !esp::kvRemove( "b" ) );
+	esp::kvInit();
+	CHECK( get( "a" ) == 3 && get( "b" ) == 0xFFFFFFFF );
+
+	// value longer than buffer
+	uint8_t big[ 100 ];
+	memset( big, 0x5A, sizeof( big ) );
+	CHECK( esp::kvPut( "big", big, sizeof( big ) ) );
+	uint8_t part[ 10 ];
+	CHECK( esp::kvGet( "big", part, sizeof( part ) ) == sizeof( big ) && part[ 9 ] == 0x5A );
+
+	CHECK( !esp::kvPut( "", big, 1 ) );
+	char longKey[ ESP_KV_KEY_MAX_LEN + 2 ];
+	memset( longKey, 'k', sizeof( longKey ) - 1 );
+	longKey[ sizeof( longKey ) - 1 ] = '\0';
+	CHECK( !esp::kvPut( longKey, big, 1 ) );
+}
+
+//-------------------------------------------------------------------------------
+// Put is cut after every byte, old value after reboot, store works after power is back
+static void testPowerLoss(void)
+{
+	reset();
+	CHECK( put( "counter", 1 ) && put( "other", 7 ) );
+	host::fsResetStats();
+	CHECK( put( "counter", 2 ) );
+	const uint64_t record = host::fsStats().bytesWritten;
+
+	for( uint64_t offset = 0; offset < record; offset++ ){
+		host::fsFailAfter( offset );
+		CHECK( !put( "counter", 3 ) );
+		host::fsFailAfter( -1 );
+		esp::kvInit();
+		CHECK( get( "counter" ) == 2 && get( "other" ) == 7 );
+	}
+	CHECK( put( "counter", 4 ) );
+	esp::kvInit();
+	CHECK( get( "counter" ) == 4 && get( "other" ) == 7 && esp::kvStats.dropped == 0 );
+}
+
+//-------------------------------------------------------------------------------
+// Broken tail can not be compacted while FS fails: no recursion, reads work, writes are refused
+static void testBrokenTail(void)
+{
+	reset();
+	CHECK( put( "x", 10 ) && put( "y", 20 ) );
+	host::fsFailAfter( 3 );
+	CHECK( !put( "x", 11 ) );
+	host::fsFailAfter( 0 );
+
+	const uint32_t compactions = esp::kvStats.compactions;
+	esp::kvInit();
+	CHECK( get( "x" ) == 10 && get( "y" ) == 20 );
+	CHECK( !put( "y", 21 ) && !esp::kvRemove( "x" ) );
+	CHECK( esp::kvStats.compactions == compactions );
+
+	host::fsFailAfter( -1 );
+	CHECK( put( "y", 22 ) );
+	CHECK( esp::kvStats.compactions == compactions + 1 );
+	esp::kvInit();
+	CHECK( get( "x" ) == 10 && get( "y" ) == 22 );
+
+	// interrupted compaction: old log is kept
+	host::fsFailAfter( 5 );
+	CHECK( !esp::kvCompact() );
+	host::fsFailAfter( -1 );
+	CHECK( get( "x" ) == 10 && get( "y" ) == 22 );
+	esp::kvInit();
+	CHECK( get( "x" ) == 10 && get( "y" ) == 22 );
+}
+
+//-------------------------------------------------------------------------------
+// Log written with bigger index: keys over ESP_KV_INDEX_SIZE are counted, log is not compacted
+static void testIndexFull(void)
+{
+	reset();
+	const uint16_t keys = ESP_KV_INDEX_SIZE + 6;
+	File f = SPIFFS.open( ESP_KV_FILE, "w" );
+	for( uint16_t i = 0; i < keys; i++ ){
+		char key[ 8 ];
+		uint32_t value = i;
+		snprintf( key, sizeof( key ), "k%u", i );
+		// keyLen, flags, length, crc of header before crc + key + value
+		uint8_t header[ 8 ] = { (uint8_t)strlen( key ), 0, sizeof( value ), 0 };
+		uint32_t crc = esp::crc32( (const uint8_t*)&value, sizeof( value ), esp::crc32( (const uint8_t*)key, strlen( key ), esp::crc32( header, 4 ) ) );
+		memcpy( header + 4, &crc, sizeof( crc ) );
+		f.write( header, sizeof( header ) );
+		f.write( (const uint8_t*)key, strlen( key ) );
+		f.write( (const uint8_t*)&value, sizeof( value ) );
+	}
+	f.close();
+	const size_t size = logSize();
+
+	esp::kvInit();
+	CHECK( esp::kvStats.dropped == keys - ESP_KV_INDEX_SIZE );
+	CHECK( get( "k0" ) == 0 && get( "k63" ) == 63 && get( "k69" ) == 0xFFFFFFFF );
+	CHECK( !esp::kvCompact() && logSize() == size );
+	CHECK( put( "k1", 100 ) && get( "k1" ) == 100 );
+	CHECK( !put( "new", 1 ) );
+	reset();
+}
+
+//-------------------------------------------------------------------------------
+static void testCompaction(void)
+{
+	reset();
+	for( uint32_t i = 0; i < 32; i++ ){
+		char key[ 8 ];
+		snprintf( key, sizeof( key ), "p%lu", (unsigned long)i );
+		put( key, i );
+	}
+	const uint32_t compactions = esp::kvStats.compactions;
+	for( uint32_t i = 0; i < 2000; i++ ) CHECK( put( "counter", i ) );
+	CHECK( esp::kvStats.compactions > compactions );
+	CHECK( logSize() <= ESP_KV_COMPACT_SIZE + 64 );
+	esp::kvInit();
+	CHECK( get( "counter" ) == 1999 && get( "p0" ) == 0 && get( "p31" ) == 31 );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	testBasic();
+	testPowerLoss();
+	testBrokenTail();
+	testIndexFull();
+	testCompaction();
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+//-------------------------------------------------------------------------------
+// Update manifest: parsing, garbled values, signature (built also with ESP_UPDATE_PUBLIC_KEY),
+// hash check before downloadUpdate and updateFromFS commit anything
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+#include <mbedtls/sha256.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+// private key seed of ESP_UPDATE_PUBLIC_KEY in CMakeLists.txt: 01 02 ... 20
+static uint8_t seed[ 32 ];
+
+//-------------------------------------------------------------------------------
+static std::string pattern(const size_t size, const uint32_t seed)
+{
+	std::string res( size, '\0' );
+	uint32_t x = seed * 2654435761u + 1;
+	for( size_t i = 0; i < size; i++ ){
+		x = x * 1103515245 + 12345;
+		res[ i ] = x >> 16;
+	}
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static std::string sha256Hex(const std::string &data)
+{
+	mbedtls_sha256_context ctx;
+	uint8_t hash[ 32 ];
+	mbedtls_sha256_init( &ctx );
+	mbedtls_sha256_starts( &ctx, 0 );
+	mbedtls_sha256_update( &ctx, (const unsigned char*)data.data(), data.size() );
+	mbedtls_sha256_finish( &ctx, hash );
+	char hex[ 65 ];
+	for( int i = 0; i < 32; i++ ) snprintf( hex + i * 2, 3, "%02x", hash[ i ] );
+	return hex;
+}
+
+//-------------------------------------------------------------------------------
+// Signed with test key if library requires signature
+static std::string sign(const std::string &body)
+{
+#ifdef ESP_UPDATE_PUBLIC_KEY
+	return body + "sig=" + host::ed25519Sign( seed, body ) + "\n";
+#else
+	return body;
+#endif
+}
+
+//-------------------------------------------------------------------------------
+static bool parse(const std::string &text, esp::UpdateManifest &manifest)
+{
+	std::vector<char> buff( text.begin(), text.end() );
+	buff.push_back( '\0' );
+	return esp::parseUpdateManifest( buff.data(), manifest );
+}
+
+//-------------------------------------------------------------------------------
+static void testParse(const std::string &image)
+{
+	esp::UpdateManifest manifest;
+	std::string hash = sha256Hex( image );
+	CHECK( parse( sign( "version=42\nsize=" + std::to_string( image.size() ) + "\nsha256=" + hash + "\nbase=41\n" ), manifest ) );
+	CHECK( manifest.valid && manifest.version == 42 && manifest.size == image.size() );
+	CHECK( manifest.hasSha256 && sha256Hex( image ) == hash && manifest.hasBase && manifest.base == 41 );
+	uint8_t raw[ 32 ];
+	for( int i = 0; i < 32; i++ ) raw[ i ] = strtoul( hash.substr( i * 2, 2 ).c_str(), nullptr, 16 );
+	CHECK( memcmp( raw, manifest.sha256, 32 ) == 0 );
+
+	// CRLF, unknown keys
+	CHECK( parse( sign( "version=7\r\nchannel=beta\r\nsha256=" + hash + "\r\n" ), manifest ) && manifest.version == 7 && !manifest.hasBase );
+
+	// garbled values
+	CHECK( !parse( sign( "version=12a\nsha256=" + hash + "\n" ), manifest ) && !manifest.valid );
+	CHECK( !parse( sign( "version=99999999999\nsha256=" + hash + "\n" ), manifest ) );
+	CHECK( !parse( sign( "version=0\nsha256=" + hash + "\n" ), manifest ) );
+	CHECK( !parse( sign( "size=100\nsha256=" + hash + "\n" ), manifest ) );
+	CHECK( !parse( sign( "version=3\nsize=-1\nsha256=" + hash + "\n" ), manifest ) );
+	CHECK( !parse( sign( "version=3\nsha256=" + hash.substr( 0, 62 ) + "\n" ), manifest ) );
+	CHECK( !parse( sign( "version=3\nsha256=" + hash + "00\n" ), manifest ) );
+	CHECK( !parse( sign( "version=3\nbroken line\nsha256=" + hash + "\n" ), manifest ) );
+
+#ifdef ESP_UPDATE_PUBLIC_KEY
+	// legacy and unsigned manifests are refused
+	CHECK( !parse( "42\n", manifest ) );
+	CHECK( !parse( "version=42\nsha256=" + hash + "\n", manifest ) );
+	CHECK( !parse( sign( "version=42\n" ), manifest ) );
+	std::string signedText = sign( "version=42\nsha256=" + hash + "\n" );
+	CHECK( parse( signedText, manifest ) );
+	std::string tampered = signedText;
+	tampered[ 9 ] = '3';
+	CHECK( !parse( tampered, manifest ) );
+	tampered = signedText;
+	tampered[ tampered.size() - 2 ] ^= 1;
+	CHECK( !parse( tampered, manifest ) );
+#else
+	// legacy format: only version number
+	CHECK( parse( "42\r\n", manifest ) && manifest.version == 42 && !manifest.hasSha256 );
+	CHECK( !parse( "0", manifest ) );
+	CHECK( !parse( "<html>404</html>", manifest ) );
+	CHECK( !parse( "", manifest ) );
+#endif
+}
+
+//-------------------------------------------------------------------------------
+static void testCheckingUpdate(const std::string &image)
+{
+	host::HttpResource version;
+	version.body = sign( "version=43\nsha256=" + sha256Hex( image ) + "\n" );
+	host::httpServe( "http://repo/version", version );
+	CHECK( esp::checkingUpdate( "http://repo", 42 ) == 43 );
+	CHECK( esp::updateManifest.valid && SPIFFS.exists( "/firmware.manifest" ) );
+
+	version.body = "version=4x3\n";
+	host::httpServe( "http://repo/version", version );
+	CHECK( esp::checkingUpdate( "http://repo", 42 ) == 0 );
+	CHECK( !esp::updateManifest.valid && !SPIFFS.exists( "/firmware.manifest" ) );
+}
+
+//-------------------------------------------------------------------------------
+// Image not matching manifest is neither renamed to /firmware.bin nor flashed
+static void testHashCheck(const std::string &image)
+{
+	host::HttpResource version;
+	version.body = sign( "version=44\nsize=" + std::to_string( image.size() ) + "\nsha256=" + sha256Hex( image ) + "\n" );
+	host::httpServe( "http://repo/version", version );
+	CHECK( esp::checkingUpdate( "http://repo", 43 ) == 44 );
+
+	host::HttpResource firmware;
+	firmware.body = image;
+	firmware.body[ 1000 ] ^= 0x55;
+	host::httpServe( "http://repo/firmware.bin", firmware );
+	CHECK( esp::downloadUpdate( "http://repo", "/firmware.bin" ) == 0 );
+	CHECK( !SPIFFS.exists( "/firmware.bin" ) && !SPIFFS.exists( "/firmware.bin.part" ) );
+
+	firmware.body = image;
+	host::httpServe( "http://repo/firmware.bin", firmware );
+	host::advance( ESP_DOWNLOAD_BACKOFF_MAX );
+	CHECK( esp::downloadUpdate( "http://repo", "/firmware.bin" ) == 1 );
+	CHECK( SPIFFS.exists( "/firmware.bin" ) );
+
+	// manifest is loaded again after reboot
+	memset( &esp::updateManifest, 0, sizeof( esp::UpdateManifest ) );
+	Update.committed = false;
+	CHECK( esp::updateFromFS() == 1 );
+	CHECK( Update.committed && Update.image.size() == image.size() );
+
+	// file changed on FS
+	File f = SPIFFS.open( "/firmware.bin", "w" );
+	f.write( (const uint8_t*)image.data(), image.size() - 1 );
+	f.write( (uint8_t)0 );
+	f.close();
+	Update.committed = false;
+	Update.image.clear();
+	CHECK( esp::updateFromFS() == 0 );
+	CHECK( !Update.committed && Update.image.empty() );
+	SPIFFS.remove( "/firmware.bin" );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	for( int i = 0; i < 32; i++ ) seed[ i ] = i + 1;
+	host::fsClear();
+	esp::init( "test" );
+
+	const std::string image = pattern( 64 * 1024, 9 );
+	testParse( image );
+	testCheckingUpdate( image );
+	testHashCheck( image );
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
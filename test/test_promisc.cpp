@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------------
+// Promiscuous ring: sniffer without configuration window, producer/consumer stress
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+#include <atomic>
+#include <thread>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+// data frame of 24 bytes header, sequence number is stored behind it
+static const size_t FRAME_LEN = 32;
+static const size_t SEQ_OFFSET = sizeof( wifi_pkt_rx_ctrl_t ) + 24;
+
+//-------------------------------------------------------------------------------
+static void feed(const uint32_t seq)
+{
+	uint8_t frame[ FRAME_LEN ] = { 0x08, 0x00 };
+	memcpy( frame + 24, &seq, sizeof( seq ) );
+	host::promiscFeed( frame, sizeof( frame ), -60, WIFI_PKT_DATA );
+}
+
+static uint32_t received = 0;
+static uint32_t next = 0;
+static bool ordered = true;
+static bool intact = true;
+
+//-------------------------------------------------------------------------------
+// Consumer of stress test, sequence numbers only grow (dropped frames make gaps)
+static void receive(const esp::PromiscFrame &raw)
+{
+	uint32_t seq;
+	memcpy( &seq, raw.data + SEQ_OFFSET, sizeof( seq ) );
+	if( seq < next ) ordered = false;
+	if( raw.size != sizeof( wifi_pkt_rx_ctrl_t ) + FRAME_LEN + 4 || raw.data[ sizeof( wifi_pkt_rx_ctrl_t ) ] != 0x08 ) intact = false;
+	next = seq + 1;
+	received++;
+}
+
+//-------------------------------------------------------------------------------
+// Documented sniffer: default callback + esp::promiscDrain( esp::aggregateFrame ) must not restart
+static void testSniffer(void)
+{
+	const uint32_t restarts = host::restarts();
+	for( uint32_t i = 0; i < READ_RAW_PACKETS_BEFORE_START * 10; i++ ){
+		feed( i );
+		esp::promiscDrain( esp::aggregateFrame );
+		esp::handle();
+	}
+	CHECK( host::restarts() == restarts );
+	CHECK( host::promiscEnabled() );
+}
+
+//-------------------------------------------------------------------------------
+// Driver thread pushes while loop() drains: frames come in order, none is lost or repeated
+static void testStress(void)
+{
+	const uint32_t total = 1000000;
+	esp::promiscDrain( nullptr );
+	const esp::PromiscStats before = esp::promiscStats;
+
+	std::atomic<bool> done( false );
+	std::thread producer( [ & ](){
+		for( uint32_t i = 0; i < total; i++ ){
+			feed( i );
+			// bursts of frames (consumer gets CPU on single core hosts too), then flood to fill ring
+			if( i < total / 2 && ( i & 7 ) == 7 ) std::this_thread::yield();
+		}
+		done = true;
+	} );
+
+	while( !done ){
+		if( esp::promiscDrain( receive ) == 0 ) std::this_thread::yield();
+	}
+	producer.join();
+	esp::promiscDrain( receive );
+
+	uint32_t captured = esp::promiscStats.captured - before.captured;
+	uint32_t dropped = esp::promiscStats.dropped - before.dropped;
+	printf( "stress: %u frames, %u received, %u dropped\n", total, received, dropped );
+	CHECK( ordered && intact );
+	CHECK( received == captured );
+	CHECK( captured + dropped == total );
+	CHECK( received > 0 && next <= total );
+	CHECK( esp::promiscAvailable() == 0 );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+	esp::enablePromiscMode();
+
+	testSniffer();
+	testStress();
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
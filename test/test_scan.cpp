@@ -0,0 +1,54 @@
+//-------------------------------------------------------------------------------
+// Async Wi-Fi scan: results are collected by readers when esp::handle() is not called
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static void testGetter(void)
+{
+	host::wifiNetworks( {
+		{ "home", "secret", { 0x10, 0, 0, 0, 0, 1 }, 6, -55, WIFI_AUTH_WPA2_PSK },
+		{ "guest", "", { 0x10, 0, 0, 0, 0, 3 }, 1, -80, WIFI_AUTH_OPEN },
+	} );
+	CHECK( esp::startWiFiScan() );
+	CHECK( esp::getCountNetworks() == 0 );
+	host::advance( 5000 );
+	CHECK( esp::getCountNetworks() == 2 );
+	CHECK( esp::scanCount == 2 && esp::scanTime != 0 );
+}
+
+//-------------------------------------------------------------------------------
+static void testEndpoint(WebServer &server)
+{
+	const HostParams auth = { { "Authorization", "admin:admin" } };
+	host::wifiNetworks( {
+		{ "office", "secret2", { 0x10, 0, 0, 0, 0, 2 }, 11, -70, WIFI_AUTH_WPA2_PSK },
+	} );
+	HostResponse res = server.request( "/wifi", HTTP_GET, { { "cmd", "scan" }, { "refresh", "1" } }, auth );
+	CHECK( res.code == 200 && res.body.find( "\"running\":true" ) != std::string::npos );
+	host::advance( 5000 );
+	res = server.request( "/wifi", HTTP_GET, { { "cmd", "scan" } }, auth );
+	CHECK( res.code == 200 && res.body.find( "\"running\":false" ) != std::string::npos );
+	CHECK( res.body.find( "\"office\"" ) != std::string::npos && res.body.find( "\"found\":1" ) != std::string::npos );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	host::wifiTimes( 2000, 100 );
+	esp::init( "test" );
+	WebServer server;
+	esp::addWebServerPages( &server );
+
+	testGetter();
+	testEndpoint( server );
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+//-------------------------------------------------------------------------------
+// saveSettings / loadSettings: power loss at every byte offset of a save, files of previous versions
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static std::vector<uint8_t> pattern(const size_t size, const uint32_t seed)
+{
+	std::vector<uint8_t> res( size );
+	uint32_t x = seed * 2654435761u + 1;
+	for( size_t i = 0; i < size; i++ ){
+		x = x * 1103515245 + 12345;
+		res[ i ] = x >> 16;
+	}
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+// After reboot, KV index is built again
+static std::vector<uint8_t> load(const size_t size, const char* file)
+{
+	esp::kvInit();
+	std::vector<uint8_t> res( size, 0xEE );
+	uint32_t len = esp::loadSettings( res.data(), res.size(), file );
+	if( len != size ) res.clear();
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+// Both slots written (old and current), save of next is cut after every byte,
+// load after "reboot" must return current or complete next
+static void testPowerLoss(const char* file, const size_t size)
+{
+	const std::vector<uint8_t> old = pattern( size, 1 );
+	const std::vector<uint8_t> current = pattern( size, 2 );
+	const std::vector<uint8_t> next = pattern( size, 3 );
+
+	esp::removeSettings( file );
+	esp::saveSettings( old.data(), old.size(), file );
+	esp::kvCompact();
+	host::fsResetStats();
+	esp::saveSettings( current.data(), current.size(), file );
+	const uint64_t record = host::fsStats().bytesWritten;
+	CHECK( record >= size );
+
+	uint32_t nextLoaded = 0;
+	for( uint64_t offset = 0; offset <= record; offset++ ){
+		esp::removeSettings( file );
+		esp::saveSettings( old.data(), old.size(), file );
+		esp::saveSettings( current.data(), current.size(), file );
+
+		host::fsFailAfter( offset );
+		esp::saveSettings( next.data(), next.size(), file );
+		host::fsFailAfter( -1 );
+
+		std::vector<uint8_t> loaded = load( size, file );
+		bool ok = loaded == current || loaded == next;
+		if( !ok ) printf( "FAIL power loss at byte %lu of %lu\n", (unsigned long)offset, (unsigned long)record );
+		CHECK( ok );
+		if( loaded == next ) nextLoaded++;
+	}
+	// only the last offset has all bytes written
+	CHECK( nextLoaded == 1 );
+
+	// store keeps working after power loss
+	esp::saveSettings( next.data(), next.size(), file );
+	CHECK( load( size, file ) == next );
+	esp::saveSettings( old.data(), old.size(), file );
+	CHECK( load( size, file ) == old );
+}
+
+//-------------------------------------------------------------------------------
+// Power loss during first save: nothing is loaded
+static void testFirstSave(const char* file, const size_t size)
+{
+	const std::vector<uint8_t> data = pattern( size, 4 );
+	for( uint64_t offset = 0; offset < size; offset++ ){
+		esp::removeSettings( file );
+		host::fsFailAfter( offset );
+		esp::saveSettings( data.data(), data.size(), file );
+		host::fsFailAfter( -1 );
+		CHECK( load( size, file ).empty() );
+	}
+}
+
+//-------------------------------------------------------------------------------
+// File of library version before record slots (raw struct without header)
+static void testLegacy(const char* file, const size_t size)
+{
+	const std::vector<uint8_t> legacy = pattern( size, 5 );
+	const std::vector<uint8_t> data = pattern( size, 6 );
+	esp::removeSettings( file );
+
+	File f = SPIFFS.open( file, "w" );
+	f.write( legacy.data(), legacy.size() - 1 );
+	f.close();
+	CHECK( load( size, file ).empty() );
+
+	f = SPIFFS.open( file, "w" );
+	f.write( legacy.data(), legacy.size() );
+	f.close();
+	CHECK( load( size, file ) == legacy );
+
+	// legacy file stays until KV record is complete
+	for( uint64_t offset = 0; offset < size; offset++ ){
+		host::fsFailAfter( offset );
+		esp::saveSettings( data.data(), data.size(), file );
+		host::fsFailAfter( -1 );
+		CHECK( load( size, file ) == legacy );
+	}
+	esp::saveSettings( data.data(), data.size(), file );
+	CHECK( load( size, file ) == data && !SPIFFS.exists( file ) );
+}
+
+//-------------------------------------------------------------------------------
+// Record slots <file> and <file>.1 of previous library version, newest valid one is used
+static void testSlots(const char* file, const size_t size)
+{
+	const std::vector<uint8_t> older = pattern( size, 7 );
+	const std::vector<uint8_t> newer = pattern( size, 8 );
+	const std::vector<uint8_t> data = pattern( size, 9 );
+	esp::removeSettings( file );
+
+	auto writeSlot = [ & ](const std::string &path, const std::vector<uint8_t> &value, const uint32_t sequence, const bool broken){
+		// magic, schema, reserved, length, sequence, crc of header before crc + data
+		uint32_t header[ 5 ] = { ESP_SETTINGS_MAGIC, ESP_SETTINGS_SCHEMA, (uint32_t)value.size(), sequence, 0 };
+		header[ 4 ] = esp::crc32( value.data(), value.size(), esp::crc32( (const uint8_t*)header, 16 ) );
+		if( broken ) header[ 4 ]++;
+		File f = SPIFFS.open( path.c_str(), "w" );
+		f.write( (const uint8_t*)header, sizeof( header ) );
+		f.write( value.data(), value.size() );
+		f.close();
+	};
+	const std::string slot1 = std::string( file ) + ESP_SETTINGS_SLOT_SUFFIX;
+	writeSlot( file, older, 7, false );
+	writeSlot( slot1, newer, 8, false );
+	CHECK( load( size, file ) == newer );
+	writeSlot( slot1, newer, 8, true );
+	CHECK( load( size, file ) == older );
+
+	esp::saveSettings( data.data(), data.size(), file );
+	CHECK( load( size, file ) == data && !SPIFFS.exists( file ) && !SPIFFS.exists( slot1.c_str() ) );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	testPowerLoss( "/test.dat", 256 );
+	testPowerLoss( "/test.dat", 1 );
+	testFirstSave( "/test.dat", 64 );
+	testLegacy( "/test.dat", 64 );
+	testSlots( "/test.dat", 64 );
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+//-------------------------------------------------------------------------------
+// downloadAndFlash: optional firmware.md5, partial images are aborted
+//-------------------------------------------------------------------------------
+#include "esp_functions.h"
+#include "host.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if( !( cond ) ){ printf( "FAIL %s:%d %s\n", __FILE__, __LINE__, #cond ); failures++; } }while( 0 )
+
+//-------------------------------------------------------------------------------
+static std::string pattern(const size_t size, const uint32_t seed)
+{
+	std::string res( size, '\0' );
+	uint32_t x = seed * 2654435761u + 1;
+	for( size_t i = 0; i < size; i++ ){
+		x = x * 1103515245 + 12345;
+		res[ i ] = x >> 16;
+	}
+	return res;
+}
+
+//-------------------------------------------------------------------------------
+static void serve(const char* url, const std::string &body, const uint32_t dropMax = 0)
+{
+	host::HttpResource resource;
+	resource.body = body;
+	resource.dropMax = dropMax;
+	host::httpServe( url, resource );
+}
+
+//-------------------------------------------------------------------------------
+static bool requested(const char* url)
+{
+	for( const host::HttpRequest &request : host::httpLog() ){
+		if( request.url == url ) return true;
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------------
+static void testFlash(const std::string &image)
+{
+	// firmware.md5 not published
+	host::httpClear();
+	serve( "http://repo/firmware.bin", image );
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 1 );
+	CHECK( Update.committed && Update.image.size() == image.size() );
+
+	// published and wrong
+	serve( "http://repo/firmware.md5", "0123456789abcdef0123456789abcdef" );
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 0 );
+	CHECK( !Update.committed && Update.getError() == UPDATE_ERROR_MD5 );
+}
+
+//-------------------------------------------------------------------------------
+// Failed request of firmware.md5 is not taken as "not published"
+static void testMd5Errors(const std::string &image)
+{
+	host::httpClear();
+	serve( "http://repo/firmware.bin", image );
+
+	host::httpFailNext( HTTPC_ERROR_CONNECTION_LOST );
+	host::httpClearLog();
+	Update.committed = false;
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 0 );
+	CHECK( !requested( "http://repo/firmware.bin" ) && !Update.committed );
+
+	host::HttpResource error;
+	error.code = HTTP_CODE_INTERNAL_SERVER_ERROR;
+	host::httpServe( "http://repo/firmware.md5", error );
+	host::httpClearLog();
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 0 );
+	CHECK( !requested( "http://repo/firmware.bin" ) && !Update.committed );
+
+	// truncated
+	serve( "http://repo/firmware.md5", "0123456789abcdef" );
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 0 );
+	CHECK( !Update.committed );
+}
+
+//-------------------------------------------------------------------------------
+static void testPartial(const std::string &image)
+{
+	host::httpClear();
+	serve( "http://repo/firmware.bin", image, 4096 );
+	CHECK( esp::downloadAndFlash( "http://repo" ) == 0 );
+	CHECK( Update.aborted && !Update.committed && !Update.isRunning() );
+}
+
+//-------------------------------------------------------------------------------
+int main(void)
+{
+	host::fsClear();
+	esp::init( "test" );
+
+	const std::string image = pattern( 100 * 1024, 1 );
+	testFlash( image );
+	testMd5Errors( image );
+	testPartial( image );
+
+	if( failures ) printf( "%d failures\n", failures );
+	return ( failures ) ? 1 : 0;
+}